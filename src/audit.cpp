@@ -0,0 +1,215 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QDebug>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "auditlog.h"
+
+// Offline reader for gert-clickd audit logs: summarizes or dumps the records
+// of one or more (rotated) log files, optionally filtered. Files are mapped
+// and scanned in place, so millions of records take well under a second.
+
+struct LogFile {
+    std::unique_ptr<QFile> file;
+    AuditFileHeader header;
+    const AuditRecord *records = nullptr;
+    qint64 count = 0;
+};
+
+struct Filter {
+    int source = -1;
+    int action = -1;
+    qint64 job = -1;
+    qint64 fromNs = 0;           // Unix time; 0 for no bound
+    qint64 toNs = 0;
+
+    bool matches(const AuditRecord &record, qint64 wallNs) const
+    {
+        return (source < 0 || record.source == source) &&
+               (action < 0 || record.action == action) &&
+               (job < 0 || record.job == quint64(job)) &&
+               (!fromNs || wallNs >= fromNs) &&
+               (!toNs || wallNs < toNs);
+    }
+};
+
+static bool mapFile(const QString &path, LogFile *log)
+{
+    log->file.reset(new QFile(path));
+    if (!log->file->open(QIODevice::ReadOnly) || log->file->size() < qint64(sizeof(AuditFileHeader))) return false;
+
+    const uchar *data = log->file->map(0, log->file->size());
+    if (!data) return false;
+
+    std::memcpy(&log->header, data, sizeof(AuditFileHeader));
+    if (std::memcmp(log->header.magic, "GAL1", 4) != 0 || log->header.recordSize != sizeof(AuditRecord)) return false;
+
+    // A file still being written may end in a partial record
+    log->records = reinterpret_cast<const AuditRecord *>(data + sizeof(AuditFileHeader));
+    log->count = (log->file->size() - qint64(sizeof(AuditFileHeader))) / qint64(sizeof(AuditRecord));
+    return true;
+}
+
+static int lookupName(const QString &name, const char *(*nameOf)(quint8))
+{
+    for (int i = 0; i < 256; ++i) {
+        if (name == QLatin1String(nameOf(quint8(i)))) return i;
+    }
+    return -1;
+}
+
+static bool parseTime(const QString &text, qint64 *ns)
+{
+    if (text.isEmpty()) return true;
+    const QDateTime time = QDateTime::fromString(text, Qt::ISODate);
+    if (!time.isValid()) return false;
+    *ns = time.toMSecsSinceEpoch() * 1000000LL;
+    return true;
+}
+
+static QString formatWall(qint64 wallNs)
+{
+    return QDateTime::fromMSecsSinceEpoch(wallNs / 1000000, Qt::UTC).toString(Qt::ISODateWithMs);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("gert-audit");
+    app.setApplicationVersion("1.0.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Summarize or dump gert-clickd audit logs");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addPositionalArgument("files", "Audit log files, e.g. clicks.log clicks.log.1; order does not matter.");
+
+    const QCommandLineOption jobOption("job", "Only records of this job id (scheduler job, farm display or shard index).", "id");
+    const QCommandLineOption sourceOption("source", "Only records from rapid, interval, job, shard, farm, feed, trigger or other.", "source");
+    const QCommandLineOption actionOption("action", "Only click, press, release, keys or overflow records.", "action");
+    const QCommandLineOption fromOption("from", "Only records at or after this ISO 8601 time.", "time");
+    const QCommandLineOption toOption("to", "Only records before this ISO 8601 time.", "time");
+    const QCommandLineOption dumpOption("dump", "Print matching records as CSV instead of a summary.");
+    parser.addOptions({ jobOption, sourceOption, actionOption, fromOption, toOption, dumpOption });
+    parser.process(app);
+
+    Filter filter;
+    bool okJob = true;
+    if (parser.isSet(jobOption)) filter.job = parser.value(jobOption).toLongLong(&okJob);
+    if (parser.isSet(sourceOption)) filter.source = lookupName(parser.value(sourceOption), AuditLog::sourceName);
+    if (parser.isSet(actionOption)) filter.action = lookupName(parser.value(actionOption), AuditLog::actionName);
+    if (!okJob || (parser.isSet(sourceOption) && filter.source < 0) || (parser.isSet(actionOption) && filter.action < 0) ||
+        !parseTime(parser.value(fromOption), &filter.fromNs) || !parseTime(parser.value(toOption), &filter.toNs)) {
+        qCritical() << "gert-audit: invalid filter";
+        return 1;
+    }
+
+    const QStringList paths = parser.positionalArguments();
+    if (paths.isEmpty()) parser.showHelp(1);
+
+    std::vector<LogFile> logs(paths.size());
+    for (int i = 0; i < paths.size(); ++i) {
+        if (!mapFile(paths[i], &logs[i])) {
+            qCritical() << "gert-audit: not an audit log" << paths[i];
+            return 1;
+        }
+    }
+
+    // Oldest first: each file's header is written when it is opened
+    std::sort(logs.begin(), logs.end(), [](const LogFile &a, const LogFile &b) {
+        if (a.header.realtimeBaseNs != b.header.realtimeBaseNs) return a.header.realtimeBaseNs < b.header.realtimeBaseNs;
+        return a.header.sequence < b.header.sequence;
+    });
+
+    QElapsedTimer timer;
+    timer.start();
+
+    const bool dump = parser.isSet(dumpOption);
+    if (dump) std::printf("unix_time,monotonic_ns,source,job,action,button,x,y\n");
+
+    quint64 total = 0, matched = 0, lost = 0, overflows = 0;
+    quint64 actions[256] = {};
+    QHash<quint64, quint64> perJob; // source << 32 | job
+    std::vector<qint64> times; // The writer drains ring by ring, so file order is not time order
+
+    for (const LogFile &log : logs) {
+        const qint64 offset = log.header.realtimeBaseNs - qint64(log.header.monotonicBaseNs);
+        for (qint64 i = 0; i < log.count; ++i) {
+            const AuditRecord &record = log.records[i];
+            const qint64 wallNs = qint64(record.timeNs) + offset;
+            ++total;
+            if (!filter.matches(record, wallNs)) continue;
+
+            ++matched;
+            ++actions[record.action];
+            if (record.action == AuditLog::Overflow) {
+                ++overflows;
+                lost += record.job;
+            } else {
+                ++perJob[(quint64(record.source) << 32) | record.job];
+            }
+
+            if (!dump) times.push_back(wallNs);
+
+            if (dump) {
+                std::printf("%lld.%09lld,%llu,%s,%u,%s,%u,%d,%d\n",
+                            static_cast<long long>(wallNs / 1000000000LL), static_cast<long long>(wallNs % 1000000000LL),
+                            static_cast<unsigned long long>(record.timeNs), AuditLog::sourceName(record.source),
+                            record.job, AuditLog::actionName(record.action), record.button, record.x, record.y);
+            }
+        }
+    }
+
+    if (dump) return 0;
+
+    std::sort(times.begin(), times.end());
+    const qint64 firstNs = times.empty() ? 0 : times.front();
+    const qint64 lastNs = times.empty() ? 0 : times.back();
+    qint64 maxGapNs = 0;
+    for (size_t i = 1; i < times.size(); ++i) {
+        maxGapNs = qMax(maxGapNs, times[i] - times[i - 1]);
+    }
+
+    const double seconds = (lastNs - firstNs) / 1e9;
+    std::printf("%d file(s), %llu records, %llu matching, scanned in %.1f ms\n",
+                int(logs.size()), static_cast<unsigned long long>(total), static_cast<unsigned long long>(matched),
+                timer.nsecsElapsed() / 1e6);
+    if (!matched) return 0;
+
+    std::printf("from %s to %s (%.3f s), %.1f records/s, longest gap %.3f ms\n",
+                qPrintable(formatWall(firstNs)), qPrintable(formatWall(lastNs)), seconds,
+                seconds > 0 ? matched / seconds : 0.0, maxGapNs / 1e6);
+
+    for (int action = 0; action < 256; ++action) {
+        if (actions[action] && action != AuditLog::Overflow) {
+            std::printf("%-10s %12llu\n", AuditLog::actionName(quint8(action)), static_cast<unsigned long long>(actions[action]));
+        }
+    }
+    if (overflows) {
+        std::printf("overflow   %12llu gaps, %llu records lost\n",
+                    static_cast<unsigned long long>(overflows), static_cast<unsigned long long>(lost));
+    }
+
+    // Busiest sources and jobs first
+    std::vector<std::pair<quint64, quint64>> jobs;
+    for (auto it = perJob.constBegin(); it != perJob.constEnd(); ++it) {
+        jobs.emplace_back(it.key(), it.value());
+    }
+    std::sort(jobs.begin(), jobs.end(), [](const std::pair<quint64, quint64> &a, const std::pair<quint64, quint64> &b) {
+        return a.second > b.second;
+    });
+    std::printf("%-10s %10s %12s %10s\n", "source", "job", "records", "rate/s");
+    for (const auto &entry : jobs) {
+        std::printf("%-10s %10u %12llu %10.1f\n", AuditLog::sourceName(quint8(entry.first >> 32)),
+                    quint32(entry.first), static_cast<unsigned long long>(entry.second),
+                    seconds > 0 ? entry.second / seconds : 0.0);
+    }
+    return 0;
+}
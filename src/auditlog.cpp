@@ -0,0 +1,328 @@
+#include "auditlog.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+std::atomic<bool> AuditLog::enabled(false);
+thread_local AuditLog::Source AuditLog::threadSource = AuditLog::Other;
+thread_local quint32 AuditLog::threadJob = 0;
+
+static qint64 nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+namespace {
+
+// Single producer (the owning thread), single consumer (the writer)
+struct AuditRing {
+    enum { Capacity = 1 << 15 }; // 768 KB; over six seconds at 5,000 CPS
+
+    std::atomic<quint64> head{0};
+    char pad0[56];
+    std::atomic<quint64> tail{0};
+    std::atomic<quint64> dropped{0};
+    char pad1[48];
+
+    std::atomic<bool> owned{false};
+    AuditRecord records[Capacity];
+};
+
+struct AuditWriter {
+    QMutex mutex; // Guards rings
+    std::vector<std::unique_ptr<AuditRing>> rings;
+
+    QMutex wakeMutex;
+    QWaitCondition wake;
+    std::thread thread;
+    std::atomic<bool> running{false};
+
+    // Writer thread only
+    QFile file;
+    QString path;
+    qint64 rotateBytes = 0;
+    int keepFiles = 0;
+    qint64 fileBytes = 0;
+    quint64 sequence = 0;
+    std::vector<AuditRecord> buffer;
+    qint64 lastWriteNs = 0;
+
+    std::atomic<quint64> written{0};
+    std::atomic<quint64> dropped{0};
+};
+
+AuditWriter &writer()
+{
+    static AuditWriter instance;
+    return instance;
+}
+
+struct RingHolder {
+    AuditRing *ring = nullptr;
+
+    ~RingHolder()
+    {
+        if (ring) ring->owned.store(false, std::memory_order_release);
+    }
+};
+
+thread_local RingHolder threadRing;
+
+AuditRing *acquireRing()
+{
+    if (threadRing.ring) return threadRing.ring;
+
+    AuditWriter &log = writer();
+    QMutexLocker locker(&log.mutex);
+    for (const auto &candidate : log.rings) {
+        bool expected = false;
+        if (candidate->owned.compare_exchange_strong(expected, true)) {
+            threadRing.ring = candidate.get();
+            return threadRing.ring;
+        }
+    }
+    log.rings.emplace_back(new AuditRing);
+    threadRing.ring = log.rings.back().get();
+    threadRing.ring->owned.store(true);
+    return threadRing.ring;
+}
+
+bool openFile(AuditWriter &log)
+{
+    log.file.setFileName(log.path);
+    if (!log.file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered)) return false;
+
+    AuditFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "GAL1", 4);
+    header.recordSize = sizeof(AuditRecord);
+    header.sequence = log.sequence++;
+    header.monotonicBaseNs = quint64(nowNs());
+    header.realtimeBaseNs = QDateTime::currentMSecsSinceEpoch() * 1000000LL;
+    header.pid = quint32(QCoreApplication::applicationPid());
+    if (log.file.write(reinterpret_cast<const char *>(&header), sizeof(header)) != qint64(sizeof(header))) {
+        log.file.close();
+        return false;
+    }
+    log.fileBytes = sizeof(header);
+    return true;
+}
+
+// path.N is dropped, path.N-1 becomes path.N, ..., path becomes path.1
+void rotate(AuditWriter &log)
+{
+    log.file.close();
+    QFile::remove(log.path + "." + QString::number(log.keepFiles));
+    for (int i = log.keepFiles - 1; i >= 1; --i) {
+        QFile::rename(log.path + "." + QString::number(i), log.path + "." + QString::number(i + 1));
+    }
+    if (log.keepFiles > 0) {
+        QFile::rename(log.path, log.path + ".1");
+    }
+    if (!openFile(log)) {
+        qWarning() << "AuditLog: cannot reopen" << log.path << "after rotation; further records are dropped";
+    }
+}
+
+void writeBuffer(AuditWriter &log)
+{
+    size_t offset = 0;
+    while (offset < log.buffer.size() && log.file.isOpen()) {
+        // Whole records up to the rotation size per write
+        const qint64 room = qMax<qint64>(1, (log.rotateBytes - log.fileBytes) / qint64(sizeof(AuditRecord)));
+        const size_t count = qMin(log.buffer.size() - offset, size_t(room));
+        const qint64 bytes = qint64(count * sizeof(AuditRecord));
+        const qint64 done = log.file.write(reinterpret_cast<const char *>(log.buffer.data() + offset), bytes);
+        if (done != bytes) {
+            // Writing on after a short write would misalign every later record
+            qWarning() << "AuditLog: write to" << log.path << "failed; further records are dropped";
+            const size_t whole = done > 0 ? size_t(done) / sizeof(AuditRecord) : 0;
+            log.written.fetch_add(whole, std::memory_order_relaxed);
+            offset += whole;
+            log.file.close();
+            break;
+        }
+        log.fileBytes += bytes;
+        log.written.fetch_add(count, std::memory_order_relaxed);
+        offset += count;
+        if (log.fileBytes >= log.rotateBytes) rotate(log);
+    }
+
+    // Whatever did not reach the file is lost; overflow records are already counted
+    quint64 lost = 0;
+    for (size_t i = offset; i < log.buffer.size(); ++i) {
+        if (log.buffer[i].action != AuditLog::Overflow) ++lost;
+    }
+    if (lost) log.dropped.fetch_add(lost, std::memory_order_relaxed);
+    log.buffer.clear();
+}
+
+// Rings are emptied every 50 ms; the file gets one write per 64K records
+// or per second, whichever comes first
+void drainRings(AuditWriter &log, bool force)
+{
+    {
+        QMutexLocker locker(&log.mutex);
+        for (const auto &ring : log.rings) {
+            const quint64 head = ring->head.load(std::memory_order_acquire);
+            quint64 tail = ring->tail.load(std::memory_order_relaxed);
+            for (; tail != head; ++tail) {
+                log.buffer.push_back(ring->records[tail & (AuditRing::Capacity - 1)]);
+            }
+            ring->tail.store(tail, std::memory_order_release);
+
+            // The gap is recorded in the log after the records that made it
+            const quint64 lost = ring->dropped.exchange(0, std::memory_order_relaxed);
+            if (lost) {
+                AuditRecord gap;
+                std::memset(&gap, 0, sizeof(gap));
+                gap.timeNs = quint64(nowNs());
+                gap.job = quint32(qMin<quint64>(lost, 0xffffffffu));
+                gap.action = AuditLog::Overflow;
+                log.buffer.push_back(gap);
+                log.dropped.fetch_add(lost, std::memory_order_relaxed);
+            }
+        }
+    }
+    const qint64 now = nowNs();
+    if (!log.buffer.empty() && (force || log.buffer.size() >= 64 * 1024 || now - log.lastWriteNs >= 1000000000LL)) {
+        writeBuffer(log);
+        log.lastWriteNs = now;
+    }
+}
+
+} // namespace
+
+bool AuditLog::open(const QString &path, qint64 rotateBytes, int keepFiles)
+{
+    AuditWriter &log = writer();
+    if (log.running.load()) return false;
+
+    log.path = path;
+    log.rotateBytes = qMax<qint64>(rotateBytes, 1 << 20);
+    log.keepFiles = qMax(0, keepFiles);
+    log.sequence = 0;
+    log.written.store(0);
+    log.dropped.store(0);
+    log.buffer.reserve(64 * 1024 + 1024);
+    log.lastWriteNs = nowNs();
+    if (!openFile(log)) return false;
+
+    // Records from an earlier session are not ours to write
+    {
+        QMutexLocker locker(&log.mutex);
+        for (const auto &ring : log.rings) {
+            ring->tail.store(ring->head.load());
+            ring->dropped.store(0);
+        }
+    }
+
+    log.running.store(true);
+    log.thread = std::thread([&log]() {
+        while (log.running.load()) {
+            {
+                QMutexLocker locker(&log.wakeMutex);
+                if (log.running.load()) log.wake.wait(&log.wakeMutex, 50);
+            }
+            drainRings(log, false);
+        }
+    });
+    enabled.store(true);
+    return true;
+}
+
+void AuditLog::close()
+{
+    AuditWriter &log = writer();
+    enabled.store(false);
+    {
+        QMutexLocker locker(&log.wakeMutex);
+        if (!log.running.exchange(false)) return;
+        log.wake.wakeAll();
+    }
+    log.thread.join();
+
+    drainRings(log, true);
+    log.file.close();
+}
+
+void AuditLog::append(Action action, const QPoint &pos, ClickType type)
+{
+    AuditRing *ring = acquireRing();
+    const quint64 head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) >= AuditRing::Capacity) {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    AuditRecord &record = ring->records[head & (AuditRing::Capacity - 1)];
+    record.timeNs = quint64(nowNs());
+    record.x = pos.x();
+    record.y = pos.y();
+    record.job = threadJob;
+    record.action = action;
+    record.button = quint8(type);
+    record.source = threadSource;
+    record.reserved = 0;
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+quint64 AuditLog::writtenCount()
+{
+    return writer().written.load(std::memory_order_relaxed);
+}
+
+quint64 AuditLog::droppedCount()
+{
+    return writer().dropped.load(std::memory_order_relaxed);
+}
+
+const char *AuditLog::sourceName(quint8 source)
+{
+    switch (source) {
+        case Rapid:
+            return "rapid";
+        case Interval:
+            return "interval";
+        case Scheduler:
+            return "job";
+        case Shard:
+            return "shard";
+        case Farm:
+            return "farm";
+        case Feed:
+            return "feed";
+        case Trigger:
+            return "trigger";
+        default:
+            return "other";
+    }
+}
+
+const char *AuditLog::actionName(quint8 action)
+{
+    switch (action) {
+        case Click:
+            return "click";
+        case Press:
+            return "press";
+        case Release:
+            return "release";
+        case Keys:
+            return "keys";
+        case Overflow:
+            return "overflow";
+        default:
+            return "?";
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef AUDITLOG_H
+#define AUDITLOG_H
+
+#include <QPoint>
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+#include "types.h"
+
+// Audit log file: one AuditFileHeader, then AuditRecords back to back, in
+// host byte order. Files rotate to path.1, path.2, ... by size.
+struct AuditFileHeader {
+    char magic[4];           // "GAL1"
+    quint32 recordSize;      // sizeof(AuditRecord)
+    quint64 sequence;        // Files written since the log was opened, for ordering rotated files
+    quint64 monotonicBaseNs; // Steady clock when the file was opened...
+    qint64 realtimeBaseNs;   // ...and Unix time at the same instant
+    quint32 pid;
+    quint32 reserved;
+};
+
+struct AuditRecord {
+    quint64 timeNs;   // Steady clock (CLOCK_MONOTONIC on Linux)
+    qint32 x;         // Root coordinates; 0 for key actions
+    qint32 y;
+    quint32 job;      // Scheduler job id, farm display or shard index; lost records for Overflow
+    quint8 action;    // AuditLog::Action
+    quint8 button;    // ClickType of clicks, presses and releases
+    quint8 source;    // AuditLog::Source
+    quint8 reserved;
+};
+
+static_assert(sizeof(AuditFileHeader) == 40, "audit header layout");
+static_assert(sizeof(AuditRecord) == 24, "audit record layout");
+
+// Append-only record of every injected click. ClickerThread records each
+// injection into a per-thread lock-free ring; a writer thread drains the
+// rings into large sequential writes. A slow disk never blocks the engine:
+// records that do not fit are counted, and the count is written to the log
+// as an Overflow record so the gap is visible.
+class AuditLog
+{
+public:
+    enum Source : quint8 { Other, Rapid, Interval, Scheduler, Shard, Farm, Feed, Trigger };
+    enum Action : quint8 { Click, Press, Release, Keys, Overflow };
+
+    static bool open(const QString &path, qint64 rotateBytes = 64 << 20, int keepFiles = 8);
+    static void close(); // Writes what is left
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    // Attributes this thread's following injections; cheap enough to call per job
+    static void setThreadContext(Source source, quint32 job = 0)
+    {
+        threadSource = source;
+        threadJob = job;
+    }
+
+    static void record(Action action, const QPoint &pos, ClickType type)
+    {
+        if (isEnabled()) append(action, pos, type);
+    }
+
+    static quint64 writtenCount();
+    static quint64 droppedCount();
+
+    static const char *sourceName(quint8 source);
+    static const char *actionName(quint8 action);
+
+private:
+    static void append(Action action, const QPoint &pos, ClickType type);
+
+    static std::atomic<bool> enabled;
+    static thread_local Source threadSource;
+    static thread_local quint32 threadJob;
+};
+
+#endif // AUDITLOG_H
@@ -1,66 +1,158 @@
 #include "autoclicker.h"
 #include "clickerthread.h"
+#include "auditlog.h"
+#include "clickclock.h"
+#include "clickmetrics.h"
+#include "clickpacer.h"
+#include "clicktrace.h"
+#include "windowregistry.h"
+#include "screenlayout.h"
+#include "screenwatcher.h"
+#include "targetfeed.h"
+#include "shardedinjector.h"
+#include "profilestore.h"
 #include <QDebug>
+#include <QMutexLocker>
 #include <QDateTime>
-#include <QApplication>
+#include <QCoreApplication>
+#include <QSettings>
 #ifdef Q_OS_WIN
 #include <windows.h>
 #else
 #include <unistd.h>
 #endif
+#if !defined(Q_OS_WIN) && !defined(Q_OS_MAC)
+#include "gertfeed.h"
+#endif
 #include <chrono>
 #include <thread>
 
+static qint64 nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 AutoClicker::AutoClicker(QObject *parent)
     : QObject(parent)
+    , ultraSpeedRunning(false)
+    , engineState(EngineState::Idle)
+    , clock(SteadyClock::instance())
     , clicksPerSecond(10)
     , intervalMs(100)
     , clickType(ClickType::LeftClick)
     , mouseMode(MouseMode::Unlocked)
     , clickLimit(999999)
     , clickCount(0)
+    , firstClickNs(0)
+    , lastClickNs(0)
+    , burstActive(false)
+    , burstLeft(0)
+    , firstClickAtOnce(false)
+    , liveProfile(nullptr)
+    , injectionShards(1)
+    , clickPosition(0)
+    , positionMonitor(-1)
     , useCurrentPosition(true)
-    , running(false)
+    , positionPinned(false)
+    , pressUs(0)
+    , gapUs(0)
     , intervalClickEnabled(false)
     , intervalClickDelayMs(1000)
-    , firstClickPerformed(false)
-    , stopRequested(false)
-    , ultraSpeedRunning(false)
+    , intervalRemainingMs(0)
+    , intervalDueNs(0)
+    , intervalRandomized(false)
+    , intervalSequence(0)
+    , screenTriggerEnabled(false)
+    , targetFeedEnabled(false)
 {
     clickerThread = new ClickerThread(this);
     clickerThread->start();
     
-    clickTimer = new QTimer(this);
-    clickTimer->setSingleShot(false);
+    windowRegistry = new WindowRegistry(this);
     
-    // Initialize ultra-speed thread
-    ultraSpeedThread = new QThread(this);
+    // Started here on the owning thread; positions stay in root coordinates without it
+    layout = new ScreenLayout(this);
+    layout->start();
+    
+    // Pixel-triggered clicks are injected from the watcher thread
+    screenWatcher = new ScreenWatcher(clickerThread, this);
+    connect(screenWatcher, &ScreenWatcher::triggered, this, [this]() {
+        takeClick(); // Already sent, but it still counts towards a burst
+        countClick(nowNs());
+        emit clickPerformed();
+        emit clickCountChanged(clickCount);
+    });
+    
+    feed = new TargetFeed;
+    shardedInjector = new ShardedInjector;
+    
+    // Created per run by startUltraSpeedThread()
+    ultraSpeedThread = nullptr;
     
     // Initialize interval click timer
     intervalClickTimer = new QTimer(this);
     intervalClickTimer->setSingleShot(true);
-    connect(intervalClickTimer, &QTimer::timeout, this, [this]() {
-        if (intervalClickEnabled && running && !stopRequested) {
-            // Perform the interval click
-            clickerThread->performClick();
-            clickCount++;
-            
-            // Process events to keep hotkeys responsive
-            QApplication::processEvents();
-            
-            // Restart the interval timer
-            intervalClickTimer->start(intervalClickDelayMs);
-        }
-    });
+    connect(intervalClickTimer, &QTimer::timeout, this, &AutoClicker::intervalTimeout);
     
     // Performance monitoring disabled for maximum speed
     
-    connect(clickTimer, &QTimer::timeout, this, &AutoClicker::onClickPerformed);
     connect(clickerThread, &ClickerThread::finished, this, [this]() {
         // ClickerThread finished - let it run forever
     });
 }
 
+void AutoClicker::intervalTimeout()
+{
+    if (!intervalClickEnabled || engineState.load() != EngineState::Running) return;
+    
+    // Perform the interval click, skipped while the target window is unmapped
+    AuditLog::setThreadContext(AuditLog::Interval);
+    const StoredProfile *profile = liveProfile.load(std::memory_order_acquire);
+    const ClickTiming timing = profile ? profile->timing() : clickTiming();
+    const KeyAction keys = currentKeyAction();
+    const int delayMs = profile && profile->isInterval() ? profile->intervalDelayMs : intervalClickDelayMs.load();
+    const bool ready = targetReady() && (!keys.isEmpty() || timing.isImmediate() || !intervalTimeline.isActive()) &&
+                       takeClick();
+    if (ready && !keys.isEmpty()) {
+        clickerThread->performKeyAction(keys);
+    } else if (ready && timing.isImmediate() && profile) {
+        clickerThread->performClickAt(profileTarget(profile, intervalSequence++), static_cast<ClickType>(profile->clickType));
+    } else if (ready && timing.isImmediate()) {
+        clickOnce();
+    } else if (ready) {
+        intervalTimeline.begin(profile ? profileTarget(profile, intervalSequence++) : clickTarget(),
+                               profile ? static_cast<ClickType>(profile->clickType) : clickType.load(), timing);
+        stepIntervalTimeline();
+    }
+    if (ready) {
+        // Whole delays of timer slack count as missed slots
+        const qint64 now = clock->nowNs();
+        const qint64 lateNs = qMax(qint64(0), now - intervalDueNs);
+        const quint64 missed = quint64(lateNs / (qint64(qMax(1, delayMs)) * 1000000));
+        countClick(now);
+        if (ClickMetrics::isEnabled()) {
+            if (missed) ClickMetrics::recordMissed(missed);
+            ClickMetrics::recordClick(now, lateNs);
+        }
+        clock->clickSent(intervalDueNs);
+        if (missed) clock->slotsMissed(missed);
+    }
+    
+    // Process events to keep hotkeys responsive
+    QCoreApplication::processEvents();
+    
+    // Restart the interval timer once the click has been sent
+    armIntervalTimer(nextIntervalDelayMs(delayMs));
+}
+
+// The due time goes with the timer, so a click's lateness can be measured
+void AutoClicker::armIntervalTimer(int delayMs)
+{
+    intervalDueNs = clock->nowNs() + qint64(delayMs) * 1000000;
+    intervalClickTimer->start(delayMs);
+}
+
 AutoClicker::~AutoClicker()
 {
     stop();
@@ -68,6 +160,8 @@ AutoClicker::~AutoClicker()
         clickerThread->quit();
         clickerThread->wait();
     }
+    delete shardedInjector;
+    delete feed;
 }
 
 void AutoClicker::setInterval(int value)
@@ -79,10 +173,11 @@ void AutoClicker::setInterval(int value)
 
 void AutoClicker::setClicksPerSecond(int cps)
 {
+    QMutexLocker locker(&controlMutex);
     clicksPerSecond = qBound(1, cps, 10000);
     intervalMs = 1000 / clicksPerSecond;
     
-    if (running) {
+    if (isRunning()) {
         updateTimerInterval();
     }
 }
@@ -93,6 +188,11 @@ void AutoClicker::setClickType(ClickType type)
     clickerThread->setClickType(type);
 }
 
+void AutoClicker::setScrollNotches(int notches)
+{
+    ClickerThread::setScrollNotches(notches);
+}
+
 void AutoClicker::setMouseMode(MouseMode mode)
 {
     mouseMode = mode;
@@ -103,13 +203,219 @@ void AutoClicker::setIntervalClick(bool enabled, int delayMs)
     intervalClickEnabled = enabled;
     intervalClickDelayMs = delayMs;
     
-    if (enabled && running) {
+    if (enabled && engineState.load() == EngineState::Running) {
         // Start interval timer
-        intervalClickTimer->start(delayMs);
+        startIntervalTimer(delayMs);
     } else if (!enabled) {
         // Stop interval timer
-        intervalClickTimer->stop();
+        stopTimers();
+    }
+}
+
+// A profile in the mode the engine is in is swapped in with one pointer
+// store, picked up by the rapid loop or the interval timer before their
+// next click. One in the other mode needs the other engine, so a running
+// engine restarts for it. Shards only run without a stored profile, so
+// adding or dropping one moves rapid clicking between shards and one thread,
+// and the interval timer reseeds for the new distribution.
+void AutoClicker::useProfile(const StoredProfile *profile)
+{
+    const bool interval = profile ? profile->isInterval() : intervalClickEnabled.load();
+    const bool restart = interval != intervalClickEnabled.load() && isRunning();
+    const bool shardable = injectionShards > 1 && currentKeyAction().isEmpty() && intervalProfile().isFixed();
+    const bool repath = !interval && shardable && !liveProfile.load() != !profile;
+    if (restart) stop();
+    
+    if (profile) {
+        setMouseMode(static_cast<MouseMode>(profile->mouseMode));
+        if (interval != intervalClickEnabled.load()) {
+            setIntervalClick(interval, interval ? profile->intervalDelayMs : intervalClickDelayMs.load());
+        }
+    }
+    liveProfile.store(profile, std::memory_order_release);
+    
+    if (restart) {
+        start();
+    } else if (isRunning() && !screenTriggerEnabled && !targetFeedEnabled) {
+        if (repath) {
+            updateTimerInterval();
+        } else if (interval) {
+            startIntervalTimer(intervalClickDelayMs);
+        }
+        const double rate = !profile ? (interval ? 1000.0 / qMax(1, intervalClickDelayMs.load()) : double(clicksPerSecond))
+            : interval ? 1000.0 / profile->intervalDelayMs : double(profile->clicksPerSecond);
+        ClickMetrics::setTargetRate(rate);
+    }
+}
+
+const StoredProfile *AutoClicker::currentProfile() const
+{
+    return liveProfile.load();
+}
+
+void AutoClicker::setTargetWindow(const QString &match)
+{
+    windowRegistry->setTarget(match);
+}
+
+bool AutoClicker::setScreenTrigger(bool enabled, const ScreenTrigger &trigger)
+{
+    // Loaded before anything changes, so a bad file leaves the old trigger in place
+    GrayImage templ;
+    if (enabled && trigger.rule == ScreenTrigger::TemplateFound) {
+        QString error;
+        templ = GrayImage::load(trigger.templateFile, &error);
+        if (templ.isEmpty()) {
+            qWarning().noquote() << "AutoClicker:" << error;
+            return false;
+        }
+        if (templ.width > trigger.region.width() || templ.height > trigger.region.height()) {
+            qWarning() << "AutoClicker: template" << trigger.templateFile << "is larger than the region";
+            return false;
+        }
+    }
+    
+    QMutexLocker locker(&controlMutex);
+    
+    // The watcher thread reads the trigger, so it is swapped only while stopped
+    screenWatcher->stop();
+    screenTriggerEnabled = enabled;
+    screenWatcher->setTrigger(trigger);
+    if (!templ.isEmpty()) screenWatcher->setTemplate(templ);
+    
+    if (isRunning()) {
+        updateTimerInterval();
+    }
+    return true;
+}
+
+bool AutoClicker::setTargetFeed(bool enabled, const QString &name)
+{
+    QMutexLocker locker(&controlMutex);
+    
+    // The ring is created up front so producers can attach before start()
+    bool ok = true;
+    if (enabled && (!feed->isOpen() || (!name.isEmpty() && feed->name() != name))) {
+        stopUltraSpeedThread();
+        ok = feed->create(name);
+    }
+    targetFeedEnabled = enabled && ok;
+    
+    if (isRunning()) {
+        updateTimerInterval();
+    }
+    return ok;
+}
+
+void AutoClicker::setInjectionShards(int shards)
+{
+    QMutexLocker locker(&controlMutex);
+    injectionShards = qBound(1, shards, 64);
+    
+    if (isRunning()) {
+        updateTimerInterval();
+    }
+}
+
+void AutoClicker::setClickTiming(const ClickTiming &timing)
+{
+    QMutexLocker locker(&controlMutex);
+    pressUs = qBound(0, timing.pressUs, 1000000);
+    gapUs = qBound(0, timing.gapUs, 1000000);
+    
+    // The rapid loop reads the timing once when it starts
+    if (isRunning()) {
+        updateTimerInterval();
+    }
+}
+
+ClickTiming AutoClicker::clickTiming() const
+{
+    ClickTiming timing;
+    timing.pressUs = pressUs;
+    timing.gapUs = gapUs;
+    return timing;
+}
+
+bool AutoClicker::setKeyAction(const QString &spec)
+{
+    QMutexLocker locker(&controlMutex);
+    
+    // Keysyms are mapped to keycodes here, once, not per key press
+    KeyAction action;
+    if (!spec.isEmpty() && !clickerThread->resolveKeyAction(spec, &action)) return false;
+    {
+        QMutexLocker actionLocker(&actionMutex);
+        keyAction = action;
     }
+    
+    // The rapid loop copies the action when it starts
+    if (isRunning()) {
+        updateTimerInterval();
+    }
+    return true;
+}
+
+void AutoClicker::setMotion(const MotionSettings &settings)
+{
+    QMutexLocker locker(&controlMutex);
+    {
+        QMutexLocker actionLocker(&actionMutex);
+        motion = settings;
+    }
+    
+    // The rapid loop sizes its path buffer when it starts
+    if (isRunning()) {
+        updateTimerInterval();
+    }
+}
+
+MotionSettings AutoClicker::motionSettings() const
+{
+    QMutexLocker locker(&actionMutex);
+    return motion;
+}
+
+void AutoClicker::setIntervalProfile(const IntervalProfile &profile)
+{
+    QMutexLocker locker(&controlMutex);
+    {
+        QMutexLocker actionLocker(&actionMutex);
+        intervals = profile;
+    }
+    
+    // The rapid loop restarts its ramps; interval mode picks it up on its next start
+    if (isRunning()) {
+        updateTimerInterval();
+    }
+}
+
+void AutoClicker::setClock(ClickClock *newClock)
+{
+    QMutexLocker locker(&controlMutex);
+    if (engineState.load() == EngineState::Idle) clock = newClock ? newClock : SteadyClock::instance();
+}
+
+IntervalProfile AutoClicker::intervalProfile() const
+{
+    QMutexLocker locker(&actionMutex);
+    return intervals;
+}
+
+KeyAction AutoClicker::currentKeyAction() const
+{
+    QMutexLocker locker(&actionMutex);
+    return keyAction;
+}
+
+const TargetFeed *AutoClicker::targetFeed() const
+{
+    return feed;
+}
+
+const ScreenLayout *AutoClicker::screenLayout() const
+{
+    return layout;
 }
 
 void AutoClicker::setClickLimit(int limit)
@@ -119,30 +425,146 @@ void AutoClicker::setClickLimit(int limit)
 
 void AutoClicker::setClickPosition(const QPoint &pos)
 {
-    clickPosition = pos;
+    positionMonitor = -1;
+    clickPosition = packPoint(pos);
+    positionPinned = true;
+    useCurrentPosition = false;
     clickerThread->setClickPosition(pos);
+    clickerThread->setUseCurrentPosition(false);
+}
+
+bool AutoClicker::setClickPosition(const QPoint &offset, const QString &monitor)
+{
+    if (monitor.isEmpty()) {
+        setClickPosition(offset);
+        return true;
+    }
+    
+    const int slot = layout->monitorSlot(monitor);
+    if (slot < 0) return false;
+    
+    clickPosition = packPoint(offset);
+    positionMonitor = slot;
+    positionPinned = true;
+    useCurrentPosition = false;
+    clickerThread->setClickPosition(layout->origin(slot) + offset);
+    clickerThread->setUseCurrentPosition(false);
+    return true;
 }
 
 void AutoClicker::setUseCurrentPosition(bool useCurrent)
 {
     useCurrentPosition = useCurrent;
+    if (useCurrent) positionPinned = false;
     clickerThread->setUseCurrentPosition(useCurrent);
 }
 
-void AutoClicker::start()
+bool AutoClicker::loadProfile(const QString &path)
 {
-    if (running) return;
+    QSettings profile(path, QSettings::IniFormat);
+    if (profile.status() != QSettings::NoError || profile.allKeys().isEmpty()) return false;
+    
+    // Settings from a file replace a stored profile
+    liveProfile.store(nullptr, std::memory_order_release);
+    
+    if (profile.contains("clicksPerSecond")) {
+        setClicksPerSecond(profile.value("clicksPerSecond").toInt());
+    }
+    if (profile.contains("clickType")) {
+        setClickType(static_cast<ClickType>(profile.value("clickType").toInt()));
+    }
+    if (profile.contains("mouseMode")) {
+        setMouseMode(static_cast<MouseMode>(profile.value("mouseMode").toInt()));
+    }
+    if (profile.contains("scrollNotches")) {
+        setScrollNotches(profile.value("scrollNotches").toInt());
+    }
+    if (profile.contains("targetWindow")) {
+        setTargetWindow(profile.value("targetWindow").toString());
+    }
+    if (profile.contains("clickMode")) {
+        // Interval delay is stored in seconds, as in the GUI settings
+        const bool interval = profile.value("clickMode").toInt() == 1;
+        setIntervalClick(interval, profile.value("intervalClickDelay", 1).toInt() * 1000);
+    }
+    if (profile.contains("pressUs") || profile.contains("gapUs")) {
+        ClickTiming timing;
+        timing.pressUs = profile.value("pressUs", 0).toInt();
+        timing.gapUs = profile.value("gapUs", 0).toInt();
+        setClickTiming(timing);
+    }
+    if (profile.contains("motion")) {
+        MotionSettings settings;
+        if (MotionPath::parse(profile.value("motion").toStringList().join(','), &settings)) setMotion(settings);
+    }
+    if (profile.contains("intervals") || profile.contains("warmup") || profile.contains("wave")) {
+        // Same syntax as the --intervals and --wave options
+        IntervalProfile settings;
+        settings.warmupSeconds = profile.value("warmup", 0.0).toDouble();
+        if ((!profile.contains("intervals") || IntervalGenerator::parse(profile.value("intervals").toStringList().join(','), &settings)) &&
+            (!profile.contains("wave") || IntervalGenerator::parseWave(profile.value("wave").toStringList().join(','), &settings))) {
+            setIntervalProfile(settings);
+        }
+    }
+    if (profile.contains("trigger")) {
+        // Same syntax as the --trigger option; "off" clicks on the schedule again
+        const QString spec = profile.value("trigger").toStringList().join(',');
+        ScreenTrigger trigger;
+        if (spec == "off") {
+            setScreenTrigger(false);
+        } else if (ScreenWatcher::parseTrigger(spec, &trigger)) {
+            trigger.matchThreshold = qBound(0, profile.value("matchThreshold", trigger.matchThreshold).toInt(), 255);
+            setScreenTrigger(true, trigger);
+        } else {
+            qWarning() << "AutoClicker: invalid trigger" << spec;
+        }
+    }
+    if (profile.contains("keys")) {
+        setKeyAction(profile.value("keys").toString());
+    }
+    if (profile.contains("injectionShards")) {
+        setInjectionShards(profile.value("injectionShards").toInt());
+    }
+    if (profile.contains("positionX") && profile.contains("positionY")) {
+        const QPoint position(profile.value("positionX").toInt(), profile.value("positionY").toInt());
+        if (!setClickPosition(position, profile.value("positionMonitor").toString())) {
+            qWarning() << "AutoClicker: no monitor layout for" << profile.value("positionMonitor").toString();
+            return false;
+        }
+    }
+    return true;
+}
+
+void AutoClicker::start(bool clickAtOnce)
+{
+    QMutexLocker locker(&controlMutex);
+    if (engineState.load() != EngineState::Idle) return;
     
-    running = true;
-    stopRequested.store(false); // Reset stop flag
     clickCount = 0;
-    firstClickPerformed = false;
+    firstClickNs = 0;
+    lastClickNs = 0;
+    firstClickAtOnce = clickAtOnce;
+    screenWatcher->setPaused(false);
     
     // Capture position only on start based on current mouse mode
-    if (mouseMode == MouseMode::Locked) {
+    if (positionPinned) {
+        // Explicit position from setClickPosition()
+        useCurrentPosition = false;
+    } else if (mouseMode == MouseMode::Locked) {
         // Lock to current position when starting
-        clickPosition = QCursor::pos();
+        QPoint locked = ClickerThread::cursorPosition();
         useCurrentPosition = false;
+        
+        // Keep the position relative to the target window so it follows moves,
+        // or else to its monitor so it follows layout changes
+        int monitor = -1;
+        if (windowRegistry->hasTarget()) {
+            locked -= windowRegistry->targetOrigin();
+        } else if ((monitor = layout->slotAt(locked)) >= 0) {
+            locked -= layout->origin(monitor);
+        }
+        clickPosition = packPoint(locked);
+        positionMonitor = monitor;
     } else {
         // Unlocked mode: always use current position
         useCurrentPosition = true;
@@ -150,56 +572,181 @@ void AutoClicker::start()
     
     // Set up clicker thread
     clickerThread->setClickType(clickType);
-    clickerThread->setClickPosition(clickPosition);
+    clickerThread->setClickPosition(positionMonitor >= 0 ? clickTarget() : unpackPoint(clickPosition));
     clickerThread->setUseCurrentPosition(useCurrentPosition);
     
     // Performance monitoring disabled for maximum speed
     
+    // Set before the clicking threads exist; they exit as soon as it is not Running or Paused
+    ClickerThread::holdBackend();
+    transition(EngineState::Idle, EngineState::Running);
+    
+    // Targets pushed while stopped are stale by now; dropped before the
+    // consumer thread exists, since only it may move the tail
+    if (targetFeedEnabled) {
+        feed->discard();
+    }
+    
     // Start the timer or ultra-speed thread
     updateTimerInterval();
     
     // Start interval click timer if enabled
-    if (intervalClickEnabled) {
-        intervalClickTimer->start(intervalClickDelayMs);
+    if (intervalClickEnabled && !screenTriggerEnabled && !targetFeedEnabled) {
+        startIntervalTimer(intervalClickDelayMs);
     }
     
+    emit runningChanged(true);
+    emit stateChanged(EngineState::Running);
     emit statusChanged("Auto-clicker started");
 }
 
 void AutoClicker::stop()
 {
-    if (!running) return;
+    QMutexLocker locker(&controlMutex);
     
-    stopRequested.store(true);
-    running = false;
-    clickTimer->stop();
-    intervalClickTimer->stop();
+    // Draining: no new clicks start, the ones in flight complete
+    if (!transition(EngineState::Running, EngineState::Draining) &&
+        !transition(EngineState::Paused, EngineState::Draining)) {
+        return;
+    }
     
-    // Clear captured position on stop
-    clickPosition = QPoint(0, 0);
-    useCurrentPosition = true;
+    stopTimers();
+    screenWatcher->stop();
+    shardedInjector->stop();
+    stopUltraSpeedThread();
+    ClickerThread::releaseBackend();
     
-    // Stop ultra-speed thread with timeout
-    if (ultraSpeedRunning.load()) {
-        ultraSpeedRunning.store(false);
-        
-        if (ultraSpeedThread) {
-            ultraSpeedThread->quit();
-            
-            // Wait up to 50ms for graceful shutdown
-            if (!ultraSpeedThread->wait(50)) {
-                ultraSpeedThread->terminate();
-                ultraSpeedThread->wait();
-            }
-        }
+    // Clear captured position on stop
+    if (!positionPinned) {
+        clickPosition = 0;
+        positionMonitor = -1;
+        useCurrentPosition = true;
     }
     
+    burstActive = false;
+    transition(EngineState::Draining, EngineState::Idle);
+    ClickMetrics::setTargetRate(0.0);
+    emit runningChanged(false);
+    emit stateChanged(EngineState::Idle);
     emit statusChanged("Auto-clicker stopped");
 }
 
+bool AutoClicker::burst(int clicks)
+{
+    {
+        QMutexLocker locker(&controlMutex);
+        if (clicks <= 0 || engineState.load() != EngineState::Idle) return false;
+        burstLeft = clicks;
+        burstActive = true;
+    }
+    start();
+    return true;
+}
+
+bool AutoClicker::pause()
+{
+    QMutexLocker locker(&controlMutex);
+    if (!transition(EngineState::Running, EngineState::Paused)) return false;
+    
+    // The rapid and feed loops park themselves on the state change
+    shardedInjector->pause();
+    screenWatcher->setPaused(true);
+    if (intervalClickEnabled && !screenTriggerEnabled && !targetFeedEnabled) {
+        pauseIntervalTimer();
+    }
+    
+    emit stateChanged(EngineState::Paused);
+    emit statusChanged("Auto-clicker paused");
+    return true;
+}
+
+bool AutoClicker::resume()
+{
+    QMutexLocker locker(&controlMutex);
+    if (!transition(EngineState::Paused, EngineState::Running)) return false;
+    
+    shardedInjector->resume();
+    screenWatcher->setPaused(false);
+    if (intervalClickEnabled && !screenTriggerEnabled && !targetFeedEnabled) {
+        // Whatever was left of the interval when paused
+        startIntervalTimer(-1);
+    }
+    
+    emit stateChanged(EngineState::Running);
+    emit statusChanged("Auto-clicker resumed");
+    return true;
+}
+
+EngineState AutoClicker::state() const
+{
+    return engineState.load();
+}
+
 bool AutoClicker::isRunning() const
 {
-    return running;
+    const EngineState current = engineState.load();
+    return current == EngineState::Running || current == EngineState::Paused;
+}
+
+bool AutoClicker::isPaused() const
+{
+    return engineState.load() == EngineState::Paused;
+}
+
+// Transitions go through stateMutex so a thread parked in waitWhilePaused()
+// cannot miss the wake-up
+bool AutoClicker::transition(EngineState from, EngineState to)
+{
+    QMutexLocker locker(&stateMutex);
+    if (!engineState.compare_exchange_strong(from, to)) return false;
+    stateCondition.wakeAll();
+    return true;
+}
+
+// Every clicking thread takes its click from the burst before sending it,
+// so a burst never overshoots even across shards. The last one hands the
+// stop to the GUI thread, which can join the clicking threads.
+bool AutoClicker::takeClick()
+{
+    if (!burstActive.load(std::memory_order_relaxed)) return true;
+    
+    const int left = burstLeft.fetch_sub(1, std::memory_order_relaxed);
+    if (left <= 0) return false;
+    if (left == 1) {
+        QMetaObject::invokeMethod(this, [this]() {
+            // Not if a new burst or a plain start() has begun since
+            if (burstActive.load() && burstLeft.load() <= 0) stop();
+        }, Qt::QueuedConnection);
+    }
+    return true;
+}
+
+void AutoClicker::countClick(qint64 now)
+{
+    clickCount.fetch_add(1, std::memory_order_relaxed);
+    if (!firstClickNs.load(std::memory_order_relaxed)) firstClickNs.store(now, std::memory_order_relaxed);
+    lastClickNs.store(now, std::memory_order_relaxed);
+}
+
+void AutoClicker::waitWhilePaused()
+{
+    QMutexLocker locker(&stateMutex);
+    while (engineState.load() == EngineState::Paused && ultraSpeedRunning.load()) {
+        stateCondition.wait(&stateMutex);
+    }
+}
+
+void AutoClicker::waitWhileRunning()
+{
+    QMutexLocker locker(&stateMutex);
+    while (engineState.load() == EngineState::Running && ultraSpeedRunning.load()) {
+        stateCondition.wait(&stateMutex);
+    }
+}
+
+int AutoClicker::getClicksPerSecond() const
+{
+    return clicksPerSecond;
 }
 
 int AutoClicker::getClickCount() const
@@ -207,6 +754,16 @@ int AutoClicker::getClickCount() const
     return clickCount;
 }
 
+qint64 AutoClicker::firstClickTimeNs() const
+{
+    return firstClickNs.load();
+}
+
+qint64 AutoClicker::lastClickTimeNs() const
+{
+    return lastClickNs.load();
+}
+
 void AutoClicker::resetClickCount()
 {
     clickCount = 0;
@@ -220,47 +777,183 @@ void AutoClicker::performTestClick()
     }
 }
 
+// QTimers belong to the GUI thread; calls from the control thread are
+// handed over instead of touching the timers directly.
+// delayMs < 0 resumes with the time left by pauseIntervalTimer().
+void AutoClicker::startIntervalTimer(int delayMs)
+{
+    auto startTimer = [this, delayMs]() {
+        if (engineState.load() != EngineState::Running) return;
+        if (delayMs < 0) {
+            armIntervalTimer(intervalRemainingMs);
+            return;
+        }
+        
+        // A fresh start restarts the rate ramps, from a live stored profile's
+        // distribution and delay when there is one
+        const StoredProfile *stored = liveProfile.load(std::memory_order_acquire);
+        const bool fromStore = stored && stored->isInterval();
+        const IntervalProfile profile = fromStore ? stored->intervals() : intervalProfile();
+        const int fixedMs = fromStore ? stored->intervalDelayMs : delayMs;
+        intervalRandomized = !profile.isFixed();
+        if (intervalRandomized) intervalGenerator.reset(profile, 1000.0 / qMax(1, fixedMs), clock->randomSeed());
+        armIntervalTimer(nextIntervalDelayMs(fixedMs));
+    };
+    
+    if (QThread::currentThread() == thread()) {
+        startTimer();
+    } else {
+        QMetaObject::invokeMethod(intervalClickTimer, startTimer, Qt::QueuedConnection);
+    }
+}
+
+int AutoClicker::nextIntervalDelayMs(int fixedMs)
+{
+    return intervalRandomized ? int(intervalGenerator.next() / 1000000) : fixedMs;
+}
+
+void AutoClicker::pauseIntervalTimer()
+{
+    auto pauseTimer = [this]() {
+        intervalRemainingMs = intervalClickTimer->isActive() ? qMax(0, intervalClickTimer->remainingTime()) : 0;
+        intervalClickTimer->stop();
+    };
+    
+    if (QThread::currentThread() == thread()) {
+        pauseTimer();
+    } else {
+        QMetaObject::invokeMethod(intervalClickTimer, pauseTimer, Qt::QueuedConnection);
+    }
+}
+
+void AutoClicker::stopTimers()
+{
+    if (QThread::currentThread() == thread()) {
+        intervalClickTimer->stop();
+    } else {
+        QMetaObject::invokeMethod(this, [this]() {
+            intervalClickTimer->stop();
+        }, Qt::QueuedConnection);
+    }
+}
+
+bool AutoClicker::targetReady() const
+{
+    if (windowRegistry->hasTarget()) return windowRegistry->isTargetMapped();
+    
+    // Hold clicks meant for an unplugged monitor rather than send them elsewhere
+    const int monitor = positionMonitor.load(std::memory_order_relaxed);
+    return monitor < 0 || useCurrentPosition || layout->isConnected(monitor);
+}
+
+// Where the next click lands, resolved by the caller rather than the ClickerThread
+QPoint AutoClicker::clickTarget() const
+{
+    const QPoint fixed = unpackPoint(clickPosition);
+    if (windowRegistry->hasTarget() && !useCurrentPosition) {
+        return windowRegistry->targetOrigin() + fixed;
+    }
+    if (useCurrentPosition) return ClickerThread::cursorPosition();
+    
+    const int monitor = positionMonitor.load(std::memory_order_relaxed);
+    return monitor >= 0 ? layout->origin(monitor) + fixed : fixed;
+}
+
+// The next position of a stored profile's sequence, relative to the target
+// window like a locked position; the engine's own target if it has none
+QPoint AutoClicker::profileTarget(const StoredProfile *profile, quint32 index) const
+{
+    if (!profile->positionCount) return clickTarget();
+    
+    const QPoint position = profile->position(index % profile->positionCount);
+    return windowRegistry->hasTarget() ? windowRegistry->targetOrigin() + position : position;
+}
+
+// The remaining events of a timed interval click run off single-shot timers,
+// and still complete if clicking is stopped half way
+void AutoClicker::stepIntervalTimeline()
+{
+    AuditLog::setThreadContext(AuditLog::Interval);
+    const qint64 delayNs = intervalTimeline.step(clickerThread);
+    if (delayNs < 0) return;
+    
+    QTimer::singleShot(int((delayNs + 999999) / 1000000), Qt::PreciseTimer, this, [this]() {
+        stepIntervalTimeline();
+    });
+}
+
+void AutoClicker::clickOnce()
+{
+    if (!useCurrentPosition && (windowRegistry->hasTarget() || positionMonitor.load(std::memory_order_relaxed) >= 0)) {
+        clickerThread->performClickAt(clickTarget());
+    } else {
+        clickerThread->performClick();
+    }
+}
+
 void AutoClicker::updateTimerInterval()
 {
+    // Triggered and fed clicks have no rate of their own
+    if (screenTriggerEnabled || targetFeedEnabled) {
+        ClickMetrics::setTargetRate(0.0);
+    } else {
+        ClickMetrics::setTargetRate(intervalClickEnabled ? 1000.0 / qMax(1, intervalClickDelayMs.load()) : double(clicksPerSecond));
+    }
+    
+    // Pixel-triggered mode clicks only when the watched region matches
+    if (screenTriggerEnabled) {
+        stopUltraSpeedThread();
+        shardedInjector->stop();
+        screenWatcher->startWatching();
+        return;
+    }
+    
+    // Externally computed targets are consumed on the scheduler thread
+    if (targetFeedEnabled) {
+        stopUltraSpeedThread();
+        shardedInjector->stop();
+        startUltraSpeedThread();
+        return;
+    }
+    
     // For interval click mode, don't start ultra-speed thread
     if (intervalClickEnabled) {
         stopUltraSpeedThread();
+        shardedInjector->stop();
         return;
     }
     
-    // Use dedicated thread for rapid click mode
+    // Use dedicated thread for rapid click mode, or one thread per X connection.
+    // Shards click on a fixed grid, so random intervals and stored profiles
+    // stay on one thread.
     stopUltraSpeedThread();
-    startUltraSpeedThread();
+    shardedInjector->stop();
+    if (injectionShards > 1 && currentKeyAction().isEmpty() && intervalProfile().isFixed() && !liveProfile.load()) {
+        startShardedInjection();
+    } else {
+        startUltraSpeedThread();
+    }
 }
 
-void AutoClicker::onClickPerformed()
+void AutoClicker::startShardedInjection()
 {
-    // This method is now only used for interval click mode
-    // Regular clicking is handled by the dedicated thread
-    if (!running || stopRequested) return;
+    shardedInjector->setShardCount(injectionShards);
+    shardedInjector->setClickType(clickType);
+    shardedInjector->setPositionSource([this](QPoint *pos) {
+        if (!targetReady() || !takeClick()) return false;
+        
+        *pos = clickTarget();
+        countClick(nowNs());
+        return true;
+    });
     
-    // Handle interval click mode
-    if (intervalClickEnabled) {
-        if (!firstClickPerformed) {
-            // First click - perform immediately
-            clickerThread->performClick();
-            clickCount++;
-            firstClickPerformed = true;
-            
-            emit clickPerformed();
-            emit clickCountChanged(clickCount);
-            
-            // Stop the regular timer and let interval timer handle the rest
-            clickTimer->stop();
-        }
-        // Subsequent clicks are handled by intervalClickTimer
-        return;
+    // Restarted for a new rate while paused: stay parked until resume()
+    if (engineState.load() == EngineState::Paused) {
+        shardedInjector->pause();
     }
-    
-    // For regular mode, this should not be called anymore since we use dedicated thread
+    shardedInjector->start(clicksPerSecond);
 }
 
- 
 
 void AutoClicker::startUltraSpeedThread()
 {
@@ -268,12 +961,15 @@ void AutoClicker::startUltraSpeedThread()
     
     ultraSpeedRunning.store(true);
     
-    // Stop the regular timer to avoid conflicts
-    clickTimer->stop();
-    
     // Create a lambda function for the thread
     auto threadFunc = [this]() {
-        this->ultraSpeedLoop();
+        ClickTrace::setThreadName(targetFeedEnabled ? "feed" : "rapid");
+        AuditLog::setThreadContext(targetFeedEnabled ? AuditLog::Feed : AuditLog::Rapid);
+        if (targetFeedEnabled) {
+            this->targetFeedLoop();
+        } else {
+            this->ultraSpeedLoop();
+        }
     };
     
     // Start the thread with the lambda
@@ -283,49 +979,172 @@ void AutoClicker::startUltraSpeedThread()
 
 void AutoClicker::stopUltraSpeedThread()
 {
-    if (!ultraSpeedRunning.load()) return;
-    
-    ultraSpeedRunning.store(false);
+    {
+        // Also wakes the thread if it is parked while paused
+        QMutexLocker locker(&stateMutex);
+        if (!ultraSpeedRunning.exchange(false)) return;
+        stateCondition.wakeAll();
+    }
     
+    // The loop sees the flag between clicks and finishes the one in flight;
+    // killing it could leave Xlib or a mutex in a broken state
     if (ultraSpeedThread) {
-        ultraSpeedThread->quit();
-        if (!ultraSpeedThread->wait(100)) {
-            ultraSpeedThread->terminate();
-            ultraSpeedThread->wait();
-        }
+        ultraSpeedThread->wait();
+        delete ultraSpeedThread;
+        ultraSpeedThread = nullptr;
     }
 }
 
 void AutoClicker::ultraSpeedLoop()
 {
-    // Calculate interval in microseconds
-    const int intervalUs = 1000000 / clicksPerSecond;
+    // Intervals are drawn from precomputed blocks when randomized
+    IntervalGenerator generator;
+    bool randomized = false;
+    qint64 intervalNs = 0;
     
     // Cache frequently accessed values
-    const bool highSpeedMode = clicksPerSecond >= 1000;
-    const int stopCheckInterval = highSpeedMode ? 10000 : 500;
+    bool highSpeedMode = false;
+    int stopCheckInterval = 0;
     
     int stopCheckCounter = 0;
     
-    // Use high-resolution clock for precise timing
-    auto lastClickTime = std::chrono::high_resolution_clock::now();
+    // Non-immediate timing: down and up are separate events, stepped from this
+    // loop when they come due instead of sleeping between them
+    ClickTiming timing;
+    ClickTimeline timeline;
+    
+    // The next click counts from the last one, so a late click moves the schedule
+    ClickPacer pacer;
     
-    while (ultraSpeedRunning.load(std::memory_order_relaxed) && 
-           running && 
-           !stopRequested.load(std::memory_order_relaxed)) {
+    // A stored profile (see useProfile()) replaces the rate, timing, intervals,
+    // type and positions. It is swapped in between clicks, with the next click
+    // one of its intervals after the switch.
+    const StoredProfile *profile = nullptr;
+    quint32 sequence = 0;
+    auto applySettings = [&](const StoredProfile *next, qint64 now, bool clickNow) {
+        profile = next;
+        sequence = 0;
+        const int rate = next ? int(next->clicksPerSecond) : clicksPerSecond.load();
+        const IntervalProfile intervals = next ? next->intervals() : intervalProfile();
+        randomized = !intervals.isFixed();
+        if (randomized) generator.reset(intervals, rate, clock->randomSeed());
+        intervalNs = 1000000000LL / rate;
+        highSpeedMode = rate >= 1000;
+        stopCheckInterval = highSpeedMode ? 10000 : 500;
+        timing = next ? next->timing() : clickTiming();
         
-        const auto currentTime = std::chrono::high_resolution_clock::now();
-        const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(currentTime - lastClickTime);
+        const qint64 firstDelayNs = clickNow ? 0 : randomized ? generator.next() : intervalNs;
+        pacer.start(now + firstDelayNs, intervalNs, ClickPacer::Drift, randomized ? &generator : nullptr);
+    };
+    
+    // Key actions take the place of the click, resolved once by setKeyAction()
+    const KeyAction keys = currentKeyAction();
+    
+    // A new fixed position is approached along a path rather than jumped to
+    const MotionSettings glideSettings = motionSettings();
+    const bool gliding = glideSettings.isEnabled() && keys.isEmpty();
+    MotionStream glide;
+    glide.reserve(glideSettings);
+    QPoint lastTarget = gliding ? ClickerThread::cursorPosition() : QPoint();
+    qint64 nextGlideNs = 0;
+    
+    const qint64 startNs = clock->nowNs();
+    applySettings(liveProfile.load(std::memory_order_acquire), startNs, firstClickAtOnce);
+    qint64 nextEventNs = startNs;
+    
+    while (ultraSpeedRunning.load(std::memory_order_relaxed)) {
+        // Points of the path come due in batches; the click follows on arrival
+        if (glide.isActive()) {
+            const qint64 now = clock->nowNs();
+            if (now >= nextGlideNs) {
+                nextGlideNs = glide.step(clickerThread, now);
+            } else {
+                clock->poll(nextGlideNs, !highSpeedMode);
+            }
+            continue;
+        }
+        
+        // A click under way is completed before pausing or draining
+        if (timeline.isActive()) {
+            const qint64 now = clock->nowNs();
+            if (now >= nextEventNs) {
+                const qint64 delayNs = timeline.step(clickerThread);
+                if (delayNs >= 0) nextEventNs = now + delayNs;
+            } else {
+                clock->poll(nextEventNs, !highSpeedMode);
+            }
+            continue;
+        }
+        
+        const EngineState current = engineState.load(std::memory_order_acquire);
+        if (current == EngineState::Paused) {
+            // Shift the schedule by the paused time so the phase is kept
+            const qint64 pausedAt = clock->nowNs();
+            ClickMetrics::publish();
+            waitWhilePaused();
+            pacer.shift(clock->nowNs() - pausedAt);
+            continue;
+        }
+        if (current != EngineState::Running) break;
+        
+        const StoredProfile *live = liveProfile.load(std::memory_order_acquire);
+        if (live != profile) applySettings(live, clock->nowNs(), false);
+        
+        const qint64 currentNs = clock->nowNs();
+        
+        // Pause while the target window is unmapped; resume on a fresh interval
+        if (!targetReady()) {
+            clock->sleepUntil(clock->nowNs() + 1000000);
+            pacer.restartFrom(currentNs);
+            continue;
+        }
         
         // Only perform click if enough time has passed
-        if (elapsed.count() >= intervalUs) {
-            // Perform the click
-            clickerThread->performClick();
-            ++clickCount;
+        if (currentNs >= pacer.dueNs()) {
+            ClickTrace::complete("wakeup", pacer.dueNs(), currentNs);
+            
+            if (gliding && !useCurrentPosition && !profile) {
+                const QPoint target = clickTarget();
+                if (target != lastTarget) {
+                    const qint64 now = clock->nowNs();
+                    glide.begin(glideSettings, lastTarget, target, now);
+                    nextGlideNs = glide.step(clickerThread, now);
+                    lastTarget = target;
+                    continue;
+                }
+            }
+            
+            // A burst that has used up its clicks waits here for stop()
+            if (!takeClick()) {
+                clock->sleepUntil(clock->nowNs() + 1000000);
+                continue;
+            }
+            
+            // Perform the click or key action, or start the click's timeline
+            if (!keys.isEmpty()) {
+                clickerThread->performKeyAction(keys);
+            } else if (timing.isImmediate() && profile) {
+                clickerThread->performClickAt(profileTarget(profile, sequence++), static_cast<ClickType>(profile->clickType));
+            } else if (timing.isImmediate()) {
+                clickOnce();
+            } else {
+                timeline.begin(profile ? profileTarget(profile, sequence++) : clickTarget(),
+                               profile ? static_cast<ClickType>(profile->clickType) : clickType.load(), timing);
+                nextEventNs = currentNs + timeline.step(clickerThread);
+            }
+            countClick(currentNs);
             ++stopCheckCounter;
             
-            // Update last click time
-            lastClickTime = currentTime;
+            // Whole intervals of lateness count as missed slots
+            const qint64 dueNs = pacer.dueNs();
+            const qint64 lateNs = currentNs - dueNs;
+            const quint64 missed = pacer.advance(currentNs);
+            if (ClickMetrics::isEnabled()) {
+                if (missed) ClickMetrics::recordMissed(missed);
+                ClickMetrics::recordClick(clock->nowNs(), lateNs);
+            }
+            clock->clickSent(dueNs);
+            if (missed) clock->slotsMissed(missed);
             
             // Reduce stop flag checking frequency for ultra-high speeds
             if (stopCheckCounter >= stopCheckInterval) {
@@ -335,9 +1154,95 @@ void AutoClicker::ultraSpeedLoop()
                     std::this_thread::yield();
                 }
             }
-        } else if (!highSpeedMode) {
-            // Only sleep for lower speeds - ultra-high speed mode stays in tight loop
-            std::this_thread::yield();
+        } else {
+            // Only yield for lower speeds - ultra-high speed mode stays in tight loop
+            clock->poll(pacer.dueNs(), !highSpeedMode);
+        }
+    }
+    
+    // Stopped or restarted in the middle of a click: release the button
+    timeline.cancel(clickerThread);
+    ClickMetrics::publish();
+}
+
+#if !defined(Q_OS_WIN) && !defined(Q_OS_MAC)
+void AutoClicker::targetFeedLoop()
+{
+    while (ultraSpeedRunning.load(std::memory_order_relaxed)) {
+        const EngineState current = engineState.load(std::memory_order_acquire);
+        if (current == EngineState::Paused) {
+            // Records keep queueing in the ring; deadlines still apply on resume
+            ClickMetrics::publish();
+            waitWhilePaused();
+            continue;
+        }
+        if (current != EngineState::Running) break;
+        
+        // Sleeps on the futex doorbell; the timeout only bounds stop latency
+        if (!feed->wait(50)) continue;
+        
+        // Records are read in place and released once clicked
+        while (const gert_feed_record *record = feed->peek()) {
+            if (!ultraSpeedRunning.load(std::memory_order_relaxed) ||
+                engineState.load(std::memory_order_acquire) != EngineState::Running) break;
+            
+            // Hold records while the target window is unmapped; deadlines still apply
+            if (!targetReady()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            
+            if (record->deadline_ns && gert_feed_now_ns() > record->deadline_ns) {
+                feed->recordExpired();
+                feed->release();
+                ClickMetrics::recordMissed(1);
+                continue;
+            }
+            if (!targetReady()) continue;
+            
+            // The burst is over: leave the rest queued and park until stop()
+            if (!takeClick()) {
+                waitWhileRunning();
+                break;
+            }
+            
+            ClickType type;
+            switch (record->button) {
+                case GERT_FEED_BUTTON_LEFT:
+                    type = ClickType::LeftClick;
+                    break;
+                case GERT_FEED_BUTTON_RIGHT:
+                    type = ClickType::RightClick;
+                    break;
+                case GERT_FEED_BUTTON_MIDDLE:
+                    type = ClickType::MiddleClick;
+                    break;
+                case GERT_FEED_BUTTON_DOUBLE:
+                    type = ClickType::DoubleClick;
+                    break;
+                case GERT_FEED_BUTTON_TRIPLE:
+                    type = ClickType::TripleClick;
+                    break;
+                default:
+                    type = clickType;
+                    break;
+            }
+            
+            clickerThread->performClickAt(QPoint(record->x, record->y), type);
+            feed->recordClick(gert_feed_now_ns() - record->produced_ns);
+            feed->release();
+            const qint64 now = nowNs();
+            countClick(now);
+            
+            if (ClickMetrics::isEnabled()) {
+                ClickMetrics::recordClick(now, -1);
+                ClickMetrics::setQueue(now, feed->queuedCount(), feed->droppedCount());
+            }
         }
     }
-} 
\ No newline at end of file
+    ClickMetrics::publish();
+}
+#else
+void AutoClicker::targetFeedLoop()
+{
+}
+#endif
@@ -5,10 +5,22 @@
 #include <QThread>
 #include <QTimer>
 #include <QPoint>
+#include <QMutex>
+#include <QWaitCondition>
 #include <atomic>
 #include "types.h"
+#include "clicktimeline.h"
+#include "motionpath.h"
+#include "intervalgenerator.h"
 
+class ClickClock;
 class ClickerThread;
+class WindowRegistry;
+class ScreenLayout;
+class ScreenWatcher;
+class TargetFeed;
+class ShardedInjector;
+struct StoredProfile;
 
 class AutoClicker : public QObject
 {
@@ -21,16 +33,48 @@ public:
     void setInterval(int value); // Legacy method
     void setClicksPerSecond(int clicksPerSecond);
     void setClickType(ClickType type);
+    void setScrollNotches(int notches); // Per scroll action, for every engine in the process
     void setMouseMode(MouseMode mode);
     void setClickLimit(int limit);
-    void setClickPosition(const QPoint &pos);
+    void setClickPosition(const QPoint &pos); // Pins the position until setUseCurrentPosition(true)
+    bool setClickPosition(const QPoint &offset, const QString &monitor); // Relative to a monitor that may come and go; false without XRandR
     void setUseCurrentPosition(bool useCurrent);
     void setIntervalClick(bool enabled, int delayMs = 1000);
+    void setTargetWindow(const QString &match); // WM_CLASS or title, empty for any window
+    bool setScreenTrigger(bool enabled, const ScreenTrigger &trigger = ScreenTrigger()); // False if the template cannot be loaded
+    bool setTargetFeed(bool enabled, const QString &name = QString()); // Click targets from shared memory
+    void setInjectionShards(int shards); // Rapid mode over this many X connections; 1 = single thread
+    void setClickTiming(const ClickTiming &timing); // Rapid and interval modes; others click back to back
+    bool setKeyAction(const QString &spec); // Rapid and interval modes press keys instead of clicking; empty for mouse clicks
+    void setMotion(const MotionSettings &motion); // Rapid mode glides to a new fixed position instead of jumping
+    void setIntervalProfile(const IntervalProfile &profile); // Random spacing and rate ramps for rapid and interval modes
+    void setClock(ClickClock *clock); // Time source of rapid and interval modes, set while stopped; nullptr for the steady clock
+    bool loadProfile(const QString &path); // INI file using the GUI's settings keys
+    void useProfile(const StoredProfile *profile); // From a mapped ProfileStore, live while running; nullptr for the engine's own settings
+    const StoredProfile *currentProfile() const;
 
-    void start();
+    // start(), stop(), pause() and resume() may be called from any thread.
+    // Pause keeps the clicking threads, the click count and the time since
+    // the last click, so resume() continues the same schedule.
+    // clickAtOnce sends rapid mode's first click immediately rather than
+    // one interval in, as for hold-to-click.
+    void start(bool clickAtOnce = false);
     void stop();
-    bool isRunning() const;
+    bool burst(int clicks); // Starts, and stops by itself after this many clicks; false if already running
+    bool pause();
+    bool resume();
+    EngineState state() const;
+    bool isRunning() const; // Running or paused
+    bool isPaused() const;
+    int getClicksPerSecond() const;
     int getClickCount() const;
+    qint64 firstClickTimeNs() const; // Steady clock time of the first click since start(), 0 before it
+    qint64 lastClickTimeNs() const;  // Of the latest click
+    ClickTiming clickTiming() const;
+    MotionSettings motionSettings() const;
+    IntervalProfile intervalProfile() const;
+    const TargetFeed *targetFeed() const;
+    const ScreenLayout *screenLayout() const;
     void resetClickCount();
     void performTestClick(); // Add this method for testing
     
@@ -40,42 +84,95 @@ signals:
     void clickPerformed();
     void clickCountChanged(int count);
     void statusChanged(const QString &status);
+    void runningChanged(bool running);
+    void stateChanged(EngineState state);
     void performanceUpdate(double clicksPerSecond); // New signal for performance updates
 
 private slots:
-    void onClickPerformed();
     void ultraSpeedLoop();
 
 private:
+    friend class ClickSimulator; // Fires the interval timer on a virtual clock
+
     ClickerThread *clickerThread;
-    QTimer *clickTimer;
+    WindowRegistry *windowRegistry;
+    ScreenLayout *layout;
+    ScreenWatcher *screenWatcher;
+    TargetFeed *feed;
+    ShardedInjector *shardedInjector;
     
 
     
-    // Ultra-speed thread for bypassing Qt event loop
+    // Ultra-speed thread for bypassing Qt event loop; kept across pauses
     QThread *ultraSpeedThread;
-    std::atomic<bool> ultraSpeedRunning;
+    std::atomic<bool> ultraSpeedRunning; // Thread lifetime, cleared on mode changes
+    
+    // Everything below is read by the clicking threads, hence atomic
+    std::atomic<EngineState> engineState;
+    QMutex stateMutex; // Pairs with stateCondition for threads parked while paused
+    QWaitCondition stateCondition;
+    ClickClock *clock;
     
-    int clicksPerSecond;
+    std::atomic<int> clicksPerSecond;
     int intervalMs; // Calculated from clicks per second
-    ClickType clickType;
+    std::atomic<ClickType> clickType;
     MouseMode mouseMode;
     int clickLimit;
-    int clickCount;
-    QPoint clickPosition;
-    bool useCurrentPosition;
-    bool running;
+    std::atomic<int> clickCount; // Incremented from the clicking threads
+    std::atomic<qint64> firstClickNs;
+    std::atomic<qint64> lastClickNs;
+    std::atomic<bool> burstActive;
+    std::atomic<int> burstLeft; // Clicks of the burst not yet taken
+    std::atomic<bool> firstClickAtOnce;
+    std::atomic<const StoredProfile *> liveProfile;
+    int injectionShards;
+    std::atomic<qint64> clickPosition; // packPoint()
+    std::atomic<int> positionMonitor; // ScreenLayout slot clickPosition is relative to, or -1
+    std::atomic<bool> useCurrentPosition;
+    bool positionPinned;
+    std::atomic<int> pressUs;
+    std::atomic<int> gapUs;
+    KeyAction keyAction; // Resolved by setKeyAction(), copied by the clicking threads
+    MotionSettings motion;
+    IntervalProfile intervals;
+    mutable QMutex actionMutex; // Guards keyAction, motion and intervals
+    QMutex controlMutex; // Serializes state changes from the GUI and control threads
     
     // Interval click functionality
-    bool intervalClickEnabled;
-    int intervalClickDelayMs;
+    std::atomic<bool> intervalClickEnabled;
+    std::atomic<int> intervalClickDelayMs;
     QTimer *intervalClickTimer;
-    bool firstClickPerformed;
-    std::atomic<bool> stopRequested; // Atomic flag for immediate stop requests
+    int intervalRemainingMs; // Left on the interval timer when paused; GUI thread only
+    qint64 intervalDueNs; // When the interval timer fires, on the engine's clock; GUI thread only
+    ClickTimeline intervalTimeline; // Timed interval click in progress; GUI thread only
+    IntervalGenerator intervalGenerator; // Interval mode delays; GUI thread only
+    bool intervalRandomized;
+    quint32 intervalSequence; // Position of the stored profile's sequence; GUI thread only
+    std::atomic<bool> screenTriggerEnabled;
+    std::atomic<bool> targetFeedEnabled;
     
+    bool transition(EngineState from, EngineState to);
+    bool takeClick(); // One click of a burst; false once they are used up
+    void countClick(qint64 now);
+    void waitWhilePaused();
+    void waitWhileRunning(); // Until stopped or paused, e.g. once a burst is used up
+    bool targetReady() const;
+    QPoint clickTarget() const;
+    QPoint profileTarget(const StoredProfile *profile, quint32 index) const;
+    KeyAction currentKeyAction() const;
+    void clickOnce();
+    void intervalTimeout();
+    void armIntervalTimer(int delayMs);
+    void stepIntervalTimeline();
     void updateTimerInterval();
+    void startIntervalTimer(int delayMs);
+    int nextIntervalDelayMs(int fixedMs);
+    void pauseIntervalTimer();
+    void stopTimers();
     void startUltraSpeedThread();
+    void startShardedInjection();
     void stopUltraSpeedThread();
+    void targetFeedLoop();
 };
 
 #endif // AUTOCLICKER_H 
\ No newline at end of file
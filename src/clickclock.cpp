@@ -0,0 +1,32 @@
+#include "clickclock.h"
+#include <chrono>
+#include <thread>
+
+qint64 SteadyClock::nowNs() const
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void SteadyClock::sleepUntil(qint64 ns)
+{
+    std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(ns)));
+}
+
+void SteadyClock::busy(qint64 ns)
+{
+    const qint64 end = nowNs() + ns;
+    while (nowNs() < end) {
+    }
+}
+
+void SteadyClock::poll(qint64, bool yield)
+{
+    if (yield) std::this_thread::yield();
+}
+
+SteadyClock *SteadyClock::instance()
+{
+    static SteadyClock clock;
+    return &clock;
+}
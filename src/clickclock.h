@@ -0,0 +1,66 @@
+#ifndef CLICKCLOCK_H
+#define CLICKCLOCK_H
+
+#include <QtGlobal>
+
+// Time source and sleep for code that paces clicks. SteadyClock is the real
+// thing. VirtualClock never blocks: sleeping jumps straight to the wake
+// time, so hours of schedule replay in milliseconds and every run of the
+// same settings gives the same result.
+//
+// The engines (AutoClicker's rapid and interval modes, ClickScheduler) take
+// one through setClock(), so a simulation runs their own loops; they report
+// each click and missed slot back, which only a simulation looks at.
+class ClickClock
+{
+public:
+    virtual ~ClickClock() {}
+
+    virtual qint64 nowNs() const = 0;
+    virtual void sleepUntil(qint64 ns) = 0; // Returns at once if ns has passed
+    virtual void busy(qint64 ns) = 0;       // Work that takes ns, e.g. an injection
+
+    // One pass of a wait for ns that does not sleep: the steady clock yields
+    // the CPU or, without yield, returns at once to spin; a virtual clock
+    // jumps to ns
+    virtual void poll(qint64 ns, bool yield) = 0;
+
+    // False if time only moves when the clock's own methods move it; waits
+    // that another thread may cut short then use sleepUntil() instead
+    virtual bool isRealTime() const = 0;
+
+    // Seed for random intervals; 0 lets each generator seed from the time
+    virtual quint64 randomSeed() const { return 0; }
+
+    virtual void clickSent(qint64 dueNs) { Q_UNUSED(dueNs); }
+    virtual void slotsMissed(quint64 count) { Q_UNUSED(count); }
+};
+
+class SteadyClock : public ClickClock
+{
+public:
+    qint64 nowNs() const override;
+    void sleepUntil(qint64 ns) override;
+    void busy(qint64 ns) override; // Spins
+    void poll(qint64 ns, bool yield) override;
+    bool isRealTime() const override { return true; }
+
+    static SteadyClock *instance(); // Shared default of the engines
+};
+
+class VirtualClock : public ClickClock
+{
+public:
+    explicit VirtualClock(qint64 startNs = 0) : current(startNs) {}
+
+    qint64 nowNs() const override { return current; }
+    void sleepUntil(qint64 ns) override { current = qMax(current, ns); }
+    void busy(qint64 ns) override { current += qMax(qint64(0), ns); }
+    void poll(qint64 ns, bool) override { sleepUntil(ns); }
+    bool isRealTime() const override { return false; }
+
+private:
+    qint64 current;
+};
+
+#endif // CLICKCLOCK_H
@@ -0,0 +1,1180 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QSettings>
+#include <QThread>
+#include <QTimer>
+#include <QDebug>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <csignal>
+#include <memory>
+#include "auditlog.h"
+#include "autoclicker.h"
+#include "clickerthread.h"
+#include "clickclock.h"
+#include "clickfarm.h"
+#include "clickscheduler.h"
+#include "clicksimulator.h"
+#include "clickmetrics.h"
+#include "clicktrace.h"
+#include "stagecounters.h"
+#include "hotkeydispatcher.h"
+#include "hotkeymanager.h"
+#include "inputprobe.h"
+#include "intervalgenerator.h"
+#include "motionpath.h"
+#include "controlserver.h"
+#include "metricsserver.h"
+#include "processstats.h"
+#include "profilestore.h"
+#include "screenlayout.h"
+#include "screenwatcher.h"
+#include "shardedinjector.h"
+#include "templatematcher.h"
+#include "windowregistry.h"
+#include <chrono>
+#include <thread>
+
+// Headless click daemon: the same engine as the GUI, built on QtCore only,
+// for display-less hosts (e.g. against Xvfb). Configured from an INI file
+// and/or the command line; the command line wins.
+
+void signalHandler(int signal)
+{
+    qDebug() << "Received signal:" << signal;
+    QCoreApplication::quit();
+}
+
+static bool parseClickType(const QString &name, ClickType *type)
+{
+    const QString button = name.toLower();
+    if (button == "left") {
+        *type = ClickType::LeftClick;
+    } else if (button == "right") {
+        *type = ClickType::RightClick;
+    } else if (button == "middle") {
+        *type = ClickType::MiddleClick;
+    } else if (button == "double") {
+        *type = ClickType::DoubleClick;
+    } else if (button == "triple") {
+        *type = ClickType::TripleClick;
+    } else if (button == "scroll-up") {
+        *type = ClickType::ScrollUp;
+    } else if (button == "scroll-down") {
+        *type = ClickType::ScrollDown;
+    } else if (button == "scroll-left") {
+        *type = ClickType::ScrollLeft;
+    } else if (button == "scroll-right") {
+        *type = ClickType::ScrollRight;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool parsePosition(const QString &text, QPoint *pos)
+{
+    const QStringList coordinates = text.split(',');
+    bool okX = false, okY = false;
+    const int x = coordinates.value(0).toInt(&okX);
+    const int y = coordinates.value(1).toInt(&okY);
+    if (coordinates.size() != 2 || !okX || !okY) return false;
+    *pos = QPoint(x, y);
+    return true;
+}
+
+// Farm mode: one process, many X displays, a bounded pool of pinned workers
+static int runFarm(QCoreApplication &app, const QStringList &displays, int workers, int rate,
+                   ClickType type, const QPoint &position, int statsIntervalSeconds)
+{
+    ClickFarm farm;
+    farm.setDisplays(displays);
+    farm.setWorkerCount(workers);
+    farm.setClicksPerSecond(rate);
+    farm.setClickType(type);
+    farm.setClickPosition(position);
+    if (!farm.start()) return 1;
+    ClickMetrics::setTargetRate(double(rate) * displays.size());
+
+    qInfo().noquote() << QString("gert-clickd: farming %1 displays on %2 workers at %3 clicks/s each")
+                             .arg(displays.size()).arg(farm.workerCount()).arg(rate);
+
+    QTimer statsTimer;
+    if (statsIntervalSeconds > 0) {
+        QObject::connect(&statsTimer, &QTimer::timeout, [&farm]() {
+            qInfo().noquote() << farm.report();
+            if (StageCounters::isEnabled()) qInfo().noquote() << StageCounters::report();
+        });
+        statsTimer.start(statsIntervalSeconds * 1000);
+    }
+
+    const int result = app.exec();
+
+    farm.stop();
+    ClickMetrics::setTargetRate(0.0);
+    qInfo().noquote() << farm.report();
+    return result;
+}
+
+// Job mode: many independent jobs multiplexed onto a few scheduler threads
+static int runJobs(QCoreApplication &app, const QVector<ClickJob> &jobs, int threads, int statsIntervalSeconds)
+{
+    WindowRegistry windowRegistry;
+    for (const ClickJob &job : jobs) {
+        if (!job.window.isEmpty()) {
+            windowRegistry.start();
+            break;
+        }
+    }
+
+    ClickScheduler scheduler;
+    scheduler.setThreadCount(threads);
+    scheduler.setWindowRegistry(&windowRegistry);
+    for (const ClickJob &job : jobs) {
+        scheduler.addJob(job);
+    }
+    if (!scheduler.start()) return 1;
+
+    // Nominal rate; interval profiles vary it around this
+    double targetRate = 0.0;
+    for (const ClickJob &job : jobs) {
+        targetRate += job.clicksPerSecond;
+    }
+    ClickMetrics::setTargetRate(targetRate);
+
+    qInfo().noquote() << QString("gert-clickd: scheduling %1 jobs on %2 threads")
+                             .arg(jobs.size()).arg(scheduler.threadCount());
+
+    QTimer statsTimer;
+    if (statsIntervalSeconds > 0) {
+        QObject::connect(&statsTimer, &QTimer::timeout, [&scheduler]() {
+            qInfo().noquote() << scheduler.report();
+            if (StageCounters::isEnabled()) qInfo().noquote() << StageCounters::report();
+        });
+        statsTimer.start(statsIntervalSeconds * 1000);
+    }
+
+    const int result = app.exec();
+
+    scheduler.stop();
+    ClickMetrics::setTargetRate(0.0);
+    qInfo().noquote() << scheduler.report();
+    return result;
+}
+
+// Each group of the INI file is one job: rate, x, y, button, window, pressUs,
+// gapUs, keys, intervals, warmup, wave, and for moving jobs path
+// ("x,y;x,y;..."), motion and drag
+static bool loadJobs(const QString &path, QVector<ClickJob> *jobs)
+{
+    QSettings file(path, QSettings::IniFormat);
+    const QStringList groups = file.childGroups();
+    if (groups.isEmpty()) return false;
+
+    for (const QString &group : groups) {
+        file.beginGroup(group);
+        ClickJob job;
+        job.clicksPerSecond = file.value("rate", 10).toInt();
+        job.position = QPoint(file.value("x", 0).toInt(), file.value("y", 0).toInt());
+        job.window = file.value("window").toString();
+        job.timing.pressUs = file.value("pressUs", 0).toInt();
+        job.timing.gapUs = file.value("gapUs", 0).toInt();
+        job.keys = file.value("keys").toString();
+        job.drag = file.value("drag", false).toBool();
+
+        // QSettings splits values on commas, so lists are joined back first
+        bool validPath = true;
+        for (const QString &point : file.value("path").toStringList().join(',').split(';', Qt::SkipEmptyParts)) {
+            QPoint pos;
+            validPath = validPath && parsePosition(point.trimmed(), &pos);
+            job.path.append(pos);
+        }
+        if (file.contains("motion")) {
+            validPath = validPath && MotionPath::parse(file.value("motion").toStringList().join(','), &job.motion);
+        }
+        bool validIntervals = true;
+        if (file.contains("intervals")) {
+            validIntervals = IntervalGenerator::parse(file.value("intervals").toStringList().join(','), &job.intervals);
+        }
+        if (file.contains("wave")) {
+            validIntervals = validIntervals && IntervalGenerator::parseWave(file.value("wave").toStringList().join(','), &job.intervals);
+        }
+        job.intervals.warmupSeconds = file.value("warmup", 0.0).toDouble();
+        const bool validButton = parseClickType(file.value("button", "left").toString(), &job.clickType);
+        file.endGroup();
+
+        if (job.clicksPerSecond <= 0 || !validButton || !validPath || !validIntervals || job.timing.pressUs < 0 || job.timing.gapUs < 0) {
+            qCritical() << "gert-clickd: invalid job" << group;
+            return false;
+        }
+        jobs->append(job);
+    }
+    return true;
+}
+
+// Path generation cost for each curve, without injecting anything
+static int benchMotion(int points)
+{
+    QVector<QPoint> buffer(points);
+    for (MotionCurve curve : { MotionCurve::Linear, MotionCurve::Bezier, MotionCurve::MinimumJerk }) {
+        MotionSettings settings;
+        settings.curve = curve;
+        settings.sampleRate = 1000;
+        settings.durationUs = (points - 1) * 1000;
+
+        const int rounds = 1000;
+        QElapsedTimer timer;
+        timer.start();
+        int generated = 0;
+        for (int i = 0; i < rounds; ++i) {
+            generated = MotionPath::generate(settings, QPoint(i % 16, 0), QPoint(1900, 1000), buffer.data(), points);
+        }
+        const double us = timer.nsecsElapsed() / 1000.0 / rounds;
+        qInfo().noquote() << QString("%1 %2 points: %3 us per path (%4 ns per point)")
+                                 .arg(MotionPath::curveName(curve), -8).arg(generated)
+                                 .arg(us, 0, 'f', 2).arg(us * 1000.0 / generated, 0, 'f', 2);
+    }
+    return 0;
+}
+
+// Find-and-click search cost on a 1080p frame of noise with the template
+// cut from it: a full search, then the pyramid matcher on a new frame and
+// on a frame where a single tile changed
+static int benchMatch(int size)
+{
+    GrayImage frame = GrayImage::create(1920, 1080);
+    quint32 seed = 12345;
+    for (int y = 0; y < frame.height; ++y) {
+        quint8 *row = frame.pixels.data() + y * frame.stride;
+        for (int x = 0; x < frame.width; ++x) {
+            seed = seed * 1664525u + 1013904223u;
+            row[x] = quint8(seed >> 24);
+        }
+    }
+
+    const QPoint planted(1234, 567);
+    GrayImage templ = GrayImage::create(size, size);
+    for (int y = 0; y < size; ++y) {
+        memcpy(templ.pixels.data() + y * templ.stride, frame.row(planted.y() + y) + planted.x(), size_t(size));
+    }
+
+    TemplateMatcher matcher;
+    matcher.setTemplate(templ);
+    PyramidMatcher pyramid;
+    pyramid.setTemplate(templ);
+
+    auto report = [&planted](const char *name, const TemplateMatcher::Match &match, double ms) {
+        qInfo().noquote() << QString("%1 %2 ms, %3").arg(name, -14).arg(ms, 0, 'f', 2)
+                                 .arg(match.found && match.position == planted ? "found" : "MISSED");
+        return match.found && match.position == planted;
+    };
+
+    const int rounds = 20;
+    QElapsedTimer timer;
+    TemplateMatcher::Match match;
+
+    timer.start();
+    for (int i = 0; i < rounds; ++i) match = matcher.find(frame);
+    bool ok = report("full search", match, timer.nsecsElapsed() / 1e6 / rounds);
+
+    qint64 freshNs = 0, tileNs = 0;
+    for (int i = 0; i < rounds; ++i) {
+        pyramid.invalidate();
+        timer.restart();
+        match = pyramid.find(frame);
+        freshNs += timer.nsecsElapsed();
+
+        // Far from the template, so the result must not change
+        frame.pixels[(100 + i) * frame.stride + 100] ^= 0xFF;
+        timer.restart();
+        const TemplateMatcher::Match again = pyramid.find(frame);
+        tileNs += timer.nsecsElapsed();
+        ok = ok && again.found && again.position == match.position;
+    }
+    ok = report("pyramid, new", match, freshNs / 1e6 / rounds) && ok;
+    ok = report("pyramid, 1 tile", match, tileNs / 1e6 / rounds) && ok;
+
+    qInfo().noquote() << QString("kernel %1, template %2x%2, %3 threads")
+                             .arg(TemplateMatcher::kernelName()).arg(size).arg(QThread::idealThreadCount());
+    return ok ? 0 : 1;
+}
+
+// Packs INI profiles (files, or every .ini in a directory) into a store,
+// then maps it back to show what opening and a lookup cost
+static int buildProfiles(const QString &path, const QStringList &inputs)
+{
+    QStringList files;
+    for (const QString &input : inputs) {
+        const QDir dir(input);
+        if (!dir.exists()) {
+            files << input;
+            continue;
+        }
+        for (const QString &name : dir.entryList({"*.ini"}, QDir::Files, QDir::Name)) files << dir.filePath(name);
+    }
+
+    QVector<ProfileData> profiles;
+    for (const QString &file : files) {
+        ProfileData profile;
+        if (!ProfileStore::readIni(file, &profile)) {
+            qCritical() << "gert-clickd: cannot read profile" << file;
+            return 1;
+        }
+        profiles.append(profile);
+    }
+
+    QString error;
+    if (profiles.isEmpty() || !ProfileStore::write(path, profiles, &error)) {
+        qCritical().noquote() << "gert-clickd:" << (profiles.isEmpty() ? QString("no profiles") : error);
+        return 1;
+    }
+
+    ProfileStore store;
+    QElapsedTimer timer;
+    timer.start();
+    const bool opened = store.open(path);
+    const qint64 openNs = timer.nsecsElapsed();
+    if (!opened) {
+        qCritical() << "gert-clickd: cannot map" << path;
+        return 1;
+    }
+
+    const int rounds = 100000;
+    int found = 0;
+    timer.restart();
+    for (int i = 0; i < rounds; ++i) {
+        if (store.find(profiles[i % profiles.size()].name)) ++found;
+    }
+    const double lookupNs = double(timer.nsecsElapsed()) / rounds;
+    qInfo().noquote() << QString("%1 profiles in %2: mapped in %3 us, %4 ns per lookup")
+                             .arg(store.count()).arg(path).arg(openNs / 1000.0, 0, 'f', 1).arg(lookupNs, 0, 'f', 1);
+    return found == rounds ? 0 : 1;
+}
+
+// Draws intervals at a steady rate and compares them with the target
+// distribution: moments plus a Kolmogorov-Smirnov test at alpha = 0.01
+static int checkIntervals(IntervalProfile profile, int rate, int samples)
+{
+    profile.warmupSeconds = 0.0;
+    profile.waveAmplitude = 0.0;
+
+    IntervalGenerator generator;
+    generator.reset(profile, rate);
+
+    std::vector<double> intervals(samples);
+    QElapsedTimer timer;
+    timer.start();
+    for (double &interval : intervals) {
+        interval = generator.next();
+    }
+    const double nsPerInterval = double(timer.nsecsElapsed()) / samples;
+
+    double mean = 0.0, variance = 0.0;
+    for (double interval : intervals) mean += interval;
+    mean /= samples;
+    for (double interval : intervals) variance += (interval - mean) * (interval - mean);
+    const double cv = std::sqrt(variance / samples) / mean;
+
+    const double distance = generator.ksDistance(intervals);
+    const double critical = 1.628 / std::sqrt(double(samples));
+    const bool pass = profile.distribution == IntervalProfile::Fixed || distance <= critical;
+
+    const double targetCv = profile.distribution == IntervalProfile::Poisson ? 1.0
+        : profile.distribution == IntervalProfile::Fixed ? 0.0 : profile.jitter;
+    qInfo().noquote() << QString("%1 at %2/s, %3 samples: mean %4 us (target %5), cv %6 (target %7)")
+                             .arg(IntervalGenerator::distributionName(profile.distribution)).arg(rate).arg(samples)
+                             .arg(mean / 1000.0, 0, 'f', 2).arg(1e6 / rate, 0, 'f', 2)
+                             .arg(cv, 0, 'f', 4).arg(targetCv, 0, 'f', 4);
+    qInfo().noquote() << QString("ks distance %1, critical %2: %3; %4 ns per interval")
+                             .arg(distance, 0, 'f', 5).arg(critical, 0, 'f', 5)
+                             .arg(pass ? "pass" : "FAIL").arg(nsPerInterval, 0, 'f', 2);
+    return pass ? 0 : 1;
+}
+
+// Scheduling logic against a clock and no display, for exact counts and
+// the pure scheduling overhead
+static int simulate(const SimulationSettings &settings, bool realtime)
+{
+    VirtualClock virtualClock(1000000000LL); // Off zero, which the engines take for "not yet"
+    SteadyClock steadyClock;
+    ClickClock *clock = realtime ? static_cast<ClickClock *>(&steadyClock) : &virtualClock;
+
+    const SimulationResult result = ClickSimulator::run(settings, clock);
+    const QString failures = ClickSimulator::check(settings, result);
+    qInfo().noquote() << ClickSimulator::report(settings, result);
+    qInfo().noquote() << (failures.isEmpty() ? QString("checks pass") : "FAIL: " + failures);
+    return failures.isEmpty() ? 0 : 1;
+}
+
+// The monitors --position and positionMonitor can name, as the engine sees them
+static int listMonitors()
+{
+    ScreenLayout layout;
+    if (!layout.start()) {
+        qCritical() << "gert-clickd: no XRandR monitor layout on this display";
+        return 1;
+    }
+
+    for (const MonitorInfo &monitor : layout.monitors()) {
+        qInfo().noquote() << QString("%1 %2x%3+%4+%5%6")
+                                 .arg(monitor.name)
+                                 .arg(monitor.geometry.width()).arg(monitor.geometry.height())
+                                 .arg(monitor.geometry.x()).arg(monitor.geometry.y())
+                                 .arg(monitor.primary ? " primary" : "");
+    }
+    return 0;
+}
+
+// Unthrottled key actions on $DISPLAY over one connection, for the
+// sustained key event rate
+static int benchKeys(const QString &spec, int seconds)
+{
+    ClickerThread injector;
+    KeyAction action;
+    if (!injector.resolveKeyAction(spec, &action)) {
+        qCritical() << "gert-clickd: cannot map keys" << spec;
+        return 1;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    quint64 actions = 0;
+    while (timer.elapsed() < seconds * 1000LL) {
+        injector.performKeyAction(action);
+
+        // Bounded by what the server processes, not by the output buffer
+        if (++actions % 256 == 0) injector.sync();
+    }
+    injector.sync();
+
+    const double elapsed = timer.nsecsElapsed() / 1e9;
+    qInfo().noquote() << QString("keys \"%1\": %2 actions/s, %3 key events/s (%4 events per action)")
+                             .arg(spec)
+                             .arg(actions / elapsed, 0, 'f', 0)
+                             .arg(actions * action.eventCount() / elapsed, 0, 'f', 0)
+                             .arg(action.eventCount());
+    return 0;
+}
+
+static qint64 nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Each pointer backend in turn on $DISPLAY: latency from the injecting call
+// to the server's raw button press, one click at a time, then unthrottled
+// clicks sent and delivered per second
+static int benchBackends(int seconds, int samples, const QPoint &position)
+{
+    InputProbe probe;
+    QString error;
+    if (!probe.start(&error)) {
+        qCritical().noquote() << "gert-clickd: cannot watch presses:" << error;
+        return 1;
+    }
+
+    for (InjectionBackend backend : {InjectionBackend::XTest, InjectionBackend::UInputAbsolute, InjectionBackend::UInputRelative}) {
+        const QString name = ClickerThread::backendName(backend);
+        if (!ClickerThread::setBackend(backend, &error)) {
+            qInfo().noquote() << QString("%1: unavailable, %2").arg(name, error);
+            continue;
+        }
+
+        // The server opens a new kernel device asynchronously, after udev
+        ClickerThread injector;
+        if (backend != InjectionBackend::XTest) std::this_thread::sleep_for(std::chrono::seconds(1));
+        probe.drainPresses();
+
+        QVector<qint64> latencies;
+        for (int i = 0; i < samples; ++i) {
+            const qint64 sentNs = nowNs();
+            injector.performClickAt(position, ClickType::LeftClick);
+            const qint64 seenNs = probe.waitPress(500);
+            if (seenNs < 0) break;
+            latencies.append(seenNs - sentNs);
+            std::this_thread::sleep_for(std::chrono::milliseconds(2)); // Nothing left queued
+        }
+        if (latencies.isEmpty()) {
+            qInfo().noquote() << QString("%1: no press reached the server; displays without input devices, such as Xvfb, only see XTest").arg(name);
+            continue;
+        }
+        probe.drainPresses();
+        std::sort(latencies.begin(), latencies.end());
+        double totalNs = 0.0;
+        for (qint64 latency : latencies) totalNs += latency;
+
+        // Delivered presses are counted while the clicks go out, so the probe never falls behind
+        std::atomic<bool> sending(true);
+        quint64 delivered = 0;
+        std::thread counter([&]() {
+            // After the last click, until presses stop arriving
+            for (;;) {
+                const bool last = !sending.load();
+                if (probe.waitPress(last ? 200 : 50) >= 0) {
+                    delivered += 1 + probe.drainPresses();
+                } else if (last) {
+                    break;
+                }
+            }
+        });
+
+        QElapsedTimer timer;
+        timer.start();
+        quint64 sent = 0;
+        while (timer.elapsed() < seconds * 1000LL) {
+            injector.performClickAt(position, ClickType::LeftClick);
+            if (++sent % 256 == 0) injector.sync();
+        }
+        injector.sync();
+        const double elapsed = timer.nsecsElapsed() / 1e9;
+        sending = false;
+        counter.join();
+
+        qInfo().noquote() << QString("%1: latency mean %2 us, p50 %3 us, p99 %4 us, max %5 us over %6 clicks; "
+                                     "%7 clicks/s sent, %8 delivered")
+                                 .arg(name)
+                                 .arg(totalNs / latencies.size() / 1000.0, 0, 'f', 1)
+                                 .arg(latencies[latencies.size() / 2] / 1000.0, 0, 'f', 1)
+                                 .arg(latencies[(latencies.size() - 1) * 99 / 100] / 1000.0, 0, 'f', 1)
+                                 .arg(latencies.last() / 1000.0, 0, 'f', 1)
+                                 .arg(latencies.size())
+                                 .arg(sent / elapsed, 0, 'f', 0)
+                                 .arg(delivered / elapsed, 0, 'f', 0);
+    }
+
+    ClickerThread::setBackend(InjectionBackend::XTest);
+    return 0;
+}
+
+// Unthrottled scroll actions on $DISPLAY over one connection, for the
+// sustained wheel event rate with --scroll-notches per action
+static int benchScroll(ClickType type, int seconds, const QPoint &position)
+{
+    ClickerThread injector;
+    const int notches = ClickerThread::scrollNotches();
+
+    QElapsedTimer timer;
+    timer.start();
+    quint64 actions = 0;
+    while (timer.elapsed() < seconds * 1000LL) {
+        injector.performClickAt(position, type);
+
+        // Bounded by what the server processes, not by the output buffer
+        if (++actions % 256 == 0) injector.sync();
+    }
+    injector.sync();
+
+    const double elapsed = timer.nsecsElapsed() / 1e9;
+    qInfo().noquote() << QString("scroll, %1 notches per action: %2 actions/s, %3 notches/s (%4 button events/s)")
+                             .arg(notches)
+                             .arg(actions / elapsed, 0, 'f', 0)
+                             .arg(actions * notches / elapsed, 0, 'f', 0)
+                             .arg(2.0 * actions * notches / elapsed, 0, 'f', 0);
+    return 0;
+}
+
+// Unthrottled clicking on $DISPLAY with 1..maxShards connections, to find
+// where throughput stops scaling on this machine
+static int benchShards(int maxShards, int seconds, ClickType type, const QPoint &position)
+{
+    QVector<double> rates;
+    for (int shards = 1; shards <= maxShards; ++shards) {
+        ShardedInjector injector;
+        injector.setShardCount(shards);
+        injector.setClickType(type);
+        injector.setPositionSource([position](QPoint *pos) {
+            *pos = position;
+            return true;
+        });
+        if (!injector.start(0)) return 1;
+        std::this_thread::sleep_for(std::chrono::seconds(seconds));
+        injector.stop();
+
+        rates.append(injector.achievedClicksPerSecond());
+        qInfo().noquote() << QString("shards %1: %2 clicks/s (x%3 vs 1 shard)")
+                                 .arg(shards, 2)
+                                 .arg(rates.last(), 10, 'f', 0)
+                                 .arg(rates.first() > 0 ? rates.last() / rates.first() : 0.0, 0, 'f', 2);
+    }
+
+    // First K whose successor gains less than 5%
+    int knee = maxShards;
+    for (int i = 1; i < rates.size(); ++i) {
+        if (rates[i] < rates[i - 1] * 1.05) {
+            knee = i;
+            break;
+        }
+    }
+    qInfo().noquote() << QString("throughput stops scaling at %1 shard(s)").arg(knee);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    QElapsedTimer startupTimer;
+    startupTimer.start();
+
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("gert-clickd");
+    app.setApplicationVersion("1.0.0");
+    app.setOrganizationName("Garrett Uffelman");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless Gert Auto Clicker daemon");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    const QCommandLineOption configOption({"c", "config"},
+        "INI file with the GUI's settings keys plus hotkey, bindings, profileStore, controlSocket, metricsPort, targetFeed, backend and autostart.", "file");
+    const QCommandLineOption rateOption({"r", "rate"}, "Clicks per second.", "cps");
+    const QCommandLineOption buttonOption({"b", "button"}, "left, right, middle, double, triple, scroll-up, scroll-down, scroll-left or scroll-right.", "button");
+    const QCommandLineOption scrollNotchesOption("scroll-notches", "Wheel notches per scroll action, sent as one batch (default 1).", "n");
+    const QCommandLineOption backendOption("backend", "Pointer injection on Linux: xtest, uinput-abs, uinput-rel, or none to send nothing (default xtest).", "name");
+    const QCommandLineOption benchBackendsOption("bench-backends", "Compare click latency and throughput of XTest and uinput on $DISPLAY over this many single clicks, then exit.", "samples");
+    const QCommandLineOption benchScrollOption("bench-scroll", "Benchmark unthrottled scroll actions in this direction (up, down, left, right) and exit.", "direction");
+    const QCommandLineOption pressOption("press-us", "Hold each button press this long (rapid, interval and job modes).", "us");
+    const QCommandLineOption motionOption("motion", "Rapid mode: glide to new positions along linear, bezier or minjerk paths, e.g. bezier,150000,1000.", "curve[,us[,hz]]");
+    const QCommandLineOption benchMotionOption("bench-motion", "Benchmark path generation with this many points and exit.", "points");
+    const QCommandLineOption benchMatchOption("bench-match", "Benchmark template search on a 1080p frame with a template this many pixels square and exit.", "size");
+    const QCommandLineOption intervalsOption("intervals", "Random click spacing: fixed, gaussian, poisson or lognormal, with jitter as stddev/mean, e.g. gaussian,0.2.", "dist[,jitter]");
+    const QCommandLineOption warmupOption("warmup", "Ramp the rate up from a quarter to the target over this long.", "seconds");
+    const QCommandLineOption waveOption("wave", "Modulate the rate sinusoidally by this fraction over this period, e.g. 0.3,60.", "amp,seconds");
+    const QCommandLineOption checkIntervalsOption("check-intervals", "Check n generated intervals from --intervals at --rate against the target distribution and exit.", "n");
+    const QCommandLineOption simulateOption("simulate", "Run the rapid, interval or jobs engine on a virtual clock, injecting nothing, with --rate, --synthetic-jobs and --intervals, then exit.", "mode");
+    const QCommandLineOption simulateSecondsOption("simulate-seconds", "Scheduled time to replay (default 3600).", "seconds");
+    const QCommandLineOption simulateLoadOption("simulate-load", "Per-click cost and wakeup latency, plus a periodic stall, e.g. 20,5,500,60.", "cost-us[,latency-us[,stall-ms,every-s]]");
+    const QCommandLineOption simulateRealtimeOption("simulate-realtime", "Run --simulate on the steady clock, sleeping for real.");
+    const QCommandLineOption profilesOption("profiles", "Map a profile store for \"use\" on the control socket and profile:<name> hotkeys.", "file");
+    const QCommandLineOption useProfileOption("use-profile", "Start with this profile of the store.", "name");
+    const QCommandLineOption buildProfilesOption("build-profiles", "Pack the INI profiles or directories given as arguments into a store, then exit.", "file");
+    const QCommandLineOption keysOption("keys", "Press keys instead of clicking: a key, a chord such as ctrl+c, or text:string.", "spec");
+    const QCommandLineOption benchKeysOption("bench-keys", "Benchmark unthrottled key actions and exit.", "spec");
+    const QCommandLineOption gapOption("gap-us", "Gap between the presses of a double or triple click.", "us");
+    const QCommandLineOption positionOption({"p", "position"}, "Click at a fixed position, in root coordinates or relative to a monitor, e.g. 100,200 or DP-1:100,200.", "[monitor:]x,y");
+    const QCommandLineOption listMonitorsOption("list-monitors", "Print the XRandR monitor layout and exit.");
+    const QCommandLineOption intervalOption({"i", "interval"}, "Interval mode: one click every ms milliseconds.", "ms");
+    const QCommandLineOption windowOption({"w", "target-window"}, "Only click while this window (WM_CLASS or title) is mapped.", "match");
+    const QCommandLineOption triggerOption("trigger", "Click when a pixel matches a color, a region changes or a template image appears in it, e.g. pixel,400,300,ff0000,8, change,0,0,200,100 or template,0,0,800,600,button.pgm.", "spec");
+    const QCommandLineOption hotkeyOption({"k", "hotkey"}, "Global start/stop hotkey, e.g. F6 or Ctrl+Shift+F6.", "key");
+    const QCommandLineOption bindOption("bind", "Bind a key to toggle, hold, pause, burst:<n> or profile:<file>, e.g. F7=hold. Repeatable.", "keys=action");
+    const QCommandLineOption socketOption({"s", "control-socket"}, "Accept commands on this Unix domain socket (\"default\" for the runtime dir).", "path");
+    const QCommandLineOption feedOption({"f", "feed"}, "Click targets from this shared-memory feed.", "shm-name");
+    const QCommandLineOption displaysOption("displays", "Farm mode: click on every display in this list, e.g. :1,:2,:3.", "list");
+    const QCommandLineOption workersOption("workers", "Farm mode: worker threads, pinned to cores (default: one per core).", "count");
+    const QCommandLineOption statsOption("stats-interval", "Farm mode: log per-display statistics every n seconds.", "seconds");
+    const QCommandLineOption jobsOption("jobs", "Job mode: run every job in this INI file (one group per job).", "file");
+    const QCommandLineOption syntheticJobsOption("synthetic-jobs", "Job mode: n identical jobs using --rate, --button and --position.", "n");
+    const QCommandLineOption schedulerThreadsOption("scheduler-threads", "Job mode: scheduler threads (default 1).", "count");
+    const QCommandLineOption shardsOption("shards", "Rapid mode: spread clicks over this many X connections.", "count");
+    const QCommandLineOption benchShardsOption("bench-shards", "Benchmark unthrottled clicking with 1..max X connections and exit.", "max");
+    const QCommandLineOption benchSecondsOption("bench-seconds", "Duration of each benchmark step (default 2).", "seconds");
+    const QCommandLineOption traceOption("trace", "Write a Chrome/Perfetto trace of the click path to this JSON file.", "file");
+    const QCommandLineOption stagesOption("stage-counters", "Count time per click stage; printed with --stats-interval and on exit.");
+    const QCommandLineOption auditOption("audit-log", "Append every injected click to this binary log (see gert-audit).", "file");
+    const QCommandLineOption auditRotateOption("audit-rotate-mb", "Start a new audit log file after this many MB (default 64).", "mb");
+    const QCommandLineOption auditKeepOption("audit-keep", "Rotated audit log files to keep (default 8).", "count");
+    const QCommandLineOption metricsOption("metrics-port", "Serve Prometheus metrics on 127.0.0.1 at this port.", "port");
+    const QCommandLineOption startOption("start", "Start clicking immediately.");
+    const QCommandLineOption reportOption("report-startup", "Log startup time and resident memory once ready.");
+    parser.addOptions({ configOption, rateOption, buttonOption, pressOption, gapOption, positionOption, intervalOption, windowOption, triggerOption,
+                        hotkeyOption, bindOption, socketOption, feedOption, displaysOption, workersOption,
+                        statsOption, jobsOption, syntheticJobsOption, schedulerThreadsOption,
+                        shardsOption, benchShardsOption, benchSecondsOption, keysOption, benchKeysOption,
+                        scrollNotchesOption, benchScrollOption, backendOption, benchBackendsOption,
+                        motionOption, benchMotionOption, benchMatchOption, intervalsOption, warmupOption, waveOption, checkIntervalsOption,
+                        simulateOption, simulateSecondsOption, simulateLoadOption, simulateRealtimeOption,
+                        profilesOption, useProfileOption, buildProfilesOption, listMonitorsOption,
+                        traceOption, stagesOption, auditOption, auditRotateOption, auditKeepOption, metricsOption,
+                        startOption, reportOption });
+    parser.addPositionalArgument("profiles", "INI profiles or directories for --build-profiles.", "[profiles...]");
+    parser.process(app);
+
+    // Interval profile; like the timing it overrides the config file and every job
+    const bool intervalsSet = parser.isSet(intervalsOption) || parser.isSet(warmupOption) || parser.isSet(waveOption);
+    IntervalProfile intervals;
+    bool okWarmup = true;
+    if (parser.isSet(warmupOption)) intervals.warmupSeconds = parser.value(warmupOption).toDouble(&okWarmup);
+    if ((parser.isSet(intervalsOption) && !IntervalGenerator::parse(parser.value(intervalsOption), &intervals)) ||
+        (parser.isSet(waveOption) && !IntervalGenerator::parseWave(parser.value(waveOption), &intervals)) ||
+        !okWarmup || intervals.warmupSeconds < 0.0) {
+        qCritical() << "gert-clickd: invalid interval profile";
+        return 1;
+    }
+
+    if (parser.isSet(checkIntervalsOption)) {
+        const int samples = parser.value(checkIntervalsOption).toInt();
+        const int rate = parser.isSet(rateOption) ? parser.value(rateOption).toInt() : 10;
+        if (samples < 100 || rate <= 0) {
+            qCritical() << "gert-clickd: invalid check settings";
+            return 1;
+        }
+        return checkIntervals(intervals, rate, samples);
+    }
+
+    if (parser.isSet(buildProfilesOption)) {
+        return buildProfiles(parser.value(buildProfilesOption), parser.positionalArguments());
+    }
+
+    if (parser.isSet(listMonitorsOption)) {
+        return listMonitors();
+    }
+
+    if (parser.isSet(simulateOption)) {
+        SimulationSettings settings;
+        settings.intervals = intervals;
+        bool okRate = true, okJobs = true, okSeconds = true;
+        if (parser.isSet(rateOption)) settings.clicksPerSecond = parser.value(rateOption).toInt(&okRate);
+        if (parser.isSet(syntheticJobsOption)) settings.jobs = parser.value(syntheticJobsOption).toInt(&okJobs);
+        if (parser.isSet(simulateSecondsOption)) settings.seconds = parser.value(simulateSecondsOption).toDouble(&okSeconds);
+
+        const QStringList load = parser.value(simulateLoadOption).split(',', Qt::SkipEmptyParts);
+        bool okLoad = load.size() <= 2 || load.size() == 4;
+        for (int i = 0; i < load.size() && okLoad; ++i) {
+            const double value = load[i].toDouble(&okLoad);
+            const qint64 scale = i == 2 ? 1000000 : i == 3 ? 1000000000 : 1000;
+            const qint64 ns = qint64(value * scale);
+            okLoad = okLoad && value >= 0.0;
+            if (i == 0) settings.clickCostNs = ns;
+            if (i == 1) settings.wakeLatencyNs = ns;
+            if (i == 2) settings.stallNs = ns;
+            if (i == 3) settings.stallEveryNs = ns;
+        }
+
+        if (!ClickSimulator::parseMode(parser.value(simulateOption), &settings.mode) || !okRate || !okJobs ||
+            !okSeconds || !okLoad || settings.clicksPerSecond <= 0 || settings.clicksPerSecond > 10000 ||
+            settings.jobs <= 0 || settings.seconds <= 0.0 || (load.size() == 4 && settings.stallEveryNs <= 0)) {
+            qCritical() << "gert-clickd: invalid simulation settings";
+            return 1;
+        }
+        return simulate(settings, parser.isSet(simulateRealtimeOption));
+    }
+
+    if (parser.isSet(benchMotionOption)) {
+        const int points = parser.value(benchMotionOption).toInt();
+        if (points < 2) {
+            qCritical() << "gert-clickd: invalid benchmark settings";
+            return 1;
+        }
+        return benchMotion(points);
+    }
+
+    if (parser.isSet(benchMatchOption)) {
+        const int size = parser.value(benchMatchOption).toInt();
+        if (size < 4 || size > 512) {
+            qCritical() << "gert-clickd: invalid benchmark settings";
+            return 1;
+        }
+        return benchMatch(size);
+    }
+
+    // Process-wide, so it holds for every mode below
+    if (parser.isSet(scrollNotchesOption)) {
+        bool ok = false;
+        const int notches = parser.value(scrollNotchesOption).toInt(&ok);
+        if (!ok || notches <= 0) {
+            qCritical() << "gert-clickd: invalid scroll notches" << parser.value(scrollNotchesOption);
+            return 1;
+        }
+        ClickerThread::setScrollNotches(notches);
+    }
+
+    if (parser.isSet(benchBackendsOption)) {
+        QPoint position(10, 10);
+        const int samples = parser.value(benchBackendsOption).toInt();
+        const int seconds = parser.isSet(benchSecondsOption) ? parser.value(benchSecondsOption).toInt() : 2;
+        if ((parser.isSet(positionOption) && !parsePosition(parser.value(positionOption), &position)) ||
+            samples <= 0 || seconds <= 0) {
+            qCritical() << "gert-clickd: invalid benchmark settings";
+            return 1;
+        }
+        return benchBackends(seconds, samples, position);
+    }
+
+    if (parser.isSet(benchScrollOption)) {
+        ClickType type;
+        QPoint position(10, 10);
+        const int seconds = parser.isSet(benchSecondsOption) ? parser.value(benchSecondsOption).toInt() : 2;
+        if (!parseClickType("scroll-" + parser.value(benchScrollOption), &type) ||
+            (parser.isSet(positionOption) && !parsePosition(parser.value(positionOption), &position)) || seconds <= 0) {
+            qCritical() << "gert-clickd: invalid benchmark settings";
+            return 1;
+        }
+        return benchScroll(type, seconds, position);
+    }
+
+    if (parser.isSet(benchKeysOption)) {
+        const int seconds = parser.isSet(benchSecondsOption) ? parser.value(benchSecondsOption).toInt() : 2;
+        if (seconds <= 0) {
+            qCritical() << "gert-clickd: invalid benchmark settings";
+            return 1;
+        }
+        return benchKeys(parser.value(benchKeysOption), seconds);
+    }
+
+    if (parser.isSet(benchShardsOption)) {
+        ClickType type = ClickType::LeftClick;
+        QPoint position(10, 10);
+        const int maxShards = parser.value(benchShardsOption).toInt();
+        const int seconds = parser.isSet(benchSecondsOption) ? parser.value(benchSecondsOption).toInt() : 2;
+        if ((parser.isSet(buttonOption) && !parseClickType(parser.value(buttonOption), &type)) ||
+            (parser.isSet(positionOption) && !parsePosition(parser.value(positionOption), &position)) ||
+            maxShards <= 0 || seconds <= 0) {
+            qCritical() << "gert-clickd: invalid benchmark settings";
+            return 1;
+        }
+        return benchShards(maxShards, seconds, type, position);
+    }
+
+    // Set up signal handlers for graceful termination
+    std::signal(SIGINT, signalHandler);
+    std::signal(SIGTERM, signalHandler);
+
+    // Reported on every return path below, after the engines have stopped
+    struct Diagnostics {
+        ~Diagnostics()
+        {
+            if (StageCounters::isEnabled()) qInfo().noquote() << StageCounters::report();
+            if (AuditLog::isEnabled()) {
+                AuditLog::close();
+                qInfo().noquote() << QString("gert-clickd: audit log closed, %1 records, %2 dropped")
+                                         .arg(AuditLog::writtenCount()).arg(AuditLog::droppedCount());
+            }
+            if (!ClickTrace::isEnabled()) return;
+            ClickTrace::stop();
+            qInfo().noquote() << QString("gert-clickd: trace written, %1 events, %2 dropped")
+                                     .arg(ClickTrace::writtenEvents()).arg(ClickTrace::droppedEvents());
+        }
+    } diagnostics;
+    if (parser.isSet(stagesOption)) StageCounters::setEnabled(true);
+    if (parser.isSet(auditOption)) {
+        bool okRotate = true, okKeep = true;
+        const int rotateMb = parser.isSet(auditRotateOption) ? parser.value(auditRotateOption).toInt(&okRotate) : 64;
+        const int keep = parser.isSet(auditKeepOption) ? parser.value(auditKeepOption).toInt(&okKeep) : 8;
+        if (!okRotate || !okKeep || rotateMb <= 0 || keep < 0 ||
+            !AuditLog::open(parser.value(auditOption), qint64(rotateMb) << 20, keep)) {
+            qCritical() << "gert-clickd: cannot open audit log" << parser.value(auditOption);
+            return 1;
+        }
+    }
+    if (parser.isSet(traceOption) && !ClickTrace::start(parser.value(traceOption))) {
+        qCritical() << "gert-clickd: cannot write trace" << parser.value(traceOption);
+        return 1;
+    }
+
+    // Farm-mode keys; without a config file every lookup returns its default
+    std::unique_ptr<QSettings> config;
+    if (parser.isSet(configOption)) config.reset(new QSettings(parser.value(configOption), QSettings::IniFormat));
+    auto configValue = [&config](const QString &key, const QVariant &defaultValue) {
+        return config ? config->value(key, defaultValue) : defaultValue;
+    };
+
+    // Counted in every mode; scrapes read only what the click threads publish
+    MetricsServer metricsServer;
+    bool okMetrics = true;
+    const int metricsPort = parser.isSet(metricsOption) ? parser.value(metricsOption).toInt(&okMetrics)
+                                                        : configValue("metricsPort", 0).toInt();
+    if (!okMetrics || metricsPort < 0 || metricsPort > 65535) {
+        qCritical() << "gert-clickd: invalid metrics port";
+        return 1;
+    }
+    if (metricsPort) {
+        ClickMetrics::setEnabled(true);
+        if (!metricsServer.listen(quint16(metricsPort))) return 1;
+    }
+
+    QStringList displays = configValue("displays", QString()).toString().split(',', Qt::SkipEmptyParts);
+    if (parser.isSet(displaysOption)) displays = parser.value(displaysOption).split(',', Qt::SkipEmptyParts);
+
+    // Every mode on $DISPLAY injects through it; a missing /dev/uinput leaves XTest in use.
+    // A uinput device is the local pointer, so farm sessions on their own displays keep XTest.
+    const QString backendName = parser.isSet(backendOption) ? parser.value(backendOption)
+                                                            : configValue("backend", "xtest").toString();
+    InjectionBackend backend;
+    if (!ClickerThread::parseBackend(backendName, &backend)) {
+        qCritical() << "gert-clickd: invalid backend" << backendName;
+        return 1;
+    }
+    const bool uinputBackend = backend == InjectionBackend::UInputAbsolute || backend == InjectionBackend::UInputRelative;
+    QString backendError;
+    if (uinputBackend && !displays.isEmpty()) {
+        qWarning() << "gert-clickd: uinput clicks the local desktop, not the farm displays; using XTest";
+    } else if (backend != InjectionBackend::XTest && !ClickerThread::setBackend(backend, &backendError)) {
+        qWarning().noquote() << "gert-clickd: falling back to XTest:" << backendError;
+    }
+
+    // Press/release timing; overrides the config file and every job
+    const bool timingSet = parser.isSet(pressOption) || parser.isSet(gapOption);
+    ClickTiming timing;
+    bool okPress = true, okGap = true;
+    if (parser.isSet(pressOption)) timing.pressUs = parser.value(pressOption).toInt(&okPress);
+    if (parser.isSet(gapOption)) timing.gapUs = parser.value(gapOption).toInt(&okGap);
+    if (!okPress || !okGap || timing.pressUs < 0 || timing.gapUs < 0) {
+        qCritical() << "gert-clickd: invalid press/gap timing";
+        return 1;
+    }
+
+    if (parser.isSet(jobsOption) || parser.isSet(syntheticJobsOption)) {
+        QVector<ClickJob> jobs;
+        if (parser.isSet(jobsOption) && !loadJobs(parser.value(jobsOption), &jobs)) {
+            qCritical() << "gert-clickd: cannot load jobs" << parser.value(jobsOption);
+            return 1;
+        }
+
+        if (parser.isSet(syntheticJobsOption)) {
+            ClickJob job;
+            job.clicksPerSecond = parser.isSet(rateOption) ? parser.value(rateOption).toInt() : 10;
+            if ((parser.isSet(buttonOption) && !parseClickType(parser.value(buttonOption), &job.clickType)) ||
+                (parser.isSet(positionOption) && !parsePosition(parser.value(positionOption), &job.position)) ||
+                job.clicksPerSecond <= 0) {
+                qCritical() << "gert-clickd: invalid job settings";
+                return 1;
+            }
+            for (int i = parser.value(syntheticJobsOption).toInt(); i > 0; --i) {
+                jobs.append(job);
+            }
+        }
+
+        for (ClickJob &job : jobs) {
+            if (timingSet) job.timing = timing;
+            if (parser.isSet(keysOption)) job.keys = parser.value(keysOption);
+            if (intervalsSet) job.intervals = intervals;
+        }
+
+        const int threads = parser.isSet(schedulerThreadsOption) ? parser.value(schedulerThreadsOption).toInt() : 1;
+        const int statsInterval = parser.isSet(statsOption) ? parser.value(statsOption).toInt() : 0;
+        if (jobs.isEmpty() || threads <= 0) {
+            qCritical() << "gert-clickd: no jobs to run";
+            return 1;
+        }
+        return runJobs(app, jobs, threads, statsInterval);
+    }
+
+    if (!displays.isEmpty()) {
+        int rate = configValue("clicksPerSecond", 10).toInt();
+        ClickType type = static_cast<ClickType>(configValue("clickType", 0).toInt());
+        QPoint position(configValue("positionX", 0).toInt(), configValue("positionY", 0).toInt());
+        int workers = configValue("workers", 0).toInt();
+        int statsInterval = configValue("statsInterval", 0).toInt();
+
+        if (parser.isSet(rateOption)) rate = parser.value(rateOption).toInt();
+        if (parser.isSet(workersOption)) workers = parser.value(workersOption).toInt();
+        if (parser.isSet(statsOption)) statsInterval = parser.value(statsOption).toInt();
+        if ((parser.isSet(buttonOption) && !parseClickType(parser.value(buttonOption), &type)) ||
+            (parser.isSet(positionOption) && !parsePosition(parser.value(positionOption), &position)) ||
+            rate <= 0 || workers < 0) {
+            qCritical() << "gert-clickd: invalid farm settings";
+            return 1;
+        }
+
+        if (parser.isSet(reportOption)) {
+            QTimer::singleShot(0, &app, [&startupTimer]() {
+                ProcessStats::reportStartup("gert-clickd", startupTimer);
+            });
+        }
+        return runFarm(app, displays, workers, rate, type, position, statsInterval);
+    }
+
+    // Declared first: the engine points into it while a stored profile is in use
+    ProfileStore profiles;
+    AutoClicker clicker;
+
+    QString hotkey;
+    QStringList bindings;
+    QString storePath;
+    QString socketPath;
+    QString feedName;
+    bool feedEnabled = false;
+    bool autostart = parser.isSet(startOption);
+
+    if (parser.isSet(configOption)) {
+        const QString file = parser.value(configOption);
+        if (!clicker.loadProfile(file)) {
+            qCritical() << "gert-clickd: cannot load config" << file;
+            return 1;
+        }
+
+        const QSettings config(file, QSettings::IniFormat);
+        hotkey = config.value("hotkey").toString();
+        bindings = config.value("bindings").toStringList();
+        storePath = config.value("profileStore").toString();
+        socketPath = config.value("controlSocket").toString();
+        feedEnabled = config.contains("targetFeed");
+        feedName = config.value("targetFeed").toString();
+        autostart = autostart || config.value("autostart", false).toBool();
+    }
+
+    if (parser.isSet(rateOption)) {
+        bool ok = false;
+        const int cps = parser.value(rateOption).toInt(&ok);
+        if (!ok || cps <= 0) {
+            qCritical() << "gert-clickd: invalid rate" << parser.value(rateOption);
+            return 1;
+        }
+        clicker.setClicksPerSecond(cps);
+    }
+
+    if (parser.isSet(buttonOption)) {
+        ClickType type;
+        if (!parseClickType(parser.value(buttonOption), &type)) {
+            qCritical() << "gert-clickd: invalid button" << parser.value(buttonOption);
+            return 1;
+        }
+        clicker.setClickType(type);
+    }
+
+    // Already checked above; set again because the config file may have changed it
+    if (parser.isSet(scrollNotchesOption)) {
+        clicker.setScrollNotches(parser.value(scrollNotchesOption).toInt());
+    }
+
+    if (parser.isSet(positionOption)) {
+        QString monitor;
+        QPoint position;
+        if (!ScreenLayout::parsePosition(parser.value(positionOption), &monitor, &position) ||
+            !clicker.setClickPosition(position, monitor)) {
+            qCritical() << "gert-clickd: invalid position" << parser.value(positionOption);
+            return 1;
+        }
+    }
+
+    if (parser.isSet(intervalOption)) {
+        bool ok = false;
+        const int ms = parser.value(intervalOption).toInt(&ok);
+        if (!ok || ms <= 0) {
+            qCritical() << "gert-clickd: invalid interval" << parser.value(intervalOption);
+            return 1;
+        }
+        clicker.setIntervalClick(true, ms);
+    }
+
+    if (parser.isSet(shardsOption)) {
+        bool ok = false;
+        const int shards = parser.value(shardsOption).toInt(&ok);
+        if (!ok || shards <= 0) {
+            qCritical() << "gert-clickd: invalid shard count" << parser.value(shardsOption);
+            return 1;
+        }
+        clicker.setInjectionShards(shards);
+    }
+
+    if (timingSet) clicker.setClickTiming(timing);
+    if (intervalsSet) clicker.setIntervalProfile(intervals);
+
+    if (parser.isSet(motionOption)) {
+        MotionSettings motion;
+        if (!MotionPath::parse(parser.value(motionOption), &motion)) {
+            qCritical() << "gert-clickd: invalid motion" << parser.value(motionOption);
+            return 1;
+        }
+        clicker.setMotion(motion);
+    }
+
+    if (parser.isSet(keysOption) && !clicker.setKeyAction(parser.value(keysOption))) {
+        qCritical() << "gert-clickd: cannot map keys" << parser.value(keysOption);
+        return 1;
+    }
+
+    if (parser.isSet(triggerOption)) {
+        ScreenTrigger trigger;
+        if (!ScreenWatcher::parseTrigger(parser.value(triggerOption), &trigger)) {
+            qCritical() << "gert-clickd: invalid trigger" << parser.value(triggerOption);
+            return 1;
+        }
+        if (!clicker.setScreenTrigger(true, trigger)) return 1;
+    }
+
+    if (parser.isSet(windowOption)) clicker.setTargetWindow(parser.value(windowOption));
+    if (parser.isSet(hotkeyOption)) hotkey = parser.value(hotkeyOption);
+    if (parser.isSet(bindOption)) bindings = parser.values(bindOption);
+    if (parser.isSet(profilesOption)) storePath = parser.value(profilesOption);
+    if (parser.isSet(socketOption)) socketPath = parser.value(socketOption);
+    if (parser.isSet(feedOption)) {
+        feedEnabled = true;
+        feedName = parser.value(feedOption);
+    }
+
+    if (feedEnabled && !clicker.setTargetFeed(true, feedName)) {
+        return 1;
+    }
+
+    // The hotkey is a toggle binding ahead of the rest of the table
+    QVector<HotkeyBinding> table;
+    if (!hotkey.isEmpty()) {
+        HotkeyBinding binding;
+        binding.keys = hotkey;
+        table.append(binding);
+    }
+    for (const QString &text : bindings) {
+        HotkeyBinding binding;
+        if (!HotkeyManager::parseBinding(text.trimmed(), &binding)) {
+            qCritical() << "gert-clickd: invalid binding" << text;
+            return 1;
+        }
+        table.append(binding);
+    }
+
+    HotkeyManager hotkeys;
+    HotkeyDispatcher dispatcher(&hotkeys, &clicker);
+    if (!table.isEmpty() && !hotkeys.setBindings(table)) {
+        qCritical() << "gert-clickd: cannot register hotkeys";
+        return 1;
+    }
+    QObject::connect(&dispatcher, &HotkeyDispatcher::holdMeasured, [](qint64 pressNs, qint64 releaseNs) {
+        if (pressNs < 0) {
+            qInfo() << "gert-clickd: hold released before the first click";
+        } else {
+            qInfo().noquote() << QString("gert-clickd: hold press to first click %1 us, release to last click %2 us")
+                                     .arg(pressNs / 1000.0, 0, 'f', 1).arg(releaseNs / 1000.0, 0, 'f', 1);
+        }
+    });
+
+    ControlServer controlServer(&clicker);
+    if (!storePath.isEmpty()) {
+        QElapsedTimer timer;
+        timer.start();
+        if (!profiles.open(storePath)) {
+            qCritical() << "gert-clickd: cannot open profile store" << storePath;
+            return 1;
+        }
+        qInfo().noquote() << QString("gert-clickd: %1 profiles mapped in %2 us")
+                                 .arg(profiles.count()).arg(timer.nsecsElapsed() / 1000.0, 0, 'f', 1);
+        controlServer.setProfileStore(&profiles);
+        dispatcher.setProfileStore(&profiles);
+    }
+    if (parser.isSet(useProfileOption)) {
+        const StoredProfile *profile = profiles.find(parser.value(useProfileOption));
+        if (!profile) {
+            qCritical() << "gert-clickd: no profile" << parser.value(useProfileOption);
+            return 1;
+        }
+        clicker.useProfile(profile);
+    }
+    if (!socketPath.isEmpty()) {
+        if (socketPath == "default") socketPath = ControlServer::defaultSocketPath();
+        if (!controlServer.listen(socketPath)) return 1;
+    }
+
+    QObject::connect(&clicker, &AutoClicker::statusChanged, [](const QString &status) {
+        qInfo().noquote() << "gert-clickd:" << status;
+    });
+
+    if (autostart) clicker.start();
+
+    if (parser.isSet(reportOption)) {
+        QTimer::singleShot(0, &app, [&startupTimer]() {
+            ProcessStats::reportStartup("gert-clickd", startupTimer);
+        });
+    }
+
+    const int result = app.exec();
+
+    clicker.stop();
+    controlServer.close();
+    if (!dispatcher.holdReport().isEmpty()) qInfo().noquote() << "gert-clickd:" << dispatcher.holdReport();
+    return result;
+}
@@ -1,7 +1,10 @@
 #include "clickerthread.h"
+#include "auditlog.h"
+#include "stagecounters.h"
+#include "uinputdevice.h"
 #include <QDebug>
-#include <QApplication>
-#include <QCursor>
+#include <QMutexLocker>
+#include <memory>
 
 #ifdef Q_OS_WIN
 #include <windows.h>
@@ -10,15 +13,45 @@
 #include <CoreFoundation/CoreFoundation.h>
 #else
 #include <X11/Xlib.h>
+#include <X11/XKBlib.h>
+#include <X11/keysym.h>
 #include <X11/extensions/XTest.h>
 #endif
 
+std::atomic<int> ClickerThread::notchCount(1);
+std::atomic<InjectionBackend> ClickerThread::injectionBackend(InjectionBackend::XTest);
+std::atomic<UInputDevice *> ClickerThread::uinput(nullptr);
+std::atomic<int> ClickerThread::backendHolds(0);
+
+// Size of the root window, which an absolute uinput device spans
+static QSize rootSize()
+{
+#if !defined(Q_OS_WIN) && !defined(Q_OS_MAC)
+    Display *display = XOpenDisplay(nullptr);
+    if (!display) return QSize();
+    const QSize size(DisplayWidth(display, DefaultScreen(display)), DisplayHeight(display, DefaultScreen(display)));
+    XCloseDisplay(display);
+    return size;
+#else
+    return QSize();
+#endif
+}
+
 ClickerThread::ClickerThread(QObject *parent)
+    : ClickerThread(QString(), parent)
+{
+}
+
+ClickerThread::ClickerThread(const QString &displayName, QObject *parent)
     : QThread(parent)
     , clickType(ClickType::LeftClick)
+    , clickPosition(0)
     , useCurrentPosition(true)
     , shouldClick(false)
     , running(false)
+    , sessionDisplay(displayName)
+    , display(nullptr)
+    , displayWarned(false)
 {
 }
 
@@ -28,16 +61,119 @@ ClickerThread::~ClickerThread()
     condition.wakeAll();
     quit();
     wait();
+    
+#if !defined(Q_OS_WIN) && !defined(Q_OS_MAC)
+    if (display) {
+        XCloseDisplay(display);
+        display = nullptr;
+    }
+#endif
+}
+
+QString ClickerThread::displayName() const
+{
+    return sessionDisplay;
+}
+
+void ClickerThread::setScrollNotches(int notches)
+{
+    notchCount.store(qBound(1, notches, 1000), std::memory_order_relaxed);
+}
+
+int ClickerThread::scrollNotches()
+{
+    return notchCount.load(std::memory_order_relaxed);
+}
+
+bool ClickerThread::setBackend(InjectionBackend backend, QString *error)
+{
+    static QMutex backendMutex;
+    QMutexLocker locker(&backendMutex);
+    
+    // Clicking threads load the device without a lock, so it cannot go while they run
+    if (backendHolds.load() > 0) {
+        if (error) *error = "an engine is clicking";
+        return false;
+    }
+    
+    std::unique_ptr<UInputDevice> device;
+    if (backend == InjectionBackend::UInputAbsolute || backend == InjectionBackend::UInputRelative) {
+        device.reset(new UInputDevice);
+        if (!device->open(backend == InjectionBackend::UInputAbsolute, rootSize(), error)) return false;
+    }
+    
+    // No engine is running, so nothing is clicking through the old device
+    delete uinput.exchange(device.release(), std::memory_order_acq_rel);
+    injectionBackend = backend;
+    return true;
+}
+
+InjectionBackend ClickerThread::backend()
+{
+    return injectionBackend.load(std::memory_order_relaxed);
+}
+
+QString ClickerThread::backendName(InjectionBackend backend)
+{
+    switch (backend) {
+        case InjectionBackend::UInputAbsolute:
+            return "uinput-abs";
+        case InjectionBackend::UInputRelative:
+            return "uinput-rel";
+        case InjectionBackend::Discard:
+            return "none";
+        default:
+            return "xtest";
+    }
+}
+
+bool ClickerThread::parseBackend(const QString &name, InjectionBackend *backend)
+{
+    const QString lower = name.toLower();
+    if (lower == "xtest") {
+        *backend = InjectionBackend::XTest;
+    } else if (lower == "uinput-abs" || lower == "uinput") {
+        *backend = InjectionBackend::UInputAbsolute;
+    } else if (lower == "uinput-rel") {
+        *backend = InjectionBackend::UInputRelative;
+    } else if (lower == "none") {
+        *backend = InjectionBackend::Discard;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool ClickerThread::discarding()
+{
+    return injectionBackend.load(std::memory_order_relaxed) == InjectionBackend::Discard;
+}
+
+void ClickerThread::holdBackend()
+{
+    backendHolds.fetch_add(1);
+}
+
+void ClickerThread::releaseBackend()
+{
+    backendHolds.fetch_sub(1);
+}
+
+// The device is a local kernel pointer: a session on a display of its own,
+// such as a farm's Xvfb, would click the local desktop through it
+UInputDevice *ClickerThread::sessionDevice() const
+{
+    return sessionDisplay.isEmpty() ? uinput.load(std::memory_order_acquire) : nullptr;
 }
 
 void ClickerThread::setClickType(ClickType type)
 {
-    clickType = type;
+    clickType.store(type, std::memory_order_relaxed);
 }
 
 void ClickerThread::setClickPosition(const QPoint &pos)
 {
-    clickPosition = pos;
+    clickPosition.store(packPoint(pos), std::memory_order_relaxed);
 }
 
 void ClickerThread::setUseCurrentPosition(bool useCurrent)
@@ -51,12 +187,99 @@ void ClickerThread::performClick()
     const bool useCurrent = useCurrentPosition.load(std::memory_order_relaxed);
     
     // Get position and type with minimal overhead
-    const QPoint currentPos = useCurrent ? QCursor::pos() : clickPosition;
-    const ClickType currentType = clickType;
+    const QPoint currentPos = useCurrent ? currentPosition() : unpackPoint(clickPosition.load(std::memory_order_relaxed));
+    const ClickType currentType = clickType.load(std::memory_order_relaxed);
     
     performMouseClick(currentType, currentPos);
 }
 
+void ClickerThread::performClickAt(const QPoint &pos)
+{
+    performMouseClick(clickType.load(std::memory_order_relaxed), pos);
+}
+
+void ClickerThread::performClickAt(const QPoint &pos, ClickType type)
+{
+    performMouseClick(type, pos);
+}
+
+void ClickerThread::pressButton(const QPoint &pos, ClickType type)
+{
+    if (discarding()) return;
+    if (sendButton(type, pos, true)) AuditLog::record(AuditLog::Press, pos, type);
+}
+
+void ClickerThread::releaseButton(const QPoint &pos, ClickType type)
+{
+    if (discarding()) return;
+    if (sendButton(type, pos, false)) AuditLog::record(AuditLog::Release, pos, type);
+}
+
+QPoint ClickerThread::cursorPosition()
+{
+#ifdef Q_OS_WIN
+    POINT point;
+    if (!GetCursorPos(&point)) return QPoint();
+    return QPoint(point.x, point.y);
+#elif defined(Q_OS_MAC)
+    CGEventRef event = CGEventCreate(nullptr);
+    if (!event) return QPoint();
+    const CGPoint point = CGEventGetLocation(event);
+    CFRelease(event);
+    return QPoint(static_cast<int>(point.x), static_cast<int>(point.y));
+#else
+    StageScope scope(ClickStage::Position);
+    
+    // One connection for pointer queries, shared by all clicking threads
+    static QMutex displayMutex;
+    static Display *display = nullptr;
+    
+    QMutexLocker locker(&displayMutex);
+    if (!display) {
+        display = XOpenDisplay(nullptr);
+        if (!display) return QPoint();
+    }
+    
+    Window rootReturn, childReturn;
+    int rootX = 0, rootY = 0, winX = 0, winY = 0;
+    unsigned int mask = 0;
+    XQueryPointer(display, DefaultRootWindow(display), &rootReturn, &childReturn,
+                  &rootX, &rootY, &winX, &winY, &mask);
+    return QPoint(rootX, rootY);
+#endif
+}
+
+void ClickerThread::sync()
+{
+#if !defined(Q_OS_WIN) && !defined(Q_OS_MAC)
+    StageScope scope(ClickStage::Sync);
+    StageScope lock(ClickStage::Lock);
+    QMutexLocker locker(&displayMutex);
+    lock.finish();
+    if (display) XSync(display, False);
+#endif
+}
+
+// Pointer position on this session's display
+QPoint ClickerThread::currentPosition()
+{
+#if !defined(Q_OS_WIN) && !defined(Q_OS_MAC)
+    if (!sessionDisplay.isEmpty()) {
+        StageScope scope(ClickStage::Position);
+        QMutexLocker locker(&displayMutex);
+        if (!openDisplay()) return QPoint();
+        
+        Window rootReturn, childReturn;
+        int rootX = 0, rootY = 0, winX = 0, winY = 0;
+        unsigned int mask = 0;
+        XQueryPointer(display, DefaultRootWindow(display), &rootReturn, &childReturn,
+                      &rootX, &rootY, &winX, &winY, &mask);
+        return QPoint(rootX, rootY);
+    }
+#endif
+    return cursorPosition();
+}
+
 void ClickerThread::run()
 {
     running = true;
@@ -73,8 +296,8 @@ void ClickerThread::run()
         }
         
         shouldClick = false;
-        QPoint pos = useCurrentPosition ? QCursor::pos() : clickPosition;
-        ClickType type = clickType;
+        QPoint pos = useCurrentPosition ? currentPosition() : unpackPoint(clickPosition.load(std::memory_order_relaxed));
+        ClickType type = clickType.load(std::memory_order_relaxed);
         mutex.unlock();
         
         performMouseClick(type, pos);
@@ -83,17 +306,21 @@ void ClickerThread::run()
 
 void ClickerThread::performMouseClick(ClickType type, const QPoint &pos)
 {
+    if (discarding()) return;
+    
+    // The audit log records only what was actually sent
 #ifdef Q_OS_WIN
-    performWindowsClick(type, pos);
+    const bool sent = performWindowsClick(type, pos);
 #elif defined(Q_OS_MAC)
-    performMacClick(type, pos);
+    const bool sent = performMacClick(type, pos);
 #else
-    performLinuxClick(type, pos);
+    const bool sent = performLinuxClick(type, pos);
 #endif
+    if (sent) AuditLog::record(AuditLog::Click, pos, type);
 }
 
 #ifdef Q_OS_WIN
-void ClickerThread::performWindowsClick(ClickType type, const QPoint &pos)
+bool ClickerThread::performWindowsClick(ClickType type, const QPoint &pos)
 {
     INPUT input[3] = {};
     int inputCount = 0;
@@ -105,6 +332,17 @@ void ClickerThread::performWindowsClick(ClickType type, const QPoint &pos)
     input[inputCount].mi.dwFlags = MOUSEEVENTF_MOVE | MOUSEEVENTF_ABSOLUTE;
     inputCount++;
     
+    // One wheel event carries every notch
+    if (isScroll(type)) {
+        const bool horizontal = type == ClickType::ScrollLeft || type == ClickType::ScrollRight;
+        const int sign = type == ClickType::ScrollUp || type == ClickType::ScrollRight ? 1 : -1;
+        input[inputCount].type = INPUT_MOUSE;
+        input[inputCount].mi.mouseData = DWORD(sign * scrollNotches() * WHEEL_DELTA);
+        input[inputCount].mi.dwFlags = horizontal ? MOUSEEVENTF_HWHEEL : MOUSEEVENTF_WHEEL;
+        inputCount++;
+        return SendInput(inputCount, input, sizeof(INPUT)) == UINT(inputCount);
+    }
+    
     // Mouse button events
     DWORD downFlag = 0, upFlag = 0;
     
@@ -121,7 +359,7 @@ void ClickerThread::performWindowsClick(ClickType type, const QPoint &pos)
             downFlag = MOUSEEVENTF_MIDDLEDOWN;
             upFlag = MOUSEEVENTF_MIDDLEUP;
             break;
-        case ClickType::DoubleClick:
+        default:
             downFlag = MOUSEEVENTF_LEFTDOWN;
             upFlag = MOUSEEVENTF_LEFTUP;
             break;
@@ -137,27 +375,75 @@ void ClickerThread::performWindowsClick(ClickType type, const QPoint &pos)
     input[inputCount].mi.dwFlags = upFlag;
     inputCount++;
     
-    SendInput(inputCount, input, sizeof(INPUT));
+    bool sent = SendInput(inputCount, input, sizeof(INPUT)) == UINT(inputCount);
     
-    // For double click, add a second click
-    if (type == ClickType::DoubleClick) {
+    // For double and triple clicks, add the remaining presses
+    for (int press = 1; press < pressCount(type); ++press) {
         // Minimal delay for ultra-high speed double clicks
         input[0].type = INPUT_MOUSE;
         input[0].mi.dwFlags = downFlag;
         input[1].type = INPUT_MOUSE;
         input[1].mi.dwFlags = upFlag;
         
-        SendInput(2, input, sizeof(INPUT));
+        sent = SendInput(2, input, sizeof(INPUT)) == 2 && sent;
+    }
+    return sent;
+}
+
+bool ClickerThread::sendButton(ClickType type, const QPoint &pos, bool down)
+{
+    INPUT input[2] = {};
+    int inputCount = 0;
+    
+    // The press moves the cursor; the release happens wherever it is
+    if (down) {
+        input[inputCount].type = INPUT_MOUSE;
+        input[inputCount].mi.dx = pos.x() * (65535 / GetSystemMetrics(SM_CXSCREEN));
+        input[inputCount].mi.dy = pos.y() * (65535 / GetSystemMetrics(SM_CYSCREEN));
+        input[inputCount].mi.dwFlags = MOUSEEVENTF_MOVE | MOUSEEVENTF_ABSOLUTE;
+        inputCount++;
+    }
+    
+    input[inputCount].type = INPUT_MOUSE;
+    switch (type) {
+        case ClickType::RightClick:
+            input[inputCount].mi.dwFlags = down ? MOUSEEVENTF_RIGHTDOWN : MOUSEEVENTF_RIGHTUP;
+            break;
+        case ClickType::MiddleClick:
+            input[inputCount].mi.dwFlags = down ? MOUSEEVENTF_MIDDLEDOWN : MOUSEEVENTF_MIDDLEUP;
+            break;
+        default:
+            input[inputCount].mi.dwFlags = down ? MOUSEEVENTF_LEFTDOWN : MOUSEEVENTF_LEFTUP;
+            break;
+    }
+    inputCount++;
+    
+    return SendInput(inputCount, input, sizeof(INPUT)) == UINT(inputCount);
+}
+
+void ClickerThread::movePointer(const QPoint *points, int count)
+{
+    if (discarding()) return;
+    // One SendInput call per batch
+    QVector<INPUT> inputs(count);
+    const int scaleX = 65535 / GetSystemMetrics(SM_CXSCREEN);
+    const int scaleY = 65535 / GetSystemMetrics(SM_CYSCREEN);
+    for (int i = 0; i < count; ++i) {
+        inputs[i].type = INPUT_MOUSE;
+        inputs[i].mi.dx = points[i].x() * scaleX;
+        inputs[i].mi.dy = points[i].y() * scaleY;
+        inputs[i].mi.dwFlags = MOUSEEVENTF_MOVE | MOUSEEVENTF_ABSOLUTE;
     }
+    SendInput(count, inputs.data(), sizeof(INPUT));
 }
 #endif
 
 #ifdef Q_OS_MAC
-void ClickerThread::performMacClick(ClickType type, const QPoint &pos)
+bool ClickerThread::performMacClick(ClickType type, const QPoint &pos)
 {
     // Check if we have accessibility permissions
     if (!AXIsProcessTrusted()) {
-        return;
+        return false;
     }
     
     CGPoint cgPos = CGPointMake(pos.x(), pos.y());
@@ -165,6 +451,18 @@ void ClickerThread::performMacClick(ClickType type, const QPoint &pos)
     // Move cursor to position
     CGWarpMouseCursorPosition(cgPos);
     
+    // One wheel event carries every notch; positive is up and left
+    if (isScroll(type)) {
+        const int32_t notches = scrollNotches();
+        const int32_t dy = type == ClickType::ScrollUp ? notches : type == ClickType::ScrollDown ? -notches : 0;
+        const int32_t dx = type == ClickType::ScrollLeft ? notches : type == ClickType::ScrollRight ? -notches : 0;
+        CGEventRef wheel = CGEventCreateScrollWheelEvent(nullptr, kCGScrollEventUnitLine, 2, dy, dx);
+        if (!wheel) return false;
+        CGEventPost(kCGHIDEventTap, wheel);
+        CFRelease(wheel);
+        return true;
+    }
+    
     // Determine click type
     CGEventType downType, upType;
     CGMouseButton button;
@@ -185,7 +483,7 @@ void ClickerThread::performMacClick(ClickType type, const QPoint &pos)
             upType = kCGEventOtherMouseUp;
             button = kCGMouseButtonCenter;
             break;
-        case ClickType::DoubleClick:
+        default:
             downType = kCGEventLeftMouseDown;
             upType = kCGEventLeftMouseUp;
             button = kCGMouseButtonLeft;
@@ -199,16 +497,17 @@ void ClickerThread::performMacClick(ClickType type, const QPoint &pos)
     if (!downEvent || !upEvent) {
         if (downEvent) CFRelease(downEvent);
         if (upEvent) CFRelease(upEvent);
-        return;
+        return false;
     }
     
     // Post the events
     CGEventPost(kCGHIDEventTap, downEvent);
     // No delay for ultra-high speeds - let the system handle timing
     CGEventPost(kCGHIDEventTap, upEvent);
+    bool sent = true;
     
-    // For double click, add a second click
-    if (type == ClickType::DoubleClick) {
+    // For double and triple clicks, add the remaining presses
+    for (int press = 1; press < pressCount(type); ++press) {
         // Minimal delay for double click - system will handle timing
         CGEventRef downEvent2 = CGEventCreateMouseEvent(nullptr, downType, cgPos, button);
         CGEventRef upEvent2 = CGEventCreateMouseEvent(nullptr, upType, cgPos, button);
@@ -216,6 +515,8 @@ void ClickerThread::performMacClick(ClickType type, const QPoint &pos)
         if (downEvent2 && upEvent2) {
             CGEventPost(kCGHIDEventTap, downEvent2);
             CGEventPost(kCGHIDEventTap, upEvent2);
+        } else {
+            sent = false;
         }
         
         if (downEvent2) CFRelease(downEvent2);
@@ -224,52 +525,320 @@ void ClickerThread::performMacClick(ClickType type, const QPoint &pos)
     
     CFRelease(downEvent);
     CFRelease(upEvent);
+    return sent;
 }
-#endif
 
-#ifndef Q_OS_WIN
-#ifndef Q_OS_MAC
-void ClickerThread::performLinuxClick(ClickType type, const QPoint &pos)
+bool ClickerThread::sendButton(ClickType type, const QPoint &pos, bool down)
 {
-    Display *display = XOpenDisplay(nullptr);
-    if (!display) return;
-    
-    Window root = DefaultRootWindow(display);
+    if (!AXIsProcessTrusted()) {
+        return false;
+    }
     
-    // Move cursor to position
-    XWarpPointer(display, None, root, 0, 0, 0, 0, pos.x(), pos.y());
-    XFlush(display);
+    const CGPoint cgPos = CGPointMake(pos.x(), pos.y());
+    if (down) CGWarpMouseCursorPosition(cgPos);
     
-    // Determine button
-    int button;
+    CGEventType eventType;
+    CGMouseButton button;
     switch (type) {
-        case ClickType::LeftClick:
-            button = Button1;
-            break;
         case ClickType::RightClick:
-            button = Button3;
+            eventType = down ? kCGEventRightMouseDown : kCGEventRightMouseUp;
+            button = kCGMouseButtonRight;
             break;
         case ClickType::MiddleClick:
-            button = Button2;
+            eventType = down ? kCGEventOtherMouseDown : kCGEventOtherMouseUp;
+            button = kCGMouseButtonCenter;
             break;
-        case ClickType::DoubleClick:
-            button = Button1;
+        default:
+            eventType = down ? kCGEventLeftMouseDown : kCGEventLeftMouseUp;
+            button = kCGMouseButtonLeft;
             break;
     }
     
-    // Perform click
-    XTestFakeButtonEvent(display, button, True, 0);
-    XTestFakeButtonEvent(display, button, False, 0);
+    CGEventRef event = CGEventCreateMouseEvent(nullptr, eventType, cgPos, button);
+    if (!event) return false;
+    CGEventPost(kCGHIDEventTap, event);
+    CFRelease(event);
+    return true;
+}
+
+void ClickerThread::movePointer(const QPoint *points, int count)
+{
+    if (discarding()) return;
+    if (!AXIsProcessTrusted()) {
+        return;
+    }
     
-    // For double click, add a second click
-    if (type == ClickType::DoubleClick) {
-        // Minimal delay for ultra-high speed double clicks
-        XTestFakeButtonEvent(display, button, True, 0);
-        XTestFakeButtonEvent(display, button, False, 0);
+    for (int i = 0; i < count; ++i) {
+        CGEventRef event = CGEventCreateMouseEvent(nullptr, kCGEventMouseMoved,
+                                                   CGPointMake(points[i].x(), points[i].y()), kCGMouseButtonLeft);
+        if (!event) continue;
+        CGEventPost(kCGHIDEventTap, event);
+        CFRelease(event);
     }
+}
+#endif
+
+#ifndef Q_OS_WIN
+#ifndef Q_OS_MAC
+bool ClickerThread::openDisplay()
+{
+    if (display) return true;
+    
+    const QByteArray name = sessionDisplay.toLocal8Bit();
+    display = XOpenDisplay(name.isEmpty() ? nullptr : name.constData());
+    if (!display) {
+        // Retried on every click, so only report the first failure
+        if (!displayWarned) {
+            qWarning() << "ClickerThread: cannot open display" << (name.isEmpty() ? qgetenv("DISPLAY") : name);
+            displayWarned = true;
+        }
+        return false;
+    }
+    return true;
+}
+
+static unsigned int buttonFor(ClickType type)
+{
+    switch (type) {
+        case ClickType::RightClick:
+            return Button3;
+        case ClickType::MiddleClick:
+            return Button2;
+        case ClickType::ScrollUp:
+            return Button4;
+        case ClickType::ScrollDown:
+            return Button5;
+        case ClickType::ScrollLeft:
+            return 6;
+        case ClickType::ScrollRight:
+            return 7;
+        default:
+            return Button1;
+    }
+}
+
+bool ClickerThread::performLinuxClick(ClickType type, const QPoint &pos)
+{
+    StageScope scope(ClickStage::Click);
+    
+    // The whole click in one write() to the kernel
+    if (UInputDevice *device = sessionDevice()) {
+        const QPoint pointer = device->isAbsolute() ? pos : currentPosition();
+        return device->click(pos, pointer, type, isScroll(type) ? scrollNotches() : pressCount(type));
+    }
+    
+    StageScope lock(ClickStage::Lock);
+    QMutexLocker locker(&displayMutex);
+    lock.finish();
+    if (!openDisplay()) return false;
+    
+    Window root = DefaultRootWindow(display);
+    
+    // Move cursor to position; the flush below sends it ahead of the button events
+    {
+        StageScope stage(ClickStage::Warp);
+        XWarpPointer(display, None, root, 0, 0, 0, 0, pos.x(), pos.y());
+    }
+    
+    const unsigned int button = buttonFor(type);
     
+    // Perform click; double and triple clicks repeat it with no delay, and a
+    // scroll sends each notch as a wheel button press, all in the one flush
+    {
+        StageScope stage(ClickStage::Button);
+        const int presses = isScroll(type) ? scrollNotches() : pressCount(type);
+        for (int press = 0; press < presses; ++press) {
+            XTestFakeButtonEvent(display, button, True, 0);
+            XTestFakeButtonEvent(display, button, False, 0);
+        }
+    }
+    
+    StageScope stage(ClickStage::Flush);
     XFlush(display);
-    XCloseDisplay(display);
+    return true;
+}
+
+bool ClickerThread::sendButton(ClickType type, const QPoint &pos, bool down)
+{
+    StageScope scope(down ? ClickStage::Press : ClickStage::Release);
+    if (UInputDevice *device = sessionDevice()) {
+        return device->button(pos, device->isAbsolute() || !down ? pos : currentPosition(), type, down);
+    }
+    
+    StageScope lock(ClickStage::Lock);
+    QMutexLocker locker(&displayMutex);
+    lock.finish();
+    if (!openDisplay()) return false;
+    
+    // The press moves the cursor; the release happens wherever it is
+    if (down) {
+        StageScope stage(ClickStage::Warp);
+        XWarpPointer(display, None, DefaultRootWindow(display), 0, 0, 0, 0, pos.x(), pos.y());
+    }
+    
+    {
+        StageScope stage(ClickStage::Button);
+        XTestFakeButtonEvent(display, buttonFor(type), down ? True : False, 0);
+    }
+    StageScope stage(ClickStage::Flush);
+    XFlush(display);
+    return true;
+}
+
+void ClickerThread::movePointer(const QPoint *points, int count)
+{
+    if (discarding()) return;
+    StageScope scope(ClickStage::Motion);
+    if (UInputDevice *device = sessionDevice()) {
+        device->move(points, count, device->isAbsolute() || !count ? QPoint() : currentPosition());
+        return;
+    }
+    
+    StageScope lock(ClickStage::Lock);
+    QMutexLocker locker(&displayMutex);
+    lock.finish();
+    if (!openDisplay()) return;
+    
+    // Device motion rather than warps, so clients see a drag while a button is held
+    for (int i = 0; i < count; ++i) {
+        XTestFakeMotionEvent(display, -1, points[i].x(), points[i].y(), 0);
+    }
+    StageScope stage(ClickStage::Flush);
+    XFlush(display);
+}
+
+// Keysym lookups go to the server once per symbol and session
+quint32 ClickerThread::keycodeFor(unsigned long keysym, bool *shifted)
+{
+    const auto cached = keycodeCache.constFind(quint32(keysym));
+    if (cached != keycodeCache.constEnd()) {
+        *shifted = *cached & 0x80000000u;
+        return *cached & 0x7fffffffu;
+    }
+    
+    const KeyCode keycode = XKeysymToKeycode(display, keysym);
+    if (!keycode) return 0;
+    
+    // Reachable only on the shifted level, e.g. '!' or an upper-case letter
+    *shifted = XkbKeycodeToKeysym(display, keycode, 0, 0) != keysym &&
+               XkbKeycodeToKeysym(display, keycode, 0, 1) == keysym;
+    keycodeCache.insert(quint32(keysym), keycode | (*shifted ? 0x80000000u : 0u));
+    return keycode;
+}
+
+bool ClickerThread::resolveKeyAction(const QString &spec, KeyAction *action)
+{
+    QMutexLocker locker(&displayMutex);
+    if (!openDisplay()) return false;
+    
+    action->spec = spec;
+    action->strokes.clear();
+    
+    bool shifted = false;
+    const quint32 shiftKeycode = keycodeFor(XK_Shift_L, &shifted);
+    
+    if (spec.startsWith("text:")) {
+        for (const QChar ch : spec.mid(5)) {
+            const ushort unicode = ch.unicode();
+            unsigned long keysym;
+            if (unicode == '\n') {
+                keysym = XK_Return;
+            } else if (unicode == '\t') {
+                keysym = XK_Tab;
+            } else if (unicode >= 0x20 && unicode <= 0xff) {
+                keysym = unicode; // Latin-1 keysyms equal their code points
+            } else {
+                keysym = 0x01000000 | unicode;
+            }
+            
+            KeyAction::Stroke stroke;
+            stroke.keycode = keycodeFor(keysym, &shifted);
+            if (!stroke.keycode) {
+                qWarning() << "ClickerThread: no key for" << QString(ch) << "in" << spec;
+                action->strokes.clear();
+                return false;
+            }
+            if (shifted) stroke.modifiers.append(shiftKeycode);
+            action->strokes.append(stroke);
+        }
+        return !action->strokes.isEmpty();
+    }
+    
+    // Chord: modifiers joined with '+', the key itself last
+    const QStringList parts = spec.split('+', Qt::SkipEmptyParts);
+    if (parts.isEmpty()) return false;
+    
+    KeyAction::Stroke stroke;
+    for (int i = 0; i < parts.size() - 1; ++i) {
+        const QString modifier = parts[i].toLower();
+        unsigned long keysym;
+        if (modifier == "ctrl" || modifier == "control") {
+            keysym = XK_Control_L;
+        } else if (modifier == "shift") {
+            keysym = XK_Shift_L;
+        } else if (modifier == "alt") {
+            keysym = XK_Alt_L;
+        } else if (modifier == "super" || modifier == "meta" || modifier == "win") {
+            keysym = XK_Super_L;
+        } else {
+            qWarning() << "ClickerThread: unknown modifier" << parts[i] << "in" << spec;
+            return false;
+        }
+        stroke.modifiers.append(keycodeFor(keysym, &shifted));
+    }
+    
+    const QByteArray name = parts.last().toLatin1();
+    unsigned long keysym = XStringToKeysym(name.constData());
+    if (keysym == NoSymbol && name.size() == 1) keysym = static_cast<unsigned char>(name[0]);
+    
+    stroke.keycode = keysym == NoSymbol ? 0 : keycodeFor(keysym, &shifted);
+    if (!stroke.keycode || stroke.modifiers.contains(0)) {
+        qWarning() << "ClickerThread: cannot map" << spec << "to keycodes";
+        return false;
+    }
+    if (shifted && !stroke.modifiers.contains(shiftKeycode)) stroke.modifiers.append(shiftKeycode);
+    action->strokes.append(stroke);
+    return true;
+}
+
+void ClickerThread::performKeyAction(const KeyAction &action)
+{
+    if (discarding()) return;
+    StageScope scope(ClickStage::Keys);
+    StageScope lock(ClickStage::Lock);
+    QMutexLocker locker(&displayMutex);
+    lock.finish();
+    if (!openDisplay()) return;
+    
+    for (const KeyAction::Stroke &stroke : action.strokes) {
+        for (quint32 modifier : stroke.modifiers) {
+            XTestFakeKeyEvent(display, modifier, True, 0);
+        }
+        XTestFakeKeyEvent(display, stroke.keycode, True, 0);
+        XTestFakeKeyEvent(display, stroke.keycode, False, 0);
+        for (int i = stroke.modifiers.size() - 1; i >= 0; --i) {
+            XTestFakeKeyEvent(display, stroke.modifiers[i], False, 0);
+        }
+    }
+    
+    // One flush for the whole string
+    {
+        StageScope stage(ClickStage::Flush);
+        XFlush(display);
+    }
+    AuditLog::record(AuditLog::Keys, QPoint(), ClickType::LeftClick);
+}
+#endif
+#endif
+
+#if defined(Q_OS_WIN) || defined(Q_OS_MAC)
+bool ClickerThread::resolveKeyAction(const QString &spec, KeyAction *)
+{
+    qWarning() << "ClickerThread: key actions are only supported on X11:" << spec;
+    return false;
+}
+
+void ClickerThread::performKeyAction(const KeyAction &)
+{
 }
 #endif
-#endif 
\ No newline at end of file
@@ -3,45 +3,113 @@
 
 #include <QThread>
 #include <QPoint>
+#include <QHash>
 #include <QMutex>
 #include <QWaitCondition>
 #include <atomic>
 #include "types.h"
 
+struct _XDisplay;
+class UInputDevice;
+
+// Injection session for one display. On X11 the connection is opened on the
+// first click and kept for the lifetime of the object.
 class ClickerThread : public QThread
 {
     Q_OBJECT
 
 public:
     explicit ClickerThread(QObject *parent = nullptr);
+    explicit ClickerThread(const QString &displayName, QObject *parent = nullptr); // X11 display, e.g. ":99"
     ~ClickerThread();
 
+    // Wheel notches per scroll action, for every session in the process
+    static void setScrollNotches(int notches);
+    static int scrollNotches();
+
+    // Pointer events through XTest or one uinput device shared by every
+    // session on the default display; sessions with a display of their own
+    // and key actions always use XTest. Refused while an engine holds the
+    // backend; on failure the backend in use stays. Discard sends nothing,
+    // keys included, for simulated and dry runs.
+    static bool setBackend(InjectionBackend backend, QString *error = nullptr);
+    static InjectionBackend backend();
+    static QString backendName(InjectionBackend backend);
+    static bool parseBackend(const QString &name, InjectionBackend *backend); // xtest, uinput-abs, uinput-rel, none
+
+    // Engines hold the backend from start to stop, so it is not switched under their threads
+    static void holdBackend();
+    static void releaseBackend();
+
     void setClickType(ClickType type);
     void setClickPosition(const QPoint &pos);
     void setUseCurrentPosition(bool useCurrent);
     void performClick();
+    void performClickAt(const QPoint &pos);
+    void performClickAt(const QPoint &pos, ClickType type);
+
+    // One button press without the release, and the release on its own, for
+    // callers that time the gap between them (see ClickTimeline). Multi-press
+    // types press the left button once per call.
+    void pressButton(const QPoint &pos, ClickType type);
+    void releaseButton(const QPoint &pos, ClickType type);
+
+    // Pointer motion through each point in turn, sent as one batch; a held
+    // button turns it into a drag
+    void movePointer(const QPoint *points, int count);
+
+    // Keyboard actions (X11 only). Keysyms are looked up once here, through a
+    // per-session keycode cache; performKeyAction() then only sends XTest key
+    // events, flushed once per action.
+    bool resolveKeyAction(const QString &spec, KeyAction *action);
+    void performKeyAction(const KeyAction &action);
+
+    QString displayName() const;
+
+    // Waits until the server has processed every click sent on this session
+    void sync();
+
+    // Pointer position without QtGui, so the engine runs without a QGuiApplication
+    static QPoint cursorPosition();
 
 protected:
     void run() override;
 
 private:
+    static bool discarding(); // The Discard backend is in use
+    UInputDevice *sessionDevice() const; // The uinput device, if this session clicks through it
     void performMouseClick(ClickType type, const QPoint &pos);
+    bool sendButton(ClickType type, const QPoint &pos, bool down);
+    QPoint currentPosition();
     
 #ifdef Q_OS_WIN
-    void performWindowsClick(ClickType type, const QPoint &pos);
+    bool performWindowsClick(ClickType type, const QPoint &pos);
 #elif defined(Q_OS_MAC)
-    void performMacClick(ClickType type, const QPoint &pos);
+    bool performMacClick(ClickType type, const QPoint &pos);
 #else
-    void performLinuxClick(ClickType type, const QPoint &pos);
+    bool performLinuxClick(ClickType type, const QPoint &pos);
+    bool openDisplay();
+    quint32 keycodeFor(unsigned long keysym, bool *shifted);
 #endif
 
-    ClickType clickType;
-    QPoint clickPosition;
+    static std::atomic<int> notchCount;
+    static std::atomic<InjectionBackend> injectionBackend;
+    static std::atomic<UInputDevice *> uinput; // Set when a uinput backend is in use
+    static std::atomic<int> backendHolds;
+
+    std::atomic<ClickType> clickType;
+    std::atomic<qint64> clickPosition; // packPoint()
     std::atomic<bool> useCurrentPosition;
     QMutex mutex;
     QWaitCondition condition;
     bool shouldClick;
     bool running;
+
+    QString sessionDisplay;
+    _XDisplay *display;
+    bool displayWarned;
+    QHash<quint32, quint32> keycodeCache; // Keysym -> keycode, bit 31 set when shift is needed
+    QMutex displayMutex; // Xlib calls on one connection from several clicking threads
 };
 
 #endif // CLICKERTHREAD_H 
\ No newline at end of file
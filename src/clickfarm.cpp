@@ -0,0 +1,228 @@
+#include "clickfarm.h"
+#include "clickerthread.h"
+#include "auditlog.h"
+#include "clickmetrics.h"
+#include "clickpacer.h"
+#include "clicktrace.h"
+#include <QDebug>
+#include <QThread>
+#include <chrono>
+
+#if !defined(Q_OS_WIN) && !defined(Q_OS_MAC)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using FarmClock = std::chrono::steady_clock;
+
+static qint64 nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(FarmClock::now().time_since_epoch()).count();
+}
+
+struct ClickFarm::Session {
+    std::unique_ptr<ClickerThread> injector;
+    int index = 0; // In the display list
+    int worker = 0;
+    ClickPacer pacer; // Owned by the worker thread
+
+    std::atomic<quint64> clicks{0};
+    std::atomic<quint64> missed{0};
+    std::atomic<quint64> latenessTotalNs{0};
+    std::atomic<quint64> latenessMaxNs{0};
+};
+
+ClickFarm::ClickFarm()
+    : requestedWorkers(0)
+    , activeWorkers(0)
+    , clicksPerSecond(10)
+    , clickType(ClickType::LeftClick)
+    , running(false)
+    , startedNs(0)
+{
+}
+
+ClickFarm::~ClickFarm()
+{
+    stop();
+}
+
+void ClickFarm::setDisplays(const QStringList &displays)
+{
+    displayNames = displays;
+}
+
+void ClickFarm::setWorkerCount(int workers)
+{
+    requestedWorkers = qMax(0, workers);
+}
+
+void ClickFarm::setClicksPerSecond(int cps)
+{
+    clicksPerSecond = qBound(1, cps, 10000);
+}
+
+void ClickFarm::setClickType(ClickType type)
+{
+    clickType = type;
+}
+
+void ClickFarm::setClickPosition(const QPoint &pos)
+{
+    clickPosition = pos;
+}
+
+bool ClickFarm::isRunning() const
+{
+    return running.load();
+}
+
+int ClickFarm::workerCount() const
+{
+    return activeWorkers;
+}
+
+bool ClickFarm::start()
+{
+    if (running.load() || displayNames.isEmpty()) return false;
+
+    const int cores = qMax(1, QThread::idealThreadCount());
+    activeWorkers = qMin(requestedWorkers > 0 ? requestedWorkers : cores, int(displayNames.size()));
+
+    sessions.clear();
+    for (int i = 0; i < displayNames.size(); ++i) {
+        std::unique_ptr<Session> session(new Session);
+        session->injector.reset(new ClickerThread(displayNames[i]));
+        session->injector->setClickType(clickType);
+        session->index = i;
+        session->worker = i % activeWorkers;
+        sessions.push_back(std::move(session));
+    }
+
+    startedNs = nowNs();
+    running.store(true);
+
+    for (int w = 0; w < activeWorkers; ++w) {
+        workers.emplace_back(&ClickFarm::workerLoop, this, w);
+
+#if !defined(Q_OS_WIN) && !defined(Q_OS_MAC)
+        // One core per worker; with more workers than cores they wrap around
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(w % cores, &cpus);
+        pthread_setaffinity_np(workers.back().native_handle(), sizeof(cpus), &cpus);
+#endif
+    }
+    return true;
+}
+
+void ClickFarm::stop()
+{
+    if (!running.exchange(false)) return;
+
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+}
+
+void ClickFarm::workerLoop(int worker)
+{
+    std::vector<Session *> owned;
+    for (const auto &session : sessions) {
+        if (session->worker == worker) owned.push_back(session.get());
+    }
+    if (owned.empty()) return;
+    ClickTrace::setThreadName(QString("farm-%1").arg(worker));
+
+    const qint64 intervalNs = 1000000000LL / clicksPerSecond;
+
+    // Stagger the displays across one interval so their clicks do not bunch up
+    const qint64 firstDue = nowNs();
+    for (size_t i = 0; i < owned.size(); ++i) {
+        owned[i]->pacer.start(firstDue + intervalNs * qint64(i) / qint64(owned.size()), intervalNs, ClickPacer::SkipMissed);
+    }
+
+    while (running.load(std::memory_order_relaxed)) {
+        Session *next = owned.front();
+        for (Session *session : owned) {
+            if (session->pacer.dueNs() < next->pacer.dueNs()) next = session;
+        }
+
+        qint64 now = nowNs();
+        if (next->pacer.dueNs() > now) {
+            // Bounded so stop() is honoured promptly at low rates
+            const qint64 sleepNs = qMin(next->pacer.dueNs() - now, qint64(50000000));
+            std::this_thread::sleep_for(std::chrono::nanoseconds(sleepNs));
+            continue;
+        }
+
+        ClickTrace::complete("wakeup", next->pacer.dueNs(), now);
+        AuditLog::setThreadContext(AuditLog::Farm, quint32(next->index));
+        next->injector->performClickAt(clickPosition);
+
+        const quint64 lateness = quint64(now - next->pacer.dueNs());
+        next->clicks.fetch_add(1, std::memory_order_relaxed);
+        next->latenessTotalNs.fetch_add(lateness, std::memory_order_relaxed);
+        if (lateness > next->latenessMaxNs.load(std::memory_order_relaxed)) {
+            next->latenessMaxNs.store(lateness, std::memory_order_relaxed);
+        }
+        ClickMetrics::recordClick(now, qint64(lateness));
+
+        // Fell more than a full interval behind: skip the lost slots instead of bursting
+        const quint64 behind = next->pacer.advance(nowNs());
+        if (behind) {
+            next->missed.fetch_add(behind, std::memory_order_relaxed);
+            ClickMetrics::recordMissed(behind);
+        }
+    }
+}
+
+QVector<ClickFarm::DisplayStats> ClickFarm::stats() const
+{
+    QVector<DisplayStats> result;
+    const double elapsedSeconds = startedNs ? (nowNs() - startedNs) / 1e9 : 0.0;
+
+    for (const auto &session : sessions) {
+        DisplayStats entry;
+        entry.display = session->injector->displayName();
+        entry.worker = session->worker;
+        entry.clicks = session->clicks.load(std::memory_order_relaxed);
+        entry.missed = session->missed.load(std::memory_order_relaxed);
+        entry.clicksPerSecond = elapsedSeconds > 0 ? entry.clicks / elapsedSeconds : 0.0;
+        entry.meanLatenessUs = entry.clicks ? session->latenessTotalNs.load(std::memory_order_relaxed) / 1000.0 / entry.clicks : 0.0;
+        entry.maxLatenessUs = session->latenessMaxNs.load(std::memory_order_relaxed) / 1000.0;
+        result.append(entry);
+    }
+    return result;
+}
+
+QString ClickFarm::report() const
+{
+    const QVector<DisplayStats> entries = stats();
+
+    QString text = QString("%1 %2 %3 %4 %5 %6 %7\n")
+                       .arg(QString("display"), -12).arg(QString("worker"), 6).arg(QString("clicks"), 10)
+                       .arg(QString("rate/s"), 10).arg(QString("late_us"), 10).arg(QString("max_us"), 10)
+                       .arg(QString("missed"), 8);
+
+    double totalRate = 0.0;
+    quint64 totalClicks = 0;
+    quint64 totalMissed = 0;
+    for (const DisplayStats &entry : entries) {
+        text += QString("%1 %2 %3 %4 %5 %6 %7\n")
+                    .arg(entry.display, -12).arg(entry.worker, 6).arg(entry.clicks, 10)
+                    .arg(entry.clicksPerSecond, 10, 'f', 1).arg(entry.meanLatenessUs, 10, 'f', 1)
+                    .arg(entry.maxLatenessUs, 10, 'f', 1).arg(entry.missed, 8);
+        totalRate += entry.clicksPerSecond;
+        totalClicks += entry.clicks;
+        totalMissed += entry.missed;
+    }
+
+    text += QString("total: %1 displays on %2 workers (%3 cores), %4 clicks, %5 clicks/s (%6 per display), %7 missed")
+                .arg(entries.size()).arg(activeWorkers).arg(QThread::idealThreadCount())
+                .arg(totalClicks).arg(totalRate, 0, 'f', 1)
+                .arg(entries.isEmpty() ? 0.0 : totalRate / entries.size(), 0, 'f', 1)
+                .arg(totalMissed);
+    return text;
+}
@@ -0,0 +1,68 @@
+#ifndef CLICKFARM_H
+#define CLICKFARM_H
+
+#include <QPoint>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "types.h"
+
+class ClickerThread;
+
+// Drives many X displays from one process. Each display gets its own
+// injection session (a persistent connection) and click schedule; the
+// schedules are spread over a bounded pool of worker threads pinned to
+// cores, each worker sleeping until the earliest click it owns is due.
+class ClickFarm
+{
+public:
+    struct DisplayStats {
+        QString display;
+        int worker = 0;
+        quint64 clicks = 0;
+        quint64 missed = 0;        // Slots skipped because the worker fell behind
+        double clicksPerSecond = 0.0;
+        double meanLatenessUs = 0.0; // Click issued after its due time
+        double maxLatenessUs = 0.0;
+    };
+
+    ClickFarm();
+    ~ClickFarm();
+
+    void setDisplays(const QStringList &displays);
+    void setWorkerCount(int workers); // 0: one per core, never more than displays
+    void setClicksPerSecond(int cps);  // Per display
+    void setClickType(ClickType type);
+    void setClickPosition(const QPoint &pos);
+
+    bool start();
+    void stop();
+    bool isRunning() const;
+    int workerCount() const;
+
+    QVector<DisplayStats> stats() const;
+    QString report() const; // Per-display table plus the aggregate
+
+private:
+    struct Session;
+
+    void workerLoop(int worker);
+
+    QStringList displayNames;
+    int requestedWorkers;
+    int activeWorkers;
+    int clicksPerSecond;
+    ClickType clickType;
+    QPoint clickPosition;
+
+    std::vector<std::unique_ptr<Session>> sessions;
+    std::vector<std::thread> workers;
+    std::atomic<bool> running;
+    qint64 startedNs;
+};
+
+#endif // CLICKFARM_H
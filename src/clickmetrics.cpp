@@ -0,0 +1,215 @@
+#include "clickmetrics.h"
+#include <QMutex>
+#include <QMutexLocker>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+std::atomic<bool> ClickMetrics::enabled(false);
+
+// 1 us to 25 ms in 1-2.5-5 steps
+const qint64 ClickMetrics::bucketBoundsNs[ClickMetrics::BucketCount] = {
+    1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000,
+    1000000, 2500000, 5000000, 10000000, 25000000
+};
+
+static qint64 nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+namespace {
+
+const qint64 PublishIntervalNs = 100000000;
+
+enum Field {
+    Clicks,
+    Missed,
+    Samples,
+    ErrorTotal,
+    QueueDepth,
+    QueueDropped,
+    FirstBucket,
+    FieldCount = FirstBucket + ClickMetrics::BucketCount + 1
+};
+
+// Written by the owning thread when it publishes and read by scrapes; the
+// sequence count is odd while a copy is under way
+struct alignas(64) PublishedSlot {
+    std::atomic<quint32> sequence{0};
+    std::atomic<bool> owned{false};
+    std::atomic<quint64> fields[FieldCount];
+
+    PublishedSlot()
+    {
+        for (std::atomic<quint64> &field : fields) {
+            field.store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+// Slots outlive their threads and are handed to the next thread, so the
+// counters keep the clicks of threads that have exited
+struct MetricsRegistry {
+    QMutex mutex;
+    std::vector<std::unique_ptr<PublishedSlot>> published;
+    std::atomic<double> targetRate{0.0};
+};
+
+MetricsRegistry &registry()
+{
+    static MetricsRegistry instance;
+    return instance;
+}
+
+// Plain counters only the owning thread touches
+struct ThreadCounters {
+    PublishedSlot *slot = nullptr;
+    quint64 fields[FieldCount] = {};
+    qint64 publishedNs = 0;
+
+    ~ThreadCounters()
+    {
+        if (!slot) return;
+        fields[QueueDepth] = 0;
+        store();
+        slot->owned.store(false, std::memory_order_release);
+    }
+
+    void store()
+    {
+        const quint32 sequence = slot->sequence.load(std::memory_order_relaxed);
+        slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (int i = 0; i < FieldCount; ++i) {
+            slot->fields[i].store(fields[i], std::memory_order_relaxed);
+        }
+        slot->sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    void maybePublish(qint64 now)
+    {
+        if (now - publishedNs < PublishIntervalNs) return;
+        store();
+        publishedNs = now;
+    }
+};
+
+thread_local ThreadCounters threadCounters;
+
+ThreadCounters &acquireCounters()
+{
+    ThreadCounters &counters = threadCounters;
+    if (counters.slot) return counters;
+
+    MetricsRegistry &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    for (const auto &candidate : reg.published) {
+        bool expected = false;
+        if (candidate->owned.compare_exchange_strong(expected, true)) {
+            counters.slot = candidate.get();
+            break;
+        }
+    }
+    if (!counters.slot) {
+        reg.published.emplace_back(new PublishedSlot);
+        counters.slot = reg.published.back().get();
+        counters.slot->owned.store(true);
+    }
+
+    // Carry on from the previous owner's totals
+    for (int i = 0; i < FieldCount; ++i) {
+        counters.fields[i] = counters.slot->fields[i].load(std::memory_order_relaxed);
+    }
+    return counters;
+}
+
+} // namespace
+
+void ClickMetrics::setEnabled(bool enable)
+{
+    enabled.store(enable);
+}
+
+void ClickMetrics::addClick(qint64 now, qint64 errorNs)
+{
+    ThreadCounters &counters = acquireCounters();
+    ++counters.fields[Clicks];
+    if (errorNs >= 0) {
+        int bucket = 0;
+        while (bucket < BucketCount && errorNs > bucketBoundsNs[bucket]) ++bucket;
+        ++counters.fields[FirstBucket + bucket];
+        ++counters.fields[Samples];
+        counters.fields[ErrorTotal] += quint64(errorNs);
+    }
+    counters.maybePublish(now);
+}
+
+// Published with the next click or publish()
+void ClickMetrics::addMissed(quint64 count)
+{
+    acquireCounters().fields[Missed] += count;
+}
+
+void ClickMetrics::setQueue(qint64 now, quint64 depth, quint64 dropped)
+{
+    if (!isEnabled()) return;
+    ThreadCounters &counters = acquireCounters();
+    counters.fields[QueueDepth] = depth;
+    counters.fields[QueueDropped] = dropped;
+    counters.maybePublish(now);
+}
+
+void ClickMetrics::publish()
+{
+    if (!isEnabled() || !threadCounters.slot) return;
+    threadCounters.store();
+    threadCounters.publishedNs = nowNs();
+}
+
+void ClickMetrics::setTargetRate(double clicksPerSecond)
+{
+    registry().targetRate.store(clicksPerSecond, std::memory_order_relaxed);
+}
+
+double ClickMetrics::targetRate()
+{
+    return registry().targetRate.load(std::memory_order_relaxed);
+}
+
+ClickMetrics::Snapshot ClickMetrics::snapshot()
+{
+    Snapshot total;
+    quint64 fields[FieldCount];
+
+    MetricsRegistry &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    for (const auto &slot : reg.published) {
+        // Retry while the owner is half way through publishing
+        for (;;) {
+            const quint32 sequence = slot->sequence.load(std::memory_order_acquire);
+            if (sequence & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+            for (int i = 0; i < FieldCount; ++i) {
+                fields[i] = slot->fields[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot->sequence.load(std::memory_order_relaxed) == sequence) break;
+        }
+
+        total.clicks += fields[Clicks];
+        total.missed += fields[Missed];
+        total.samples += fields[Samples];
+        total.errorTotalNs += fields[ErrorTotal];
+        total.queueDepth += fields[QueueDepth];
+        total.queueDropped += fields[QueueDropped];
+        for (int i = 0; i <= BucketCount; ++i) {
+            total.buckets[i] += fields[FirstBucket + i];
+        }
+    }
+    return total;
+}
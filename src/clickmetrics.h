@@ -0,0 +1,59 @@
+#ifndef CLICKMETRICS_H
+#define CLICKMETRICS_H
+
+#include <QtGlobal>
+#include <atomic>
+
+// Click counters and an interval-error histogram for the metrics endpoint.
+// Each clicking thread accumulates into thread-local memory and publishes a
+// copy to its own cache-line-aligned slot at most every 100 ms, so a scrape
+// only ever reads the published slots and never the lines the click path
+// writes per click. Off until enabled.
+class ClickMetrics
+{
+public:
+    // Upper bounds of the finite histogram buckets; one more counts the rest
+    static const int BucketCount = 14;
+    static const qint64 bucketBoundsNs[BucketCount];
+
+    struct Snapshot {
+        quint64 clicks = 0;
+        quint64 missed = 0;          // Click slots skipped or deadlines passed
+        quint64 samples = 0;         // Clicks with an interval error
+        quint64 errorTotalNs = 0;
+        quint64 buckets[BucketCount + 1] = {}; // Per bucket, not cumulative
+        quint64 queueDepth = 0;      // Summed over threads consuming a queue
+        quint64 queueDropped = 0;    // Pushes refused because a queue was full
+    };
+
+    static void setEnabled(bool enable);
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    // Click thread side. errorNs is how far the click was from its scheduled
+    // time (negative for clicks without a schedule, which are only counted)
+    static void recordClick(qint64 nowNs, qint64 errorNs)
+    {
+        if (isEnabled()) addClick(nowNs, errorNs);
+    }
+    static void recordMissed(quint64 count)
+    {
+        if (isEnabled()) addMissed(count);
+    }
+    static void setQueue(qint64 nowNs, quint64 depth, quint64 dropped);
+    static void publish(); // Before parking, so the last clicks are not held back
+
+    // Engine side, for the target rate gauge
+    static void setTargetRate(double clicksPerSecond);
+    static double targetRate();
+
+    // Scrape side: sums the published slots
+    static Snapshot snapshot();
+
+private:
+    static void addClick(qint64 nowNs, qint64 errorNs);
+    static void addMissed(quint64 count);
+
+    static std::atomic<bool> enabled;
+};
+
+#endif // CLICKMETRICS_H
@@ -0,0 +1,47 @@
+#include "clickpacer.h"
+#include "intervalgenerator.h"
+
+ClickPacer::ClickPacer()
+    : due(0)
+    , interval(1)
+    , step(1)
+    , policy(Drift)
+    , intervals(nullptr)
+{
+}
+
+void ClickPacer::start(qint64 firstDueNs, qint64 intervalNs, CatchUp catchUp, IntervalGenerator *generator)
+{
+    due = firstDueNs;
+    interval = qMax(qint64(1), intervalNs);
+    step = interval;
+    policy = catchUp;
+    intervals = generator;
+}
+
+quint64 ClickPacer::advance(qint64 nowNs)
+{
+    step = intervals ? intervals->next() : interval;
+
+    if (policy == Drift) {
+        const qint64 late = nowNs - due;
+        due = nowNs + step;
+        return late >= interval ? quint64(late / interval) : 0;
+    }
+
+    due += step;
+    if (nowNs - due <= interval) return 0;
+    const qint64 behind = (nowNs - due) / interval;
+    due += behind * interval;
+    return quint64(behind);
+}
+
+void ClickPacer::restartFrom(qint64 nowNs)
+{
+    due = nowNs + step;
+}
+
+void ClickPacer::shift(qint64 ns)
+{
+    due += ns;
+}
@@ -0,0 +1,45 @@
+#ifndef CLICKPACER_H
+#define CLICKPACER_H
+
+#include <QtGlobal>
+
+class IntervalGenerator;
+
+// When the next click is due, and what happens when one goes out late.
+// Time is passed in rather than read, so the engines drive it from the
+// steady clock and the simulator (see clicksimulator.h) from a virtual one,
+// and both follow exactly the same schedule.
+class ClickPacer
+{
+public:
+    enum CatchUp {
+        Drift,      // The next slot counts from the click itself, so lateness moves the schedule (rapid mode)
+        SkipMissed  // Slots stay on a grid; a full interval behind, the lost slots are skipped rather than burst (job and farm modes)
+    };
+
+    ClickPacer();
+
+    // First slot at firstDueNs. intervals is optional and not owned; it
+    // supplies random or ramped spacing instead of intervalNs
+    void start(qint64 firstDueNs, qint64 intervalNs, CatchUp policy, IntervalGenerator *intervals = nullptr);
+
+    qint64 dueNs() const { return due; }
+    qint64 intervalNs() const { return interval; }
+
+    // Moves to the next slot once the current one has been clicked: nowNs is
+    // when the click went out (Drift) or finished (SkipMissed). Returns the
+    // number of whole slots that were missed
+    quint64 advance(qint64 nowNs);
+
+    void restartFrom(qint64 nowNs); // Current spacing counted from nowNs, e.g. after the target was unmapped
+    void shift(qint64 ns);          // Paused for ns: keep the phase
+
+private:
+    qint64 due;
+    qint64 interval; // Mean interval; the unit for missed slots
+    qint64 step;     // Spacing of the current slot
+    CatchUp policy;
+    IntervalGenerator *intervals;
+};
+
+#endif // CLICKPACER_H
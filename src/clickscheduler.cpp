@@ -0,0 +1,442 @@
+#include "clickscheduler.h"
+#include "clickerthread.h"
+#include "auditlog.h"
+#include "clickclock.h"
+#include "clickmetrics.h"
+#include "clickpacer.h"
+#include "clicktrace.h"
+#include "clicktimeline.h"
+#include "intervalgenerator.h"
+#include "motionpath.h"
+#include "processstats.h"
+#include "timerwheel.h"
+#include "windowregistry.h"
+#include <QDeadlineTimer>
+#include <QMutexLocker>
+#include <QThread>
+#include <QWaitCondition>
+
+struct ClickScheduler::Job : TimerWheel::Entry {
+    int id = 0;
+    ClickJob config;
+    qint64 intervalNs = 0;  // Mean interval
+    std::unique_ptr<IntervalGenerator> intervals; // Only for jobs with a random or ramped profile
+    ClickPacer pacer;       // Click slots; dueNs follows the events of each click
+    int worker = 0;
+    ClickTimeline timeline; // Click in progress when the timing is not immediate
+    MotionStream motion;    // Path leg in progress
+    int waypoint = 0;       // Leg starts at config.path[waypoint]
+    KeyAction keyAction;    // Resolved by the owning worker when the job is added
+
+    std::atomic<quint64> clicks{0};
+    std::atomic<quint64> missed{0};
+    std::atomic<quint64> skipped{0};
+    std::atomic<quint64> latenessTotalNs{0};
+    std::atomic<quint64> latenessMaxNs{0};
+    qint64 addedNs = 0;
+};
+
+struct ClickScheduler::Worker {
+    int index = 0;
+    std::thread thread;
+    std::unique_ptr<ClickerThread> injector; // This worker's own X connection
+    std::unique_ptr<TimerWheel> wheel;
+
+    // Filled by addJob()/removeJob() under jobsMutex, applied by the worker
+    std::vector<Job *> additions;
+    std::vector<Job *> removals;
+    QWaitCondition wake;
+};
+
+ClickScheduler::ClickScheduler()
+    : threads(1)
+    , tickNs(100000)
+    , windowRegistry(nullptr)
+    , clock(SteadyClock::instance())
+    , nextId(1)
+    , nextWorker(0)
+    , running(false)
+    , startedNs(0)
+    , startedCpuSeconds(0.0)
+{
+}
+
+ClickScheduler::~ClickScheduler()
+{
+    stop();
+}
+
+void ClickScheduler::setThreadCount(int count)
+{
+    threads = qMax(1, count);
+}
+
+void ClickScheduler::setTickUs(int tickUs)
+{
+    tickNs = qint64(qBound(10, tickUs, 10000)) * 1000;
+}
+
+void ClickScheduler::setWindowRegistry(WindowRegistry *registry)
+{
+    windowRegistry = registry;
+}
+
+void ClickScheduler::setClock(ClickClock *newClock)
+{
+    if (!running.load()) clock = newClock ? newClock : SteadyClock::instance();
+}
+
+bool ClickScheduler::isRunning() const
+{
+    return running.load();
+}
+
+int ClickScheduler::threadCount() const
+{
+    return threads;
+}
+
+int ClickScheduler::addJob(const ClickJob &config)
+{
+    QMutexLocker locker(&jobsMutex);
+
+    std::unique_ptr<Job> job(new Job);
+    job->id = nextId++;
+    job->config = config;
+    job->intervalNs = 1000000000LL / qBound(1, config.clicksPerSecond, 10000);
+    job->addedNs = clock->nowNs();
+    job->dueNs = job->addedNs;
+    job->motion.reserve(config.motion);
+    if (!config.intervals.isFixed()) {
+        // Adjacent seeds are fine: the generator mixes them before use
+        const quint64 seed = clock->randomSeed() ? clock->randomSeed() : quint64(job->addedNs);
+        job->intervals.reset(new IntervalGenerator);
+        job->intervals->reset(config.intervals, qBound(1, config.clicksPerSecond, 10000), seed + quint64(job->id));
+    }
+    job->pacer.start(job->dueNs, job->intervalNs, ClickPacer::SkipMissed, job->intervals.get());
+
+    // Round-robin keeps the per-worker click rate roughly even
+    job->worker = nextWorker++ % threads;
+    if (running.load()) {
+        Worker *worker = workers[job->worker].get();
+        worker->additions.push_back(job.get());
+        worker->wake.wakeOne();
+    }
+
+    const int id = job->id;
+    jobs.push_back(std::move(job));
+    return id;
+}
+
+void ClickScheduler::removeJob(int id)
+{
+    QMutexLocker locker(&jobsMutex);
+
+    for (auto it = jobs.begin(); it != jobs.end(); ++it) {
+        Job *job = it->get();
+        if (job->id != id) continue;
+
+        if (running.load()) {
+            // The worker unlinks it from its wheel and frees it
+            Worker *worker = workers[job->worker].get();
+            worker->removals.push_back(job);
+            worker->wake.wakeOne();
+        } else {
+            jobs.erase(it);
+        }
+        return;
+    }
+}
+
+bool ClickScheduler::start()
+{
+    QMutexLocker locker(&jobsMutex);
+    if (running.load()) return false;
+
+    const qint64 now = clock->nowNs();
+    workers.clear();
+    for (int i = 0; i < threads; ++i) {
+        std::unique_ptr<Worker> worker(new Worker);
+        worker->index = i;
+        worker->injector.reset(new ClickerThread);
+        worker->wheel.reset(new TimerWheel(tickNs, now));
+        workers.push_back(std::move(worker));
+    }
+
+    for (const auto &job : jobs) {
+        job->worker %= threads;
+        job->dueNs = now;
+        job->pacer.start(now, job->intervalNs, ClickPacer::SkipMissed, job->intervals.get());
+        workers[job->worker]->additions.push_back(job.get());
+    }
+
+    startedNs = now;
+    startedCpuSeconds = ProcessStats::cpuSeconds();
+    ClickerThread::holdBackend();
+    running.store(true);
+
+    for (const auto &worker : workers) {
+        worker->thread = std::thread(&ClickScheduler::workerLoop, this, worker.get());
+    }
+    return true;
+}
+
+void ClickScheduler::stop()
+{
+    {
+        QMutexLocker locker(&jobsMutex);
+        if (!running.exchange(false)) return;
+        for (const auto &worker : workers) {
+            worker->wake.wakeOne();
+        }
+    }
+
+    for (const auto &worker : workers) {
+        worker->thread.join();
+    }
+    ClickerThread::releaseBackend();
+
+    // Removals the workers did not get to
+    QMutexLocker locker(&jobsMutex);
+    for (const auto &worker : workers) {
+        for (Job *removed : worker->removals) {
+            for (auto it = jobs.begin(); it != jobs.end(); ++it) {
+                if (it->get() == removed) {
+                    jobs.erase(it);
+                    break;
+                }
+            }
+        }
+    }
+    workers.clear();
+}
+
+void ClickScheduler::workerLoop(Worker *worker)
+{
+    TimerWheel &wheel = *worker->wheel;
+    ClickerThread *injector = worker->injector.get();
+    std::vector<TimerWheel::Entry *> expired;
+    ClickTrace::setThreadName(QString("scheduler-%1").arg(worker->index));
+
+    // Key action, click, or the press of a timed click
+    auto startAction = [injector](Job *job, const QPoint &pos, qint64 now) {
+        if (!job->keyAction.isEmpty()) {
+            injector->performKeyAction(job->keyAction);
+        } else if (job->config.timing.isImmediate()) {
+            injector->performClickAt(pos, job->config.clickType);
+        } else {
+            // Only the press now; the rest of the click follows as wheel entries
+            job->timeline.begin(pos, job->config.clickType, job->config.timing);
+            job->dueNs = now + job->timeline.step(injector);
+        }
+    };
+
+    // End of a path leg: a drag lets go, a move clicks at the end of the path
+    auto arrive = [injector, &startAction](Job *job, qint64 now) {
+        if (job->config.drag) {
+            injector->releaseButton(job->motion.target(), job->config.clickType);
+        } else {
+            startAction(job, job->motion.target(), now);
+        }
+    };
+
+    // Do not leave a button held down by a click or drag cut short
+    auto cancelJob = [injector](Job *job) {
+        job->timeline.cancel(injector);
+        if (job->motion.isActive() && job->config.drag) {
+            injector->releaseButton(job->motion.target(), job->config.clickType);
+        }
+        job->motion.cancel();
+    };
+
+    // Fell more than a full interval behind: skip the lost slots instead of bursting
+    auto scheduleNextClick = [this](Job *job) {
+        const quint64 behind = job->pacer.advance(clock->nowNs());
+        if (behind) {
+            job->missed.fetch_add(behind, std::memory_order_relaxed);
+            ClickMetrics::recordMissed(behind);
+            clock->slotsMissed(behind);
+        }
+        job->dueNs = job->pacer.dueNs();
+    };
+
+    while (running.load(std::memory_order_relaxed)) {
+        {
+            QMutexLocker locker(&jobsMutex);
+
+            for (Job *job : worker->additions) {
+                // Keycodes are looked up once, on this worker's connection
+                if (!job->config.keys.isEmpty() && job->keyAction.isEmpty()) {
+                    injector->resolveKeyAction(job->config.keys, &job->keyAction);
+                }
+                wheel.insert(job);
+            }
+            worker->additions.clear();
+
+            for (Job *job : worker->removals) {
+                wheel.remove(job);
+                cancelJob(job);
+                for (auto it = jobs.begin(); it != jobs.end(); ++it) {
+                    if (it->get() == job) {
+                        jobs.erase(it);
+                        break;
+                    }
+                }
+            }
+            worker->removals.clear();
+
+            // Sleep until the next occupied tick; addJob()/removeJob() wake us early
+            const qint64 waitNs = (wheel.isEmpty() ? clock->nowNs() + 1000000000LL : wheel.nextWakeNs()) - clock->nowNs();
+            if (waitNs > 0 && running.load(std::memory_order_relaxed)) {
+                if (waitNs >= 100000000) ClickMetrics::publish(); // Long idle: do not hold back the last clicks
+                if (clock->isRealTime()) {
+                    QDeadlineTimer deadline(Qt::PreciseTimer);
+                    deadline.setPreciseRemainingTime(0, waitNs, Qt::PreciseTimer);
+                    worker->wake.wait(&jobsMutex, deadline);
+                } else {
+                    clock->sleepUntil(clock->nowNs() + waitNs); // No other thread moves a virtual clock
+                }
+                continue;
+            }
+        }
+
+        const qint64 now = clock->nowNs();
+        wheel.advance(now, expired);
+
+        for (TimerWheel::Entry *entry : expired) {
+            Job *job = static_cast<Job *>(entry);
+            ClickTrace::complete("wakeup", job->dueNs, now); // How late the wheel handed the entry over
+            AuditLog::setThreadContext(AuditLog::Scheduler, quint32(job->id));
+
+            // Release or next press of a timed click already under way
+            if (job->timeline.isActive()) {
+                const qint64 delayNs = job->timeline.step(injector);
+                if (delayNs >= 0) {
+                    job->dueNs = now + delayNs;
+                } else {
+                    scheduleNextClick(job);
+                }
+                wheel.insert(job);
+                continue;
+            }
+
+            // Next batch of a path leg under way
+            if (job->motion.isActive()) {
+                const qint64 nextNs = job->motion.step(injector, now);
+                if (nextNs >= 0) {
+                    job->dueNs = nextNs;
+                    wheel.insert(job);
+                    continue;
+                }
+
+                arrive(job, now);
+                if (!job->timeline.isActive()) scheduleNextClick(job);
+                wheel.insert(job);
+                continue;
+            }
+
+            QPoint origin;
+            bool click = job->config.keys.isEmpty() || !job->keyAction.isEmpty();
+            if (click && !job->config.window.isEmpty()) {
+                WindowInfo info;
+                click = windowRegistry && windowRegistry->lookup(job->config.window, &info) && info.mapped;
+                origin = info.geometry.topLeft();
+            }
+
+            if (click) {
+                const qint64 dueNs = job->dueNs;
+                const quint64 lateness = quint64(qMax(qint64(0), now - dueNs));
+
+                const QVector<QPoint> &path = job->config.path;
+                if (path.size() >= 2 && job->keyAction.isEmpty()) {
+                    // Travel the next leg; the click or release follows on arrival
+                    const QPoint from = origin + path[job->waypoint];
+                    job->waypoint = (job->waypoint + 1) % path.size();
+                    const QPoint to = origin + path[job->waypoint];
+
+                    if (job->config.drag) injector->pressButton(from, job->config.clickType);
+                    job->motion.begin(job->config.motion, from, to, now);
+                    const qint64 nextNs = job->motion.step(injector, now);
+                    if (nextNs >= 0) {
+                        job->dueNs = nextNs;
+                    } else {
+                        arrive(job, now); // No motion duration: the whole leg went in one batch
+                    }
+                } else {
+                    startAction(job, origin + job->config.position, now);
+                }
+
+                job->clicks.fetch_add(1, std::memory_order_relaxed);
+                job->latenessTotalNs.fetch_add(lateness, std::memory_order_relaxed);
+                if (lateness > job->latenessMaxNs.load(std::memory_order_relaxed)) {
+                    job->latenessMaxNs.store(lateness, std::memory_order_relaxed);
+                }
+                ClickMetrics::recordClick(now, qint64(lateness));
+                clock->clickSent(dueNs);
+            } else {
+                job->skipped.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            if (!job->timeline.isActive() && !job->motion.isActive()) scheduleNextClick(job);
+            wheel.insert(job);
+        }
+        expired.clear();
+    }
+
+    QMutexLocker locker(&jobsMutex);
+    for (const auto &job : jobs) {
+        if (job->worker == worker->index) cancelJob(job.get());
+    }
+}
+
+QVector<ClickScheduler::JobStats> ClickScheduler::stats() const
+{
+    QMutexLocker locker(&jobsMutex);
+    QVector<JobStats> result;
+    const qint64 now = clock->nowNs();
+
+    for (const auto &job : jobs) {
+        JobStats entry;
+        entry.id = job->id;
+        entry.worker = job->worker;
+        entry.targetRate = job->config.clicksPerSecond;
+        entry.clicks = job->clicks.load(std::memory_order_relaxed);
+        entry.missed = job->missed.load(std::memory_order_relaxed);
+        entry.skipped = job->skipped.load(std::memory_order_relaxed);
+
+        const double seconds = (now - qMax(job->addedNs, startedNs)) / 1e9;
+        entry.achievedRate = seconds > 0 ? entry.clicks / seconds : 0.0;
+        entry.meanLatenessUs = entry.clicks ? job->latenessTotalNs.load(std::memory_order_relaxed) / 1000.0 / entry.clicks : 0.0;
+        entry.maxLatenessUs = job->latenessMaxNs.load(std::memory_order_relaxed) / 1000.0;
+        result.append(entry);
+    }
+    return result;
+}
+
+QString ClickScheduler::report() const
+{
+    const QVector<JobStats> entries = stats();
+
+    QString text = QString("%1 %2 %3 %4 %5 %6 %7 %8\n")
+                       .arg(QString("job"), 5).arg(QString("worker"), 6).arg(QString("target/s"), 9)
+                       .arg(QString("rate/s"), 10).arg(QString("late_us"), 10).arg(QString("max_us"), 10)
+                       .arg(QString("missed"), 8).arg(QString("skipped"), 8);
+
+    double totalRate = 0.0;
+    for (const JobStats &entry : entries) {
+        text += QString("%1 %2 %3 %4 %5 %6 %7 %8\n")
+                    .arg(entry.id, 5).arg(entry.worker, 6).arg(entry.targetRate, 9)
+                    .arg(entry.achievedRate, 10, 'f', 1).arg(entry.meanLatenessUs, 10, 'f', 1)
+                    .arg(entry.maxLatenessUs, 10, 'f', 1).arg(entry.missed, 8).arg(entry.skipped, 8);
+        totalRate += entry.achievedRate;
+    }
+
+    // CPU for the whole process over the run, so it includes the X client work
+    const double wallSeconds = startedNs ? (clock->nowNs() - startedNs) / 1e9 : 0.0;
+    const double cpuSeconds = ProcessStats::cpuSeconds() - startedCpuSeconds;
+    text += QString("total: %1 jobs on %2 threads, %3 clicks/s, CPU %4% of one core (%5 us per click)")
+                .arg(entries.size()).arg(threads).arg(totalRate, 0, 'f', 1)
+                .arg(wallSeconds > 0 ? cpuSeconds / wallSeconds * 100.0 : 0.0, 0, 'f', 1)
+                .arg(totalRate > 0 && wallSeconds > 0 ? cpuSeconds / (totalRate * wallSeconds) * 1e6 : 0.0, 0, 'f', 1);
+    return text;
+}
@@ -0,0 +1,95 @@
+#ifndef CLICKSCHEDULER_H
+#define CLICKSCHEDULER_H
+
+#include <QMutex>
+#include <QPoint>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "types.h"
+
+class ClickClock;
+class WindowRegistry;
+
+// One independent click job: its own rate, position, button and window
+struct ClickJob {
+    int clicksPerSecond = 10;
+    QPoint position;        // Root coordinates, or relative to the window
+    ClickType clickType = ClickType::LeftClick;
+    QString window;         // WM_CLASS or title; empty for none
+    ClickTiming timing;     // Down and up become separate wheel entries unless immediate
+    QString keys;           // Key action spec (see KeyAction); replaces the click when set
+    IntervalProfile intervals; // Random spacing around clicksPerSecond, and rate ramps
+
+    // With two or more points the job moves along the path, one leg per slot,
+    // and clicks on arrival; a drag holds the button down along each leg instead
+    QVector<QPoint> path;   // Root coordinates, or relative to the window
+    MotionSettings motion;
+    bool drag = false;
+};
+
+// Multiplexes many click jobs onto a few threads. Each worker owns a timer
+// wheel (see timerwheel.h) and one X connection, and sleeps until its next
+// click is due, so CPU time follows the total click rate rather than the
+// number of jobs.
+class ClickScheduler
+{
+public:
+    struct JobStats {
+        int id = 0;
+        int worker = 0;
+        int targetRate = 0;
+        quint64 clicks = 0;
+        quint64 missed = 0;        // Slots skipped after falling a full interval behind
+        quint64 skipped = 0;       // Window not mapped when due
+        double achievedRate = 0.0;
+        double meanLatenessUs = 0.0; // Click issued after its due time
+        double maxLatenessUs = 0.0;
+    };
+
+    ClickScheduler();
+    ~ClickScheduler();
+
+    void setThreadCount(int threads); // Applied on start
+    void setTickUs(int tickUs);       // Timer wheel resolution, default 100 us
+    void setWindowRegistry(WindowRegistry *registry); // For jobs with a window
+    void setClock(ClickClock *clock); // Before adding jobs; nullptr for the steady clock
+
+    // May be called while running; returns the job id
+    int addJob(const ClickJob &job);
+    void removeJob(int id);
+
+    bool start();
+    void stop();
+    bool isRunning() const;
+    int threadCount() const;
+
+    QVector<JobStats> stats() const;
+    QString report() const; // Per-job accuracy plus process CPU time against total rate
+
+private:
+    struct Job;
+    struct Worker;
+
+    void workerLoop(Worker *worker);
+
+    int threads;
+    qint64 tickNs;
+    WindowRegistry *windowRegistry;
+    ClickClock *clock;
+
+    mutable QMutex jobsMutex; // Guards jobs and each worker's pending lists
+    std::vector<std::unique_ptr<Job>> jobs;
+    std::vector<std::unique_ptr<Worker>> workers;
+    int nextId;
+    int nextWorker;
+
+    std::atomic<bool> running;
+    qint64 startedNs;
+    double startedCpuSeconds;
+};
+
+#endif // CLICKSCHEDULER_H
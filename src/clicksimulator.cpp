@@ -0,0 +1,259 @@
+#include "clicksimulator.h"
+#include "autoclicker.h"
+#include "clickclock.h"
+#include "clickerthread.h"
+#include "clickscheduler.h"
+#include <QSemaphore>
+#include <QStringList>
+#include <chrono>
+#include <functional>
+
+static qint64 nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+namespace {
+
+// The clock the engine runs on: the given one plus the simulated load.
+// It counts the clicks and missed slots the engine reports and calls
+// stopped() once, from the engine's thread, when the stop time is reached.
+class SimulatedClock : public ClickClock
+{
+public:
+    SimulatedClock(const SimulationSettings &settings, ClickClock *base, std::function<void()> stopped)
+        : settings(settings)
+        , base(base)
+        , stopped(stopped)
+        , startNs(base->nowNs())
+        , stopNs(startNs + qint64(settings.seconds * 1e9))
+        , nextStallNs(startNs + settings.stallEveryNs)
+    {
+    }
+
+    qint64 nowNs() const override
+    {
+        const qint64 now = base->nowNs();
+        if (now >= stopNs && !stopReached) {
+            stopReached = true;
+            stopped();
+        }
+        return now;
+    }
+
+    void sleepUntil(qint64 ns) override
+    {
+        base->sleepUntil(ns + settings.wakeLatencyNs);
+        nowNs();
+    }
+
+    void busy(qint64 ns) override
+    {
+        base->busy(ns);
+        nowNs();
+    }
+
+    void poll(qint64 ns, bool yield) override
+    {
+        // Only a virtual wait ends in a wakeup; a real one spins or yields
+        if (base->isRealTime()) {
+            base->poll(ns, yield);
+        } else {
+            base->sleepUntil(ns + settings.wakeLatencyNs);
+        }
+        nowNs();
+    }
+
+    bool isRealTime() const override { return base->isRealTime(); }
+    quint64 randomSeed() const override { return settings.seed; }
+
+    // Clicks the engine sends after the stop, before it is told, are not counted
+    void clickSent(qint64 dueNs) override
+    {
+        const qint64 now = base->nowNs();
+        lastCounted = now < stopNs;
+        if (!lastCounted) return;
+
+        if (now < dueNs) ++result.early;
+        const qint64 lateness = qMax(qint64(0), now - dueNs);
+        latenessTotalNs += double(lateness);
+        result.maxLatenessNs = qMax(result.maxLatenessNs, lateness);
+        result.lastClickNs = now - startNs;
+        ++result.clicks;
+
+        base->busy(settings.clickCostNs);
+        if (settings.stallEveryNs > 0 && base->nowNs() >= nextStallNs) {
+            base->busy(settings.stallNs);
+            nextStallNs += settings.stallEveryNs;
+        }
+        nowNs();
+    }
+
+    // Slots go with the click reported before them
+    void slotsMissed(quint64 count) override
+    {
+        if (lastCounted) result.missed += count;
+    }
+
+    bool isStopped() const { return stopReached; }
+
+    const SimulationSettings &settings;
+    ClickClock *base;
+    std::function<void()> stopped;
+    const qint64 startNs;
+    const qint64 stopNs;
+    qint64 nextStallNs;
+    mutable bool stopReached = false;
+    bool lastCounted = false;
+    double latenessTotalNs = 0.0;
+    SimulationResult result;
+};
+
+} // namespace
+
+// The engines run as they would for real, on the Discard backend and the
+// simulated clock; the simulator fires the interval timer itself rather
+// than waiting for the event loop.
+SimulationResult ClickSimulator::run(const SimulationSettings &settings, ClickClock *clock)
+{
+    const int rate = qBound(1, settings.clicksPerSecond, 10000);
+    const qint64 intervalNs = 1000000000LL / rate;
+    const int delayMs = qMax(1, 1000 / rate);
+
+    const InjectionBackend backend = ClickerThread::backend();
+    ClickerThread::setBackend(InjectionBackend::Discard);
+
+    const qint64 wallStart = nowNs();
+    QSemaphore stop;
+    SimulatedClock simulated(settings, clock, [&stop]() { stop.release(); });
+
+    switch (settings.mode) {
+        case SimulationSettings::Rapid: {
+            AutoClicker clicker;
+            clicker.setClock(&simulated);
+            clicker.setClickPosition(QPoint());
+            clicker.setIntervalProfile(settings.intervals);
+            clicker.setClicksPerSecond(rate);
+            clicker.start();
+            stop.acquire();
+            clicker.stop();
+            break;
+        }
+        case SimulationSettings::Interval: {
+            AutoClicker clicker;
+            clicker.setClock(&simulated);
+            clicker.setClickPosition(QPoint());
+            clicker.setIntervalProfile(settings.intervals);
+            clicker.setIntervalClick(true, delayMs);
+            clicker.start();
+            for (;;) {
+                clicker.intervalClickTimer->stop();
+                simulated.sleepUntil(clicker.intervalDueNs);
+                if (simulated.isStopped()) break;
+                clicker.intervalTimeout();
+            }
+            clicker.stop();
+            break;
+        }
+        case SimulationSettings::Jobs: {
+            ClickScheduler scheduler;
+            scheduler.setThreadCount(1);
+            scheduler.setTickUs(settings.tickUs);
+            scheduler.setClock(&simulated);
+            for (int i = 0; i < settings.jobs; ++i) {
+                ClickJob job;
+                job.clicksPerSecond = rate;
+                job.intervals = settings.intervals;
+                scheduler.addJob(job);
+            }
+            scheduler.start();
+            stop.acquire();
+            scheduler.stop();
+            break;
+        }
+    }
+    ClickerThread::setBackend(backend);
+
+    SimulationResult result = simulated.result;
+
+    // Slots before the stop at the mean rate; rapid and interval start one interval in
+    const qint64 durationNs = simulated.stopNs - simulated.startNs;
+    const qint64 slotNs = settings.mode == SimulationSettings::Interval ? qint64(delayMs) * 1000000 : intervalNs;
+    const quint64 perJob = quint64((durationNs + slotNs - 1) / slotNs);
+    result.scheduled = settings.mode == SimulationSettings::Jobs ? perJob * quint64(qMax(1, settings.jobs)) : perJob - 1;
+
+    result.meanLatenessNs = result.clicks ? simulated.latenessTotalNs / double(result.clicks) : 0.0;
+    result.wallNs = nowNs() - wallStart;
+    return result;
+}
+
+QString ClickSimulator::check(const SimulationSettings &settings, const SimulationResult &result)
+{
+    QStringList failures;
+    if (result.early) failures << QString("%1 clicks before their slot").arg(result.early);
+    if (result.lastClickNs >= qint64(settings.seconds * 1e9)) failures << "clicked after the stop";
+
+    if (settings.intervals.isFixed() && settings.mode == SimulationSettings::Jobs) {
+        // Every slot is clicked or skipped, except a last one due just before the stop
+        const quint64 accounted = result.clicks + result.missed;
+        if (accounted > result.scheduled || accounted + quint64(settings.jobs) < result.scheduled) {
+            failures << QString("%1 clicks and %2 missed for %3 scheduled").arg(result.clicks).arg(result.missed).arg(result.scheduled);
+        }
+    }
+
+    if (settings.isIdeal()) {
+        // Nothing makes a click late, so nothing may be missed or lost
+        const qint64 allowedNs = settings.mode == SimulationSettings::Jobs ? qint64(settings.tickUs) * 1000 : 0;
+        const quint64 lost = settings.mode == SimulationSettings::Jobs ? quint64(settings.jobs) : 0;
+        if (result.missed) failures << QString("%1 missed with no load").arg(result.missed);
+        if (result.maxLatenessNs > allowedNs) failures << QString("max lateness %1 ns with no load").arg(result.maxLatenessNs);
+        if (result.clicks > result.scheduled || result.clicks + lost < result.scheduled) {
+            failures << QString("%1 clicks for %2 scheduled").arg(result.clicks).arg(result.scheduled);
+        }
+    }
+    return failures.join("; ");
+}
+
+QString ClickSimulator::report(const SimulationSettings &settings, const SimulationResult &result)
+{
+    const double wallMs = result.wallNs / 1e6;
+    QString text = QString("%1 at %2/s%3 for %4 s: %5 clicks, %6 scheduled, %7 missed, lateness mean %8 us max %9 us\n")
+                       .arg(modeName(settings.mode)).arg(settings.clicksPerSecond)
+                       .arg(settings.mode == SimulationSettings::Jobs ? QString(" x %1 jobs").arg(settings.jobs) : QString())
+                       .arg(settings.seconds, 0, 'f', 1).arg(result.clicks).arg(result.scheduled).arg(result.missed)
+                       .arg(result.meanLatenessNs / 1000.0, 0, 'f', 2).arg(result.maxLatenessNs / 1000.0, 0, 'f', 2);
+    text += QString("ran in %1 ms: %2 ns per click, %3x real time")
+                .arg(wallMs, 0, 'f', 1)
+                .arg(result.clicks ? double(result.wallNs) / result.clicks : 0.0, 0, 'f', 1)
+                .arg(result.wallNs ? settings.seconds * 1e9 / result.wallNs : 0.0, 0, 'f', 0);
+    return text;
+}
+
+bool ClickSimulator::parseMode(const QString &name, SimulationSettings::Mode *mode)
+{
+    const QString lower = name.toLower();
+    if (lower == "rapid") {
+        *mode = SimulationSettings::Rapid;
+    } else if (lower == "interval") {
+        *mode = SimulationSettings::Interval;
+    } else if (lower == "jobs") {
+        *mode = SimulationSettings::Jobs;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+QString ClickSimulator::modeName(SimulationSettings::Mode mode)
+{
+    switch (mode) {
+        case SimulationSettings::Rapid:
+            return "rapid";
+        case SimulationSettings::Interval:
+            return "interval";
+        case SimulationSettings::Jobs:
+            return "jobs";
+    }
+    return QString();
+}
@@ -0,0 +1,67 @@
+#ifndef CLICKSIMULATOR_H
+#define CLICKSIMULATOR_H
+
+#include <QString>
+#include <QtGlobal>
+#include "types.h"
+
+class ClickClock;
+
+struct SimulationSettings {
+    enum Mode {
+        Rapid,    // AutoClicker's rapid loop; the next slot counts from the click (ClickPacer::Drift)
+        Interval, // AutoClicker's single-shot timer, restarted after each click in whole milliseconds
+        Jobs      // ClickScheduler with one worker thread (ClickPacer::SkipMissed)
+    };
+
+    Mode mode = Rapid;
+    int clicksPerSecond = 10000; // Per job in job mode
+    int jobs = 1;
+    int tickUs = 100;            // Timer wheel resolution
+    IntervalProfile intervals;
+    quint64 seed = 1;            // For random intervals
+
+    double seconds = 3600.0;     // Scheduled time; clicking stops at its end
+    qint64 clickCostNs = 0;      // Time each injection takes
+    qint64 wakeLatencyNs = 0;    // Oversleep on every wakeup
+    qint64 stallNs = 0;          // A stall of this long...
+    qint64 stallEveryNs = 0;     // ...this often, to exercise the catch-up policy
+
+    bool isIdeal() const
+    {
+        return intervals.isFixed() && !clickCostNs && !wakeLatencyNs && !stallNs;
+    }
+};
+
+struct SimulationResult {
+    quint64 clicks = 0;
+    quint64 missed = 0;       // Slots skipped or lost to lateness
+    quint64 scheduled = 0;    // Slots due before the stop at the mean rate
+    quint64 early = 0;        // Clicks before their slot; always 0 unless broken
+    double meanLatenessNs = 0.0;
+    qint64 maxLatenessNs = 0;
+    qint64 lastClickNs = 0;   // From the start
+    qint64 wallNs = 0;        // Real time the run took
+};
+
+// Runs the engines themselves (AutoClicker's rapid loop and interval timer
+// handler, or a ClickScheduler worker) on the Discard backend, against a
+// ClickClock that adds the simulated load and counts what they report. On
+// a VirtualClock this replays long schedules deterministically and
+// measures pure scheduling overhead; on a SteadyClock it shows what the
+// sleeps themselves add.
+class ClickSimulator
+{
+public:
+    static SimulationResult run(const SimulationSettings &settings, ClickClock *clock);
+
+    // Invariants every run must hold, plus exact counts for an ideal run;
+    // returns an empty string when they all pass
+    static QString check(const SimulationSettings &settings, const SimulationResult &result);
+    static QString report(const SimulationSettings &settings, const SimulationResult &result);
+
+    static bool parseMode(const QString &name, SimulationSettings::Mode *mode);
+    static QString modeName(SimulationSettings::Mode mode);
+};
+
+#endif // CLICKSIMULATOR_H
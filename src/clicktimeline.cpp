@@ -0,0 +1,52 @@
+#include "clicktimeline.h"
+#include "clickerthread.h"
+
+ClickTimeline::ClickTimeline()
+    : clickType(ClickType::LeftClick)
+    , event(0)
+    , events(0)
+{
+}
+
+void ClickTimeline::begin(const QPoint &pos, ClickType type, const ClickTiming &clickTiming)
+{
+    position = pos;
+    clickType = type;
+    timing = clickTiming;
+    event = 0;
+    events = isScroll(type) ? 1 : 2 * pressCount(type);
+}
+
+bool ClickTimeline::isActive() const
+{
+    return event < events;
+}
+
+qint64 ClickTimeline::step(ClickerThread *injector)
+{
+    if (!isActive()) return -1;
+
+    // A scroll is a single entry sending every notch
+    if (isScroll(clickType)) {
+        injector->performClickAt(position, clickType);
+        event = events;
+        return -1;
+    }
+
+    const bool press = event % 2 == 0;
+    if (press) {
+        injector->pressButton(position, clickType);
+    } else {
+        injector->releaseButton(position, clickType);
+    }
+
+    ++event;
+    if (!isActive()) return -1;
+    return qint64(press ? timing.pressUs : timing.gapUs) * 1000;
+}
+
+void ClickTimeline::cancel(ClickerThread *injector)
+{
+    if (isActive() && event % 2 == 1) injector->releaseButton(position, clickType);
+    event = events;
+}
@@ -0,0 +1,36 @@
+#ifndef CLICKTIMELINE_H
+#define CLICKTIMELINE_H
+
+#include <QPoint>
+#include "types.h"
+
+class ClickerThread;
+
+// The down and up events of one click as separate timeline entries. A
+// scheduler calls step() when each entry comes due and queues the next one
+// after the returned delay, so press durations and double/triple click gaps
+// never put the clicking thread to sleep.
+class ClickTimeline
+{
+public:
+    ClickTimeline();
+
+    void begin(const QPoint &pos, ClickType type, const ClickTiming &timing);
+    bool isActive() const;
+
+    // Sends the next event; returns the delay before the following one in
+    // nanoseconds, or -1 once the final release has been sent
+    qint64 step(ClickerThread *injector);
+
+    // Releases a button left pressed by an interrupted click
+    void cancel(ClickerThread *injector);
+
+private:
+    QPoint position;
+    ClickType clickType;
+    ClickTiming timing;
+    int event;  // Next event; even = press, odd = release
+    int events;
+};
+
+#endif // CLICKTIMELINE_H
@@ -0,0 +1,52 @@
+#ifndef CLICKTRACE_H
+#define CLICKTRACE_H
+
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+
+// Opt-in tracing of the click path into a Chrome trace-event JSON file, which
+// chrome://tracing and ui.perfetto.dev both open. Each thread appends to its
+// own lock-free ring and a background thread drains the rings to the file, so
+// an event costs a clock read and a few stores. While tracing is off every
+// hook is a single relaxed load.
+class ClickTrace
+{
+public:
+    static bool start(const QString &path);
+    static void stop(); // Drains what is left and closes the file
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    // Event names are kept as pointers until drained: use string literals
+    static void setThreadName(const QString &name); // Row label in the viewer
+    static void begin(const char *name);
+    static void end(const char *name);
+    static void complete(const char *name, qint64 beginNs, qint64 endNs); // Slice with known times, e.g. a late wakeup
+
+    static quint64 writtenEvents();
+    static quint64 droppedEvents(); // Lost to full rings
+
+private:
+    static std::atomic<bool> enabled;
+};
+
+// Begin/end slice around the enclosing scope
+class TraceSlice
+{
+public:
+    explicit TraceSlice(const char *name)
+        : name(ClickTrace::isEnabled() ? name : nullptr)
+    {
+        if (this->name) ClickTrace::begin(this->name);
+    }
+
+    ~TraceSlice()
+    {
+        if (name) ClickTrace::end(name);
+    }
+
+private:
+    const char *name;
+};
+
+#endif // CLICKTRACE_H
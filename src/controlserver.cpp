@@ -0,0 +1,515 @@
+#include "controlserver.h"
+#include "autoclicker.h"
+#include "motionpath.h"
+#include "intervalgenerator.h"
+#include "auditlog.h"
+#include "clicktrace.h"
+#include "stagecounters.h"
+#include "targetfeed.h"
+#include "profilestore.h"
+#include "screenlayout.h"
+#include "screenwatcher.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QList>
+#include <chrono>
+#include <cstring>
+
+#ifndef Q_OS_WIN
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+#endif
+
+ControlServer::ControlServer(AutoClicker *clicker, QObject *parent)
+    : QThread(parent)
+    , autoClicker(clicker)
+    , profiles(nullptr)
+    , listenFd(-1)
+    , running(false)
+    , lastLatencyNs(0)
+    , maxLatencyNs(0)
+{
+    wakeFds[0] = -1;
+    wakeFds[1] = -1;
+}
+
+ControlServer::~ControlServer()
+{
+    close();
+}
+
+QString ControlServer::defaultSocketPath()
+{
+    const QByteArray runtimeDir = qgetenv("XDG_RUNTIME_DIR");
+    if (!runtimeDir.isEmpty()) {
+        return QString::fromLocal8Bit(runtimeDir) + "/gert-autoclicker.sock";
+    }
+
+#ifndef Q_OS_WIN
+    // Not a shared name in /tmp: a directory that only this user can enter
+    const QString dir = QDir::tempPath() + "/gert-autoclicker-" + QString::number(getuid());
+    const QByteArray encoded = QFile::encodeName(dir);
+    struct stat info;
+    if (mkdir(encoded.constData(), 0700) < 0 && errno != EEXIST) return QString();
+    if (lstat(encoded.constData(), &info) < 0 || !S_ISDIR(info.st_mode) ||
+        info.st_uid != getuid() || (info.st_mode & 077)) {
+        qWarning() << "ControlServer: refusing socket directory" << dir << "(not a private directory of this user)";
+        return QString();
+    }
+    return dir + "/gert-autoclicker.sock";
+#else
+    return QDir::tempPath() + "/gert-autoclicker.sock";
+#endif
+}
+
+QString ControlServer::socketPath() const
+{
+    return path;
+}
+
+void ControlServer::setProfileStore(const ProfileStore *store)
+{
+    profiles = store;
+}
+
+double ControlServer::lastControlLatencyUs() const
+{
+    return lastLatencyNs.load(std::memory_order_relaxed) / 1000.0;
+}
+
+double ControlServer::maxControlLatencyUs() const
+{
+    return maxLatencyNs.load(std::memory_order_relaxed) / 1000.0;
+}
+
+void ControlServer::recordLatency(quint64 ns)
+{
+    lastLatencyNs.store(ns, std::memory_order_relaxed);
+    if (ns > maxLatencyNs.load(std::memory_order_relaxed)) {
+        maxLatencyNs.store(ns, std::memory_order_relaxed);
+    }
+}
+
+QByteArray ControlServer::handleCommand(const QByteArray &line)
+{
+    const QList<QByteArray> args = line.simplified().split(' ');
+    const QByteArray command = args.value(0).toLower();
+    if (command.isEmpty()) return QByteArray();
+
+    if (command == "start" || command == "stop" || command == "toggle") {
+        const auto received = std::chrono::steady_clock::now();
+        const bool starting = command == "start" || (command == "toggle" && !autoClicker->isRunning());
+        if (starting) {
+            autoClicker->start();
+        } else {
+            autoClicker->stop();
+        }
+        const quint64 ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - received).count();
+        recordLatency(ns);
+        return "ok " + QByteArray(starting ? "started" : "stopped") + " latency_us=" + QByteArray::number(ns / 1000.0, 'f', 1);
+    }
+
+    if (command == "pause" || command == "resume") {
+        const auto received = std::chrono::steady_clock::now();
+        const bool ok = command == "pause" ? autoClicker->pause() : autoClicker->resume();
+        const quint64 ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - received).count();
+        if (!ok) return "err " + QByteArray(command == "pause" ? "not running" : "not paused");
+        recordLatency(ns);
+        return "ok " + QByteArray(command == "pause" ? "paused" : "resumed") + " latency_us=" + QByteArray::number(ns / 1000.0, 'f', 1);
+    }
+
+    if (command == "rate") {
+        bool ok = false;
+        const int cps = args.value(1).toInt(&ok);
+        if (!ok || cps <= 0) return "err usage: rate <clicks-per-second>";
+        autoClicker->setClicksPerSecond(cps);
+        return "ok rate=" + QByteArray::number(autoClicker->getClicksPerSecond());
+    }
+
+    if (command == "shards") {
+        bool ok = false;
+        const int shards = args.value(1).toInt(&ok);
+        if (!ok || shards <= 0) return "err usage: shards <x-connections>";
+        autoClicker->setInjectionShards(shards);
+        return "ok shards=" + QByteArray::number(shards);
+    }
+
+    if (command == "timing") {
+        bool okPress = false, okGap = true;
+        ClickTiming timing;
+        timing.pressUs = args.value(1).toInt(&okPress);
+        if (args.size() > 2) timing.gapUs = args.value(2).toInt(&okGap);
+        if (!okPress || !okGap || timing.pressUs < 0 || timing.gapUs < 0) {
+            return "err usage: timing <press-us> [gap-us]";
+        }
+        autoClicker->setClickTiming(timing);
+        return "ok press_us=" + QByteArray::number(timing.pressUs) + " gap_us=" + QByteArray::number(timing.gapUs);
+    }
+
+    if (command == "keys") {
+        // The spec is the rest of the line so text: actions can contain spaces
+        const QByteArray spec = line.trimmed().mid(command.size()).trimmed();
+        if (spec.isEmpty()) return "err usage: keys <key|chord|text:string> | keys off";
+        if (spec == "off") {
+            autoClicker->setKeyAction(QString());
+            return "ok keys off";
+        }
+        if (!autoClicker->setKeyAction(QString::fromUtf8(spec))) return "err cannot map keys";
+        return "ok keys=" + spec;
+    }
+
+    if (command == "motion") {
+        const QByteArray spec = args.value(1);
+        MotionSettings settings;
+        if (spec.toLower() != "off" && !MotionPath::parse(QString::fromLatin1(spec), &settings)) {
+            return "err usage: motion <linear|bezier|minjerk>[,duration-us[,sample-hz]] | motion off";
+        }
+        autoClicker->setMotion(settings);
+        if (!settings.isEnabled()) return "ok motion off";
+        return "ok motion=" + MotionPath::curveName(settings.curve).toLatin1()
+            + " duration_us=" + QByteArray::number(settings.durationUs)
+            + " sample_hz=" + QByteArray::number(settings.sampleRate);
+    }
+
+    if (command == "intervals") {
+        // intervals <dist>[,jitter] [warmup-s] [wave-amp,period-s]
+        IntervalProfile settings;
+        bool okWarmup = true;
+        if (args.size() > 2) settings.warmupSeconds = args.value(2).toDouble(&okWarmup);
+        if (!IntervalGenerator::parse(QString::fromLatin1(args.value(1)), &settings) ||
+            !okWarmup || settings.warmupSeconds < 0.0 || args.size() > 4 ||
+            (args.size() > 3 && !IntervalGenerator::parseWave(QString::fromLatin1(args.value(3)), &settings))) {
+            return "err usage: intervals <fixed|gaussian|poisson|lognormal>[,jitter] [warmup-s] [wave-amp,period-s]";
+        }
+        autoClicker->setIntervalProfile(settings);
+        return "ok intervals=" + IntervalGenerator::distributionName(settings.distribution).toLatin1()
+            + " jitter=" + QByteArray::number(settings.jitter)
+            + " warmup_s=" + QByteArray::number(settings.warmupSeconds)
+            + " wave=" + QByteArray::number(settings.waveAmplitude) + "," + QByteArray::number(settings.wavePeriodSeconds);
+    }
+
+    if (command == "trace") {
+        const QByteArray path = args.value(1);
+        if (path.isEmpty()) return "err usage: trace <file.json> | trace off";
+        if (path == "off") {
+            if (!ClickTrace::isEnabled()) return "err not tracing";
+            ClickTrace::stop();
+            return "ok trace off events=" + QByteArray::number(ClickTrace::writtenEvents())
+                + " dropped=" + QByteArray::number(ClickTrace::droppedEvents());
+        }
+        if (!ClickTrace::start(QFile::decodeName(path))) return "err cannot start trace";
+        return "ok trace=" + path;
+    }
+
+    if (command == "stages") {
+        const QByteArray action = args.value(1);
+        if (action == "on" || action == "off") {
+            StageCounters::setEnabled(action == "on");
+            return "ok stages " + action;
+        }
+        if (action == "reset") {
+            StageCounters::reset();
+            return "ok stages reset";
+        }
+        if (!action.isEmpty()) return "err usage: stages [on|off|reset]";
+
+        // stage=count/mean_ns/max_ns for each stage that has run
+        QByteArray reply = "ok enabled=" + QByteArray::number(StageCounters::isEnabled() ? 1 : 0);
+        for (const StageCounters::Stats &entry : StageCounters::stats()) {
+            reply += QByteArray(" ") + StageCounters::stageName(entry.stage) + "=" + QByteArray::number(entry.count)
+                + "/" + QByteArray::number(entry.meanNs, 'f', 0) + "/" + QByteArray::number(entry.maxNs, 'f', 0);
+        }
+        return reply;
+    }
+
+    if (command == "trigger") {
+        // The rest of the line, so a template file name can contain spaces
+        const QByteArray spec = line.trimmed().mid(command.size()).trimmed();
+        if (spec.toLower() == "off") {
+            autoClicker->setScreenTrigger(false);
+            return "ok trigger off";
+        }
+        ScreenTrigger trigger;
+        if (!ScreenWatcher::parseTrigger(QString::fromLocal8Bit(spec), &trigger)) {
+            return "err usage: trigger pixel,x,y,rrggbb[,tolerance] | trigger change,x,y,w,h[,tolerance[,pixels]]"
+                   " | trigger template,x,y,w,h,file[,threshold] | trigger off";
+        }
+        if (!autoClicker->setScreenTrigger(true, trigger)) return "err cannot load template";
+        return "ok trigger=" + spec;
+    }
+
+    if (command == "pos") {
+        bool okX = false, okY = false;
+        const int x = args.value(1).toInt(&okX);
+        const int y = args.value(2).toInt(&okY);
+        const QString monitor = QString::fromUtf8(args.value(3));
+        if (!okX || !okY || args.size() > 4) return "err usage: pos <x> <y> [monitor]";
+        if (!autoClicker->setClickPosition(QPoint(x, y), monitor)) return "err no monitor layout";
+        return "ok pos=" + QByteArray::number(x) + "," + QByteArray::number(y)
+            + (monitor.isEmpty() ? QByteArray() : " monitor=" + monitor.toUtf8());
+    }
+
+    if (command == "monitors") {
+        // name=WxH+X+Y per monitor, with * marking the primary
+        QByteArray reply = "ok";
+        for (const MonitorInfo &monitor : autoClicker->screenLayout()->monitors()) {
+            reply += " " + monitor.name.toUtf8() + (monitor.primary ? "*" : "") + "="
+                + QByteArray::number(monitor.geometry.width()) + "x" + QByteArray::number(monitor.geometry.height())
+                + "+" + QByteArray::number(monitor.geometry.x()) + "+" + QByteArray::number(monitor.geometry.y());
+        }
+        return reply;
+    }
+
+    if (command == "unlock") {
+        autoClicker->setMouseMode(MouseMode::Unlocked);
+        autoClicker->setUseCurrentPosition(true);
+        return "ok unlocked";
+    }
+
+    if (command == "profile") {
+        // The rest of the line as it is, so a path keeps its inner whitespace
+        const QString file = QString::fromLocal8Bit(line.trimmed().mid(command.size()).trimmed());
+        if (file.isEmpty()) return "err usage: profile <file.ini>";
+
+        // Loading may start window tracking, whose notifier belongs to the engine's thread
+        bool loaded = false;
+        if (QThread::currentThread() == autoClicker->thread()) {
+            loaded = autoClicker->loadProfile(file);
+        } else {
+            QMetaObject::invokeMethod(autoClicker, [this, &file, &loaded]() {
+                loaded = autoClicker->loadProfile(file);
+            }, Qt::BlockingQueuedConnection);
+        }
+        if (!loaded) return "err cannot load profile";
+        return "ok profile loaded";
+    }
+
+    if (command == "use") {
+        const QString name = QString::fromUtf8(line.trimmed().mid(command.size()).trimmed());
+        if (name.isEmpty()) return "err usage: use <name> | use off";
+        if (name == "off") {
+            autoClicker->useProfile(nullptr);
+            return "ok profile off";
+        }
+        const StoredProfile *profile = profiles ? profiles->find(name) : nullptr;
+        if (!profile) return "err no such profile";
+        autoClicker->useProfile(profile);
+        return "ok profile=" + name.toUtf8();
+    }
+
+    if (command == "feed") {
+        const QByteArray mode = args.value(1).toLower();
+        if (mode == "off") {
+            autoClicker->setTargetFeed(false);
+            return "ok feed off";
+        }
+        if (mode != "on") return "err usage: feed on [shm-name] | feed off";
+        if (!autoClicker->setTargetFeed(true, QString::fromLocal8Bit(args.value(2)))) {
+            return "err cannot create feed";
+        }
+        return "ok feed on";
+    }
+
+    if (command == "stats") {
+        const TargetFeed *feed = autoClicker->targetFeed();
+        return "ok running=" + QByteArray::number(autoClicker->isRunning() ? 1 : 0)
+            + " paused=" + QByteArray::number(autoClicker->isPaused() ? 1 : 0)
+            + " clicks=" + QByteArray::number(autoClicker->getClickCount())
+            + " rate=" + QByteArray::number(autoClicker->getClicksPerSecond())
+            + " last_control_us=" + QByteArray::number(lastControlLatencyUs(), 'f', 1)
+            + " max_control_us=" + QByteArray::number(maxControlLatencyUs(), 'f', 1)
+            + " feed_clicks=" + QByteArray::number(feed->clickCount())
+            + " feed_expired=" + QByteArray::number(feed->expiredCount())
+            + " feed_dropped=" + QByteArray::number(feed->droppedCount())
+            + " feed_mean_us=" + QByteArray::number(feed->meanLatencyUs(), 'f', 1)
+            + " audit_written=" + QByteArray::number(AuditLog::writtenCount())
+            + " audit_dropped=" + QByteArray::number(AuditLog::droppedCount());
+    }
+
+    return "err unknown command";
+}
+
+#ifndef Q_OS_WIN
+bool ControlServer::listen(const QString &socketPath)
+{
+    close();
+
+    if (socketPath.isEmpty()) {
+        qWarning() << "ControlServer: no socket path";
+        return false;
+    }
+
+    const QByteArray encoded = QFile::encodeName(socketPath);
+    sockaddr_un address = {};
+    if (encoded.size() >= static_cast<int>(sizeof(address.sun_path))) {
+        qWarning() << "ControlServer: socket path too long:" << socketPath;
+        return false;
+    }
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, encoded.constData(), encoded.size());
+
+    // A stale socket from a previous run would make bind() fail; anything
+    // else at the path is not ours to remove
+    struct stat info;
+    if (lstat(encoded.constData(), &info) == 0) {
+        if (!S_ISSOCK(info.st_mode)) {
+            qWarning() << "ControlServer:" << socketPath << "exists and is not a socket";
+            return false;
+        }
+        ::unlink(encoded.constData());
+    }
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) return false;
+
+    // Owner only; accept() also checks the peer, for systems where the
+    // socket file mode is not enforced on connect
+    if (bind(listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 ||
+        chmod(encoded.constData(), 0600) < 0 ||
+        ::listen(listenFd, 4) < 0 ||
+        pipe(wakeFds) < 0) {
+        qWarning() << "ControlServer: cannot listen on" << socketPath;
+        close();
+        return false;
+    }
+
+    path = socketPath;
+    running.store(true);
+    start();
+    return true;
+}
+
+void ControlServer::close()
+{
+    if (running.exchange(false)) {
+        const char wake = 0;
+        if (::write(wakeFds[1], &wake, 1) < 0) {
+            // Nothing else to do; poll() still times out below
+        }
+
+        // A profile command may be blocked on a call queued to this thread
+        while (!wait(10)) {
+            if (QThread::currentThread() == autoClicker->thread()) QCoreApplication::sendPostedEvents(autoClicker);
+        }
+    }
+
+    for (int *fd : { &listenFd, &wakeFds[0], &wakeFds[1] }) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+
+    if (!path.isEmpty()) {
+        ::unlink(QFile::encodeName(path).constData());
+        path.clear();
+    }
+}
+
+// Commands start clicking and load profiles from arbitrary paths, so only
+// the user running the clicker may send them
+static bool peerIsOwner(int fd)
+{
+#ifdef SO_PEERCRED
+    ucred credentials;
+    socklen_t size = sizeof(credentials);
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &size) < 0) return false;
+    return credentials.uid == getuid();
+#else
+    uid_t uid;
+    gid_t gid;
+    if (getpeereid(fd, &uid, &gid) < 0) return false;
+    return uid == getuid();
+#endif
+}
+
+void ControlServer::run()
+{
+    std::vector<pollfd> fds;
+
+    while (running.load(std::memory_order_relaxed)) {
+        fds.clear();
+        fds.push_back({ listenFd, POLLIN, 0 });
+        fds.push_back({ wakeFds[0], POLLIN, 0 });
+        for (auto it = pending.cbegin(); it != pending.cend(); ++it) {
+            fds.push_back({ it.key(), POLLIN, 0 });
+        }
+
+        if (poll(fds.data(), fds.size(), 1000) <= 0) continue;
+        if (fds[1].revents) break;
+
+        if (fds[0].revents & POLLIN) {
+            const int client = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (client >= 0 && peerIsOwner(client)) {
+                pending.insert(client, QByteArray());
+            } else if (client >= 0) {
+                ::close(client);
+            }
+        }
+
+        for (size_t i = 2; i < fds.size(); ++i) {
+            if (!fds[i].revents) continue;
+
+            const int client = fds[i].fd;
+            char buffer[512];
+            const ssize_t count = ::read(client, buffer, sizeof(buffer));
+            if (count <= 0) {
+                ::close(client);
+                pending.remove(client);
+                continue;
+            }
+
+            QByteArray &input = pending[client];
+            input.append(buffer, static_cast<int>(count));
+
+            int newline;
+            while ((newline = input.indexOf('\n')) >= 0) {
+                const QByteArray line = input.left(newline);
+                input.remove(0, newline + 1);
+
+                QByteArray reply = handleCommand(line);
+                if (reply.isEmpty()) continue;
+                reply.append('\n');
+                if (::write(client, reply.constData(), reply.size()) < 0 && errno != EAGAIN) {
+                    break;
+                }
+            }
+
+            // Guard against a client that never sends a newline
+            if (input.size() > 4096) {
+                ::close(client);
+                pending.remove(client);
+            }
+        }
+    }
+
+    for (auto it = pending.cbegin(); it != pending.cend(); ++it) {
+        ::close(it.key());
+    }
+    pending.clear();
+}
+#else
+bool ControlServer::listen(const QString &)
+{
+    qWarning() << "ControlServer: Unix domain sockets are not supported on this platform";
+    return false;
+}
+
+void ControlServer::close()
+{
+}
+
+void ControlServer::run()
+{
+}
+#endif
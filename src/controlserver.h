@@ -0,0 +1,66 @@
+#ifndef CONTROLSERVER_H
+#define CONTROLSERVER_H
+
+#include <QThread>
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <atomic>
+
+class AutoClicker;
+class ProfileStore;
+
+// Local control socket for external orchestration. A line protocol on a
+// Unix domain socket, served from a dedicated I/O thread that drives the
+// engine directly rather than going through the GUI event loop.
+//
+//   start | stop | toggle
+//   rate <clicks-per-second>
+//   shards <k>             rapid mode over k X connections
+//   pos <x> <y>            lock clicks to a fixed position
+//   unlock                 click at the current cursor position
+//   profile <file.ini>     apply settings from an INI file
+//   use <name> | use off   switch to a profile of the store, in place
+//   feed on [name] | off   click targets pushed through shared memory
+//   stats
+//
+// Every command gets one reply line starting with "ok" or "err".
+class ControlServer : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit ControlServer(AutoClicker *clicker, QObject *parent = nullptr);
+    ~ControlServer();
+
+    bool listen(const QString &path);
+    void close();
+    QString socketPath() const;
+    void setProfileStore(const ProfileStore *store); // For "use"; set before listen()
+
+    static QString defaultSocketPath();
+
+    // Command receipt to engine start/stop returning
+    double lastControlLatencyUs() const;
+    double maxControlLatencyUs() const;
+
+protected:
+    void run() override;
+
+private:
+    QByteArray handleCommand(const QByteArray &line);
+    void recordLatency(quint64 ns);
+
+    AutoClicker *autoClicker;
+    const ProfileStore *profiles;
+    QString path;
+    int listenFd;
+    int wakeFds[2]; // Self-pipe used to interrupt poll() on close
+    std::atomic<bool> running;
+    QHash<int, QByteArray> pending; // Partial input per client
+
+    std::atomic<quint64> lastLatencyNs;
+    std::atomic<quint64> maxLatencyNs;
+};
+
+#endif // CONTROLSERVER_H
@@ -0,0 +1,174 @@
+#ifndef GERTFEED_H
+#define GERTFEED_H
+
+/*
+ * Shared-memory click target feed (Linux).
+ *
+ * The auto-clicker creates a POSIX shared memory ring; an external process
+ * attaches to it and pushes (x, y, button, deadline) records. One producer
+ * per ring. Records are published by advancing head and ringing a futex
+ * doorbell, so the consumer sleeps in the kernel rather than polling.
+ *
+ * Producer usage:
+ *
+ *     gert_feed_ring *ring = gert_feed_attach("/gert-feed");
+ *     gert_feed_push(ring, x, y, GERT_FEED_BUTTON_LEFT, gert_feed_now_ns() + 5000000);
+ *     gert_feed_detach(ring);
+ *
+ * Plain C99 plus GCC/Clang atomic builtins, so it can be included from C
+ * and C++ alike. Link with -lrt on older glibc. Strict C99 hides
+ * clock_gettime(), CLOCK_MONOTONIC and syscall(), so POSIX.1-2001 and the
+ * default Linux extensions are requested here; include this header before
+ * any system header for that to take effect.
+ */
+
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L
+#endif
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GERT_FEED_MAGIC 0x31444647u /* "GFD1" */
+#define GERT_FEED_CAPACITY 1024u    /* Records; power of two */
+#define GERT_FEED_DEFAULT_NAME "/gert-feed"
+
+enum {
+    GERT_FEED_BUTTON_DEFAULT = 0, /* Click type configured in the auto-clicker */
+    GERT_FEED_BUTTON_LEFT = 1,
+    GERT_FEED_BUTTON_MIDDLE = 2,
+    GERT_FEED_BUTTON_RIGHT = 3,
+    GERT_FEED_BUTTON_DOUBLE = 0x101, /* Left double click */
+    GERT_FEED_BUTTON_TRIPLE = 0x102  /* Left triple click */
+};
+
+typedef struct gert_feed_record {
+    int32_t x;              /* Root-window coordinates */
+    int32_t y;
+    uint32_t button;        /* GERT_FEED_BUTTON_* */
+    uint32_t reserved;
+    uint64_t deadline_ns;   /* CLOCK_MONOTONIC; dropped if passed. 0 = none */
+    uint64_t produced_ns;   /* CLOCK_MONOTONIC at push, for latency */
+} gert_feed_record;
+
+/* Producer and consumer indices live on separate cache lines */
+typedef struct gert_feed_ring {
+    uint32_t magic;
+    uint32_t capacity;
+    uint64_t dropped;       /* Pushes refused because the ring was full */
+    char pad0[48];
+
+    uint64_t head;          /* Next slot to write; producer only */
+    uint32_t doorbell;      /* Futex word, bumped on every push */
+    char pad1[52];
+
+    uint64_t tail;          /* Next slot to read; consumer only */
+    uint32_t sleeping;      /* Consumer is (about to be) in FUTEX_WAIT */
+    uint32_t consumer_pid;  /* Creator, so a ring left by a dead one can be told apart */
+    char pad2[48];
+
+    /* Published by the consumer for benchmarks */
+    uint64_t clicked;
+    uint64_t expired;
+    uint64_t latency_total_ns;
+    uint64_t latency_max_ns;
+    char pad3[32];
+
+    gert_feed_record records[GERT_FEED_CAPACITY];
+} gert_feed_ring;
+
+static inline uint64_t gert_feed_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/* Creating fails with EEXIST rather than wiping a ring that may be in use */
+static inline gert_feed_ring *gert_feed_map(const char *name, int create)
+{
+    const int fd = shm_open(name, create ? (O_RDWR | O_CREAT | O_EXCL) : O_RDWR, 0600);
+    if (fd < 0) return NULL;
+
+    if (create && ftruncate(fd, sizeof(gert_feed_ring)) < 0) {
+        close(fd);
+        return NULL;
+    }
+
+    void *memory = mmap(NULL, sizeof(gert_feed_ring), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) return NULL;
+
+    gert_feed_ring *ring = (gert_feed_ring *)memory;
+    if (create) {
+        memset(ring, 0, sizeof(gert_feed_ring));
+        ring->capacity = GERT_FEED_CAPACITY;
+        ring->consumer_pid = (uint32_t)getpid();
+        __atomic_store_n(&ring->magic, GERT_FEED_MAGIC, __ATOMIC_RELEASE);
+    } else if (__atomic_load_n(&ring->magic, __ATOMIC_ACQUIRE) != GERT_FEED_MAGIC ||
+               ring->capacity != GERT_FEED_CAPACITY) {
+        munmap(memory, sizeof(gert_feed_ring));
+        return NULL;
+    }
+    return ring;
+}
+
+/* Producer side: attach to a ring created by the auto-clicker */
+static inline gert_feed_ring *gert_feed_attach(const char *name)
+{
+    return gert_feed_map(name, 0);
+}
+
+static inline void gert_feed_detach(gert_feed_ring *ring)
+{
+    if (ring) munmap(ring, sizeof(gert_feed_ring));
+}
+
+/* Returns 0 on success, -1 if the ring is full (the record is dropped) */
+static inline int gert_feed_push(gert_feed_ring *ring, int32_t x, int32_t y,
+                                 uint32_t button, uint64_t deadline_ns)
+{
+    const uint64_t head = ring->head;
+    const uint64_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    if (head - tail >= GERT_FEED_CAPACITY) {
+        __atomic_fetch_add(&ring->dropped, 1, __ATOMIC_RELAXED);
+        return -1;
+    }
+
+    gert_feed_record *record = &ring->records[head & (GERT_FEED_CAPACITY - 1)];
+    record->x = x;
+    record->y = y;
+    record->button = button;
+    record->reserved = 0;
+    record->deadline_ns = deadline_ns;
+    record->produced_ns = gert_feed_now_ns();
+
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+    __atomic_fetch_add(&ring->doorbell, 1, __ATOMIC_SEQ_CST);
+
+    /* Only pay for the syscall when the consumer is actually asleep */
+    if (__atomic_load_n(&ring->sleeping, __ATOMIC_SEQ_CST)) {
+        syscall(SYS_futex, &ring->doorbell, FUTEX_WAKE, 1, NULL, NULL, 0);
+    }
+    return 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GERTFEED_H */
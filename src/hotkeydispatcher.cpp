@@ -0,0 +1,112 @@
+#include "hotkeydispatcher.h"
+#include "autoclicker.h"
+#include "hotkeymanager.h"
+#include "profilestore.h"
+#include <QDebug>
+
+HotkeyDispatcher::HotkeyDispatcher(HotkeyManager *hotkeys, AutoClicker *clicker, QObject *parent)
+    : QObject(parent)
+    , hotkeys(hotkeys)
+    , clicker(clicker)
+    , profiles(nullptr)
+    , holdIndex(-1)
+    , holdPressNs(0)
+{
+    connect(hotkeys, &HotkeyManager::bindingPressed, this, &HotkeyDispatcher::pressed);
+    connect(hotkeys, &HotkeyManager::bindingReleased, this, &HotkeyDispatcher::released);
+}
+
+void HotkeyDispatcher::setProfileStore(const ProfileStore *store)
+{
+    profiles = store;
+}
+
+HoldLatency HotkeyDispatcher::holdLatency() const
+{
+    return latency;
+}
+
+QString HotkeyDispatcher::holdReport() const
+{
+    if (!latency.holds) return QString();
+
+    const quint64 measured = latency.holds - latency.withoutClick;
+    const double pressMeanUs = measured ? latency.pressTotalNs / 1000.0 / measured : 0.0;
+    const double releaseMeanUs = measured ? latency.releaseTotalNs / 1000.0 / measured : 0.0;
+    return QString("%1 holds (%2 without a click): press to first click mean %3 us max %4 us, "
+                   "release to last click mean %5 us max %6 us")
+        .arg(latency.holds).arg(latency.withoutClick)
+        .arg(pressMeanUs, 0, 'f', 1).arg(latency.pressMaxNs / 1000.0, 0, 'f', 1)
+        .arg(releaseMeanUs, 0, 'f', 1).arg(latency.releaseMaxNs / 1000.0, 0, 'f', 1);
+}
+
+void HotkeyDispatcher::pressed(int index, qint64 timeNs)
+{
+    const QVector<HotkeyBinding> table = hotkeys->bindings();
+    if (index < 0 || index >= table.size()) return;
+    const HotkeyBinding &binding = table[index];
+
+    switch (binding.action) {
+        case HotkeyAction::Toggle:
+            if (clicker->isRunning()) {
+                clicker->stop();
+            } else {
+                clicker->start();
+            }
+            break;
+        case HotkeyAction::Hold:
+            // Only a hold that started the engine stops it again
+            if (clicker->isRunning() || holdIndex >= 0) break;
+            holdIndex = index;
+            holdPressNs = timeNs;
+            clicker->start(true);
+            break;
+        case HotkeyAction::Profile: {
+            if (const StoredProfile *stored = profiles ? profiles->find(binding.profile) : nullptr) {
+                clicker->useProfile(stored);
+                break;
+            }
+            
+            // Some settings only take effect on start, so a running engine is restarted
+            const bool wasRunning = clicker->isRunning();
+            if (wasRunning) clicker->stop();
+            if (!clicker->loadProfile(binding.profile)) {
+                qWarning() << "HotkeyDispatcher: cannot load profile" << binding.profile;
+            }
+            if (wasRunning) clicker->start();
+            break;
+        }
+        case HotkeyAction::Burst:
+            clicker->burst(binding.burstClicks);
+            break;
+        case HotkeyAction::Pause:
+            if (!clicker->resume()) clicker->pause();
+            break;
+    }
+}
+
+void HotkeyDispatcher::released(int index, qint64 timeNs)
+{
+    if (index != holdIndex) return;
+    holdIndex = -1;
+
+    // stop() returns once the clicking threads are done, so the last click is known
+    clicker->stop();
+    const qint64 firstNs = clicker->firstClickTimeNs();
+    const qint64 lastNs = clicker->lastClickTimeNs();
+
+    ++latency.holds;
+    if (!firstNs) {
+        ++latency.withoutClick;
+        emit holdMeasured(-1, 0);
+        return;
+    }
+
+    const qint64 pressNs = qMax(qint64(0), firstNs - holdPressNs);
+    const qint64 releaseNs = qMax(qint64(0), lastNs - timeNs);
+    latency.pressTotalNs += pressNs;
+    latency.pressMaxNs = qMax(latency.pressMaxNs, pressNs);
+    latency.releaseTotalNs += releaseNs;
+    latency.releaseMaxNs = qMax(latency.releaseMaxNs, releaseNs);
+    emit holdMeasured(pressNs, releaseNs);
+}
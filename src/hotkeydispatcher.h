@@ -0,0 +1,54 @@
+#ifndef HOTKEYDISPATCHER_H
+#define HOTKEYDISPATCHER_H
+
+#include <QObject>
+#include <QString>
+
+class AutoClicker;
+class HotkeyManager;
+class ProfileStore;
+
+// Latencies of hold-to-click: key press to the first click, and key release
+// to the last click sent after it (0 when clicking stopped in time)
+struct HoldLatency {
+    quint64 holds = 0;
+    quint64 withoutClick = 0; // Released before the first click
+    qint64 pressTotalNs = 0;
+    qint64 pressMaxNs = 0;
+    qint64 releaseTotalNs = 0;
+    qint64 releaseMaxNs = 0;
+};
+
+// Applies a HotkeyManager's binding table to an AutoClicker. Events come in
+// by table index, so dispatch is an array lookup.
+class HotkeyDispatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    HotkeyDispatcher(HotkeyManager *hotkeys, AutoClicker *clicker, QObject *parent = nullptr);
+
+    // profile:<name> switches to a profile of the store in place when it
+    // has one by that name, and loads an INI file otherwise
+    void setProfileStore(const ProfileStore *store);
+
+    HoldLatency holdLatency() const;
+    QString holdReport() const; // Empty before the first hold
+
+signals:
+    // pressToFirstClickNs is -1 when the key was released before any click
+    void holdMeasured(qint64 pressToFirstClickNs, qint64 releaseToLastClickNs);
+
+private:
+    void pressed(int index, qint64 timeNs);
+    void released(int index, qint64 timeNs);
+
+    HotkeyManager *hotkeys;
+    AutoClicker *clicker;
+    const ProfileStore *profiles;
+    int holdIndex; // Binding holding the engine running, or -1
+    qint64 holdPressNs;
+    HoldLatency latency;
+};
+
+#endif // HOTKEYDISPATCHER_H
@@ -1,10 +1,117 @@
 #include "hotkeymanager.h"
 #include <QDebug>
-#include <QKeySequence>
+#include <QSet>
+#include <QStringList>
+#include <chrono>
+#if !defined(Q_OS_WIN) && !defined(Q_OS_MAC)
+#include <QSocketNotifier>
+#endif
+
+static qint64 nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 
 #ifdef Q_OS_WIN
-#include <QWidget>
-#include <QApplication>
+static int windowsVirtualKey(int key)
+{
+    if (key >= Qt::Key_F1 && key <= Qt::Key_F24) return VK_F1 + (key - Qt::Key_F1);
+    if ((key >= 'A' && key <= 'Z') || (key >= '0' && key <= '9')) return key;
+    
+    switch (key) {
+        case Qt::Key_Escape: return VK_ESCAPE;
+        case Qt::Key_Tab: return VK_TAB;
+        case Qt::Key_Space: return VK_SPACE;
+        case Qt::Key_Return:
+        case Qt::Key_Enter: return VK_RETURN;
+        case Qt::Key_Insert: return VK_INSERT;
+        case Qt::Key_Delete: return VK_DELETE;
+        case Qt::Key_Home: return VK_HOME;
+        case Qt::Key_End: return VK_END;
+        case Qt::Key_PageUp: return VK_PRIOR;
+        case Qt::Key_PageDown: return VK_NEXT;
+        case Qt::Key_Pause: return VK_PAUSE;
+        case Qt::Key_Print: return VK_SNAPSHOT;
+        case Qt::Key_Backspace: return VK_BACK;
+    }
+    return 0;
+}
+#elif defined(Q_OS_MAC)
+static int macKeyCode(int key)
+{
+    // Virtual key codes follow the ANSI layout, not the alphabet
+    static const int letters[] = {
+        kVK_ANSI_A, kVK_ANSI_B, kVK_ANSI_C, kVK_ANSI_D, kVK_ANSI_E, kVK_ANSI_F, kVK_ANSI_G, kVK_ANSI_H, kVK_ANSI_I,
+        kVK_ANSI_J, kVK_ANSI_K, kVK_ANSI_L, kVK_ANSI_M, kVK_ANSI_N, kVK_ANSI_O, kVK_ANSI_P, kVK_ANSI_Q, kVK_ANSI_R,
+        kVK_ANSI_S, kVK_ANSI_T, kVK_ANSI_U, kVK_ANSI_V, kVK_ANSI_W, kVK_ANSI_X, kVK_ANSI_Y, kVK_ANSI_Z
+    };
+    static const int digits[] = {
+        kVK_ANSI_0, kVK_ANSI_1, kVK_ANSI_2, kVK_ANSI_3, kVK_ANSI_4,
+        kVK_ANSI_5, kVK_ANSI_6, kVK_ANSI_7, kVK_ANSI_8, kVK_ANSI_9
+    };
+    static const int functionKeys[] = {
+        kVK_F1, kVK_F2, kVK_F3, kVK_F4, kVK_F5, kVK_F6, kVK_F7, kVK_F8, kVK_F9, kVK_F10,
+        kVK_F11, kVK_F12, kVK_F13, kVK_F14, kVK_F15, kVK_F16, kVK_F17, kVK_F18, kVK_F19, kVK_F20
+    };
+    
+    if (key >= 'A' && key <= 'Z') return letters[key - 'A'];
+    if (key >= '0' && key <= '9') return digits[key - '0'];
+    if (key >= Qt::Key_F1 && key <= Qt::Key_F20) return functionKeys[key - Qt::Key_F1];
+    
+    switch (key) {
+        case Qt::Key_Escape: return kVK_Escape;
+        case Qt::Key_Tab: return kVK_Tab;
+        case Qt::Key_Space: return kVK_Space;
+        case Qt::Key_Return: return kVK_Return;
+        case Qt::Key_Enter: return kVK_ANSI_KeypadEnter;
+        case Qt::Key_Insert: return kVK_Help;
+        case Qt::Key_Delete: return kVK_ForwardDelete;
+        case Qt::Key_Home: return kVK_Home;
+        case Qt::Key_End: return kVK_End;
+        case Qt::Key_PageUp: return kVK_PageUp;
+        case Qt::Key_PageDown: return kVK_PageDown;
+        case Qt::Key_Backspace: return kVK_Delete;
+    }
+    return -1;
+}
+#else
+// Modifiers that tell bindings apart; Caps Lock and Num Lock are ignored
+static const unsigned int BindingModifiers = ShiftMask | ControlMask | Mod1Mask | Mod4Mask;
+static const unsigned int LockModifiers[] = { 0, LockMask, Mod2Mask, LockMask | Mod2Mask };
+
+static KeySym x11Keysym(int key)
+{
+    if (key >= Qt::Key_F1 && key <= Qt::Key_F35) return XK_F1 + (key - Qt::Key_F1);
+    if ((key >= 'A' && key <= 'Z') || (key >= '0' && key <= '9')) return KeySym(key);
+    
+    switch (key) {
+        case Qt::Key_Escape: return XK_Escape;
+        case Qt::Key_Tab: return XK_Tab;
+        case Qt::Key_Space: return XK_space;
+        case Qt::Key_Return: return XK_Return;
+        case Qt::Key_Enter: return XK_KP_Enter;
+        case Qt::Key_Insert: return XK_Insert;
+        case Qt::Key_Delete: return XK_Delete;
+        case Qt::Key_Home: return XK_Home;
+        case Qt::Key_End: return XK_End;
+        case Qt::Key_PageUp: return XK_Prior;
+        case Qt::Key_PageDown: return XK_Next;
+        case Qt::Key_Pause: return XK_Pause;
+        case Qt::Key_Print: return XK_Print;
+        case Qt::Key_Backspace: return XK_BackSpace;
+    }
+    return 0;
+}
+
+// XGrabKey reports a key another client holds asynchronously, as BadAccess
+static bool grabFailed = false;
+
+static int grabErrorHandler(Display *, XErrorEvent *error)
+{
+    if (error->error_code == BadAccess) grabFailed = true;
+    return 0;
+}
 #endif
 
 HotkeyManager::HotkeyManager(QObject *parent)
@@ -12,16 +119,13 @@ HotkeyManager::HotkeyManager(QObject *parent)
     , registered(false)
 #ifdef Q_OS_WIN
     , hwnd(nullptr)
-    , hotkeyId(1)
+    , releaseTimer(nullptr)
 #elif defined(Q_OS_MAC)
     , eventHandler(nullptr)
-    , hotKeyRef(nullptr)
 #else
     , display(nullptr)
     , root(0)
-    , hotkeyKeycode(0)
-    , hotkeyModifiers(0)
-    , checkTimer(nullptr)
+    , notifier(nullptr)
 #endif
 {
 #ifdef Q_OS_WIN
@@ -36,18 +140,23 @@ HotkeyManager::HotkeyManager(QObject *parent)
         SetWindowLongPtr(hwnd, GWLP_WNDPROC, (LONG_PTR)windowProc);
         SetWindowLongPtr(hwnd, GWLP_USERDATA, (LONG_PTR)this);
     }
-#elif !defined(Q_OS_MAC)
-    checkTimer = new QTimer(this);
-    connect(checkTimer, &QTimer::timeout, this, [this]() {
-        // Check for hotkey press on Linux
-        if (display && hotkeyKeycode) {
-            char keys[32];
-            XQueryKeymap(display, keys);
-            if (keys[hotkeyKeycode / 8] & (1 << (hotkeyKeycode % 8))) {
-                emit hotkeyPressed();
+    
+    releaseTimer = new QTimer(this);
+    releaseTimer->setTimerType(Qt::PreciseTimer);
+    connect(releaseTimer, &QTimer::timeout, this, [this]() {
+        bool anyDown = false;
+        for (int i = 0; i < table.size(); ++i) {
+            if (!down[i]) continue;
+            if (GetAsyncKeyState(virtualKeys[i]) & 0x8000) {
+                anyDown = true;
+            } else {
+                release(i);
             }
         }
+        if (!anyDown) releaseTimer->stop();
     });
+#elif !defined(Q_OS_MAC)
+    for (int &index : held) index = -1;
 #endif
 }
 
@@ -60,161 +169,185 @@ HotkeyManager::~HotkeyManager()
         DestroyWindow(hwnd);
         hwnd = nullptr;
     }
-#elif defined(Q_OS_MAC)
-    cleanupGlobalHotkey();
-#else
-    if (display) {
-        XCloseDisplay(display);
-        display = nullptr;
-    }
 #endif
 }
 
-bool HotkeyManager::registerHotkey(const QString &keySequence)
+bool HotkeyManager::setBindings(const QVector<HotkeyBinding> &bindings)
 {
     unregisterHotkey();
     
-    currentHotkey = keySequence;
-    
-#ifdef Q_OS_WIN
-    // Parse key sequence for Windows
-    QKeySequence seq(keySequence);
-    if (seq.isEmpty()) return false;
-    
-    int key = seq[0].toCombined() & 0xFFFF;
-    int modifiers = 0;
-    
-    if (seq[0].keyboardModifiers() & Qt::ControlModifier) modifiers |= MOD_CONTROL;
-    if (seq[0].keyboardModifiers() & Qt::AltModifier) modifiers |= MOD_ALT;
-    if (seq[0].keyboardModifiers() & Qt::ShiftModifier) modifiers |= MOD_SHIFT;
-    if (seq[0].keyboardModifiers() & Qt::MetaModifier) modifiers |= MOD_WIN;
-    
-    // Convert Qt key to Windows virtual key
-    if (key >= Qt::Key_F1 && key <= Qt::Key_F12) {
-        key = VK_F1 + (key - Qt::Key_F1);
-    }
-    
-    if (RegisterHotKey(hwnd, hotkeyId, modifiers, key)) {
-        registered = true;
-        return true;
+    // Parse everything first; a key may only be bound once
+    QVector<int> keys;
+    QVector<Qt::KeyboardModifiers> keyModifiers;
+    QSet<qint64> seen;
+    for (const HotkeyBinding &binding : bindings) {
+        int key = 0;
+        Qt::KeyboardModifiers modifiers;
+        if (!parseHotkey(binding.keys, &key, &modifiers)) {
+            qWarning() << "HotkeyManager: cannot parse" << binding.keys;
+            return false;
+        }
+        const qint64 id = qint64(key) << 32 | int(modifiers);
+        if (seen.contains(id)) {
+            qWarning() << "HotkeyManager:" << binding.keys << "is bound twice";
+            return false;
+        }
+        seen.insert(id);
+        keys.append(key);
+        keyModifiers.append(modifiers);
     }
     
-#elif defined(Q_OS_MAC)
-    // Parse key sequence for macOS
-    QKeySequence seq(keySequence);
-    if (seq.isEmpty()) return false;
+    table = bindings;
+    down = QVector<bool>(table.size(), false);
     
-    int qtKey = seq[0].key();
-    int modifiers = 0;
-    
-    if (seq[0].keyboardModifiers() & Qt::ControlModifier) modifiers |= cmdKey;
-    if (seq[0].keyboardModifiers() & Qt::AltModifier) modifiers |= optionKey;
-    if (seq[0].keyboardModifiers() & Qt::ShiftModifier) modifiers |= shiftKey;
-    if (seq[0].keyboardModifiers() & Qt::MetaModifier) modifiers |= cmdKey;
-    
-    // Convert Qt key to macOS key code
-    int key = 0;
-    if (qtKey >= Qt::Key_F1 && qtKey <= Qt::Key_F12) {
-        // Map F keys to correct macOS virtual key codes
-        const int fKeyMap[] = {
-            0x7A, // F1 - kVK_F1
-            0x78, // F2 - kVK_F2
-            0x63, // F3 - kVK_F3
-            0x76, // F4 - kVK_F4
-            0x60, // F5 - kVK_F5
-            0x61, // F6 - kVK_F6
-            0x62, // F7 - kVK_F7
-            0x64, // F8 - kVK_F8
-            0x65, // F9 - kVK_F9
-            0x6D, // F10 - kVK_F10
-            0x67, // F11 - kVK_F11
-            0x6F  // F12 - kVK_F12
-        };
-        int fIndex = qtKey - Qt::Key_F1;
-        if (fIndex >= 0 && fIndex < 12) {
-            key = fKeyMap[fIndex];
+#ifdef Q_OS_WIN
+    for (int i = 0; i < table.size(); ++i) {
+        int modifiers = MOD_NOREPEAT;
+        if (keyModifiers[i] & Qt::ControlModifier) modifiers |= MOD_CONTROL;
+        if (keyModifiers[i] & Qt::AltModifier) modifiers |= MOD_ALT;
+        if (keyModifiers[i] & Qt::ShiftModifier) modifiers |= MOD_SHIFT;
+        if (keyModifiers[i] & Qt::MetaModifier) modifiers |= MOD_WIN;
+        
+        const int key = windowsVirtualKey(keys[i]);
+        virtualKeys.append(key);
+        if (!key || !RegisterHotKey(hwnd, i + 1, modifiers, key)) {
+            qWarning() << "HotkeyManager: cannot register" << table[i].keys;
+            unregisterHotkey();
+            return false;
         }
-    } else {
-        key = qtKey; // For other keys, use Qt key directly
     }
     
-    EventTypeSpec eventType;
-    eventType.eventClass = kEventClassKeyboard;
-    eventType.eventKind = kEventHotKeyPressed;
-    
-    // Create event handler function
-    auto eventHandlerFunc = [](EventHandlerCallRef nextHandler, EventRef theEvent, void *userData) -> OSStatus {
-        HotkeyManager *manager = static_cast<HotkeyManager*>(userData);
-        emit manager->hotkeyPressed();
-        return noErr;
-    };
-    
-    InstallEventHandler(GetApplicationEventTarget(), 
-                       NewEventHandlerUPP(eventHandlerFunc), 
-                       1, &eventType, this, &eventHandler);
-    
-    hotKeyID.signature = 'htk1';
-    hotKeyID.id = 1;
+#elif defined(Q_OS_MAC)
+    EventTypeSpec eventTypes[2];
+    eventTypes[0].eventClass = kEventClassKeyboard;
+    eventTypes[0].eventKind = kEventHotKeyPressed;
+    eventTypes[1].eventClass = kEventClassKeyboard;
+    eventTypes[1].eventKind = kEventHotKeyReleased;
+    InstallEventHandler(GetApplicationEventTarget(), NewEventHandlerUPP(eventHandlerProc),
+                        2, eventTypes, this, &eventHandler);
     
-    if (RegisterEventHotKey(key, modifiers, hotKeyID, GetApplicationEventTarget(), 0, &hotKeyRef) == noErr) {
-        registered = true;
-        return true;
+    for (int i = 0; i < table.size(); ++i) {
+        int modifiers = 0;
+        if (keyModifiers[i] & Qt::ControlModifier) modifiers |= cmdKey;
+        if (keyModifiers[i] & Qt::AltModifier) modifiers |= optionKey;
+        if (keyModifiers[i] & Qt::ShiftModifier) modifiers |= shiftKey;
+        if (keyModifiers[i] & Qt::MetaModifier) modifiers |= cmdKey;
+        
+        EventHotKeyID hotKeyID;
+        hotKeyID.signature = 'htk1';
+        hotKeyID.id = i + 1;
+        EventHotKeyRef hotKeyRef = nullptr;
+        const int key = macKeyCode(keys[i]);
+        if (key < 0 || RegisterEventHotKey(key, modifiers, hotKeyID, GetApplicationEventTarget(), 0, &hotKeyRef) != noErr) {
+            qWarning() << "HotkeyManager: cannot register" << table[i].keys;
+            unregisterHotkey();
+            return false;
+        }
+        hotKeyRefs.append(hotKeyRef);
     }
     
 #else
-    // Parse key sequence for Linux/X11
     display = XOpenDisplay(nullptr);
-    if (!display) return false;
-    
+    if (!display) {
+        unregisterHotkey();
+        return false;
+    }
     root = DefaultRootWindow(display);
     
-    QKeySequence seq(keySequence);
-    if (seq.isEmpty()) return false;
-    
-    int key = seq[0].toCombined() & 0xFFFF;
-    int modifiers = 0;
+    // Held keys repeat as presses only, without a release in between
+    XkbSetDetectableAutoRepeat(display, True, nullptr);
     
-    if (seq[0].keyboardModifiers() & Qt::ControlModifier) modifiers |= ControlMask;
-    if (seq[0].keyboardModifiers() & Qt::AltModifier) modifiers |= Mod1Mask;
-    if (seq[0].keyboardModifiers() & Qt::ShiftModifier) modifiers |= ShiftMask;
-    if (seq[0].keyboardModifiers() & Qt::MetaModifier) modifiers |= Mod4Mask;
+    grabFailed = false;
+    XErrorHandler previousHandler = XSetErrorHandler(grabErrorHandler);
+    for (int i = 0; i < table.size(); ++i) {
+        unsigned int modifiers = 0;
+        if (keyModifiers[i] & Qt::ControlModifier) modifiers |= ControlMask;
+        if (keyModifiers[i] & Qt::AltModifier) modifiers |= Mod1Mask;
+        if (keyModifiers[i] & Qt::ShiftModifier) modifiers |= ShiftMask;
+        if (keyModifiers[i] & Qt::MetaModifier) modifiers |= Mod4Mask;
+        
+        const KeySym keysym = x11Keysym(keys[i]);
+        const KeyCode keycode = keysym ? XKeysymToKeycode(display, keysym) : 0;
+        if (!keycode) {
+            qWarning() << "HotkeyManager: no keycode for" << table[i].keys;
+            grabFailed = true;
+            break;
+        }
+        
+        lookup.insert(quint32(keycode) << 8 | modifiers, i);
+        for (unsigned int locks : LockModifiers) {
+            XGrabKey(display, keycode, modifiers | locks, root, True, GrabModeAsync, GrabModeAsync);
+        }
+    }
+    XSync(display, False);
+    XSetErrorHandler(previousHandler);
     
-    // Convert Qt key to X11 keycode
-    if (key >= Qt::Key_F1 && key <= Qt::Key_F12) {
-        hotkeyKeycode = XKeysymToKeycode(display, XK_F1 + (key - Qt::Key_F1));
-    } else {
-        hotkeyKeycode = XKeysymToKeycode(display, key);
+    if (grabFailed) {
+        qWarning() << "HotkeyManager: cannot grab the hotkeys; another client may hold one";
+        unregisterHotkey();
+        return false;
     }
     
-    hotkeyModifiers = modifiers;
-    registered = true;
-    checkTimer->start(50); // Check every 50ms
-    return true;
+    // Key events arrive on the display connection; XSync may already have queued some
+    notifier = new QSocketNotifier(ConnectionNumber(display), QSocketNotifier::Read, this);
+    connect(notifier, &QSocketNotifier::activated, this, [this]() {
+        readEvents();
+    });
+    readEvents();
 #endif
     
-    return false;
+    currentHotkey = table.isEmpty() ? QString() : table.first().keys;
+    for (const HotkeyBinding &binding : table) {
+        if (binding.action == HotkeyAction::Toggle) {
+            currentHotkey = binding.keys;
+            break;
+        }
+    }
+    registered = !table.isEmpty();
+    return true;
+}
+
+QVector<HotkeyBinding> HotkeyManager::bindings() const
+{
+    return table;
+}
+
+bool HotkeyManager::registerHotkey(const QString &keySequence)
+{
+    HotkeyBinding binding;
+    binding.keys = keySequence;
+    currentHotkey = keySequence;
+    return setBindings({ binding });
 }
 
 void HotkeyManager::unregisterHotkey()
 {
-    if (!registered) return;
-    
 #ifdef Q_OS_WIN
     if (hwnd) {
-        UnregisterHotKey(hwnd, hotkeyId);
+        for (int i = 0; i < virtualKeys.size(); ++i) {
+            UnregisterHotKey(hwnd, i + 1);
+        }
+    }
+    virtualKeys.clear();
+    if (releaseTimer) {
+        releaseTimer->stop();
     }
 #elif defined(Q_OS_MAC)
     cleanupGlobalHotkey();
 #else
-    if (checkTimer) {
-        checkTimer->stop();
-    }
+    delete notifier;
+    notifier = nullptr;
     if (display) {
+        // Closing the connection releases its grabs
         XCloseDisplay(display);
         display = nullptr;
     }
+    lookup.clear();
+    for (int &index : held) index = -1;
 #endif
     
+    table.clear();
+    down.clear();
     registered = false;
 }
 
@@ -228,13 +361,149 @@ bool HotkeyManager::isHotkeyRegistered() const
     return registered;
 }
 
+void HotkeyManager::press(int index)
+{
+    if (index < 0 || index >= down.size() || down[index]) return;
+    down[index] = true;
+    emit bindingPressed(index, nowNs());
+}
+
+void HotkeyManager::release(int index)
+{
+    if (index < 0 || index >= down.size() || !down[index]) return;
+    down[index] = false;
+    emit bindingReleased(index, nowNs());
+}
+
+bool HotkeyManager::parseHotkey(const QString &text, int *key, Qt::KeyboardModifiers *modifiers)
+{
+    static const struct {
+        const char *name;
+        int key;
+    } namedKeys[] = {
+        { "ESC", Qt::Key_Escape }, { "ESCAPE", Qt::Key_Escape }, { "TAB", Qt::Key_Tab },
+        { "SPACE", Qt::Key_Space }, { "RETURN", Qt::Key_Return }, { "ENTER", Qt::Key_Enter },
+        { "INS", Qt::Key_Insert }, { "INSERT", Qt::Key_Insert }, { "DEL", Qt::Key_Delete },
+        { "DELETE", Qt::Key_Delete }, { "HOME", Qt::Key_Home }, { "END", Qt::Key_End },
+        { "PGUP", Qt::Key_PageUp }, { "PAGEUP", Qt::Key_PageUp }, { "PGDOWN", Qt::Key_PageDown },
+        { "PAGEDOWN", Qt::Key_PageDown }, { "PAUSE", Qt::Key_Pause }, { "PRINT", Qt::Key_Print },
+        { "BACKSPACE", Qt::Key_Backspace },
+    };
+    
+    *key = 0;
+    *modifiers = Qt::NoModifier;
+    
+    const QStringList parts = text.toUpper().split('+', Qt::SkipEmptyParts);
+    if (parts.isEmpty()) return false;
+    
+    for (int i = 0; i < parts.size() - 1; ++i) {
+        const QString part = parts[i].trimmed();
+        if (part == "CTRL" || part == "CONTROL") {
+            *modifiers |= Qt::ControlModifier;
+        } else if (part == "ALT") {
+            *modifiers |= Qt::AltModifier;
+        } else if (part == "SHIFT") {
+            *modifiers |= Qt::ShiftModifier;
+        } else if (part == "META" || part == "WIN" || part == "SUPER") {
+            *modifiers |= Qt::MetaModifier;
+        } else {
+            return false;
+        }
+    }
+    
+    const QString name = parts.last().trimmed();
+    const ushort first = name.isEmpty() ? 0 : name.at(0).unicode();
+    if (name.size() == 1 && ((first >= 'A' && first <= 'Z') || (first >= '0' && first <= '9'))) {
+        // Qt::Key values for letters and digits are their ASCII codes
+        *key = first;
+        return true;
+    }
+    
+    if (name.size() > 1 && first == 'F') {
+        bool ok = false;
+        const int number = name.mid(1).toInt(&ok);
+        if (ok && number >= 1 && number <= 35) {
+            *key = Qt::Key_F1 + number - 1;
+            return true;
+        }
+    }
+    
+    for (const auto &named : namedKeys) {
+        if (name == QLatin1String(named.name)) {
+            *key = named.key;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+bool HotkeyManager::parseBinding(const QString &text, HotkeyBinding *binding)
+{
+    const int equals = text.indexOf('=');
+    if (equals <= 0) return false;
+    
+    HotkeyBinding parsed;
+    parsed.keys = text.left(equals).trimmed();
+    int key = 0;
+    Qt::KeyboardModifiers modifiers;
+    if (!parseHotkey(parsed.keys, &key, &modifiers)) return false;
+    
+    const QString spec = text.mid(equals + 1).trimmed();
+    const int colon = spec.indexOf(':');
+    const QString name = (colon < 0 ? spec : spec.left(colon)).trimmed().toLower();
+    const QString argument = colon < 0 ? QString() : spec.mid(colon + 1).trimmed();
+    
+    if (name == "toggle") {
+        parsed.action = HotkeyAction::Toggle;
+    } else if (name == "hold") {
+        parsed.action = HotkeyAction::Hold;
+    } else if (name == "pause") {
+        parsed.action = HotkeyAction::Pause;
+    } else if (name == "burst") {
+        bool ok = false;
+        parsed.action = HotkeyAction::Burst;
+        parsed.burstClicks = argument.toInt(&ok);
+        if (!ok || parsed.burstClicks <= 0) return false;
+    } else if (name == "profile") {
+        parsed.action = HotkeyAction::Profile;
+        parsed.profile = argument;
+        if (parsed.profile.isEmpty()) return false;
+    } else {
+        return false;
+    }
+    if (colon >= 0 && parsed.action != HotkeyAction::Burst && parsed.action != HotkeyAction::Profile) return false;
+    
+    *binding = parsed;
+    return true;
+}
+
+QString HotkeyManager::actionName(HotkeyAction action)
+{
+    switch (action) {
+        case HotkeyAction::Toggle:
+            return "toggle";
+        case HotkeyAction::Hold:
+            return "hold";
+        case HotkeyAction::Profile:
+            return "profile";
+        case HotkeyAction::Burst:
+            return "burst";
+        case HotkeyAction::Pause:
+            return "pause";
+    }
+    return QString();
+}
+
 #ifdef Q_OS_WIN
 LRESULT CALLBACK HotkeyManager::windowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 {
     if (uMsg == WM_HOTKEY) {
         HotkeyManager *manager = reinterpret_cast<HotkeyManager*>(GetWindowLongPtr(hwnd, GWLP_USERDATA));
         if (manager) {
-            emit manager->hotkeyPressed();
+            // Hotkey ids are table indices plus one
+            manager->press(int(wParam) - 1);
+            manager->releaseTimer->start(5);
         }
         return 0;
     }
@@ -243,15 +512,69 @@ LRESULT CALLBACK HotkeyManager::windowProc(HWND hwnd, UINT uMsg, WPARAM wParam,
 #endif
 
 #ifdef Q_OS_MAC
+OSStatus HotkeyManager::eventHandlerProc(EventHandlerCallRef nextHandler, EventRef event, void *userData)
+{
+    Q_UNUSED(nextHandler);
+    EventHotKeyID hotKeyID;
+    if (GetEventParameter(event, kEventParamDirectObject, typeEventHotKeyID, nullptr,
+                          sizeof(hotKeyID), nullptr, &hotKeyID) != noErr) {
+        return eventNotHandledErr;
+    }
+    
+    HotkeyManager *manager = static_cast<HotkeyManager*>(userData);
+    if (GetEventKind(event) == kEventHotKeyPressed) {
+        manager->press(int(hotKeyID.id) - 1);
+    } else {
+        manager->release(int(hotKeyID.id) - 1);
+    }
+    return noErr;
+}
+
 void HotkeyManager::cleanupGlobalHotkey()
 {
-    if (hotKeyRef) {
+    for (EventHotKeyRef hotKeyRef : hotKeyRefs) {
         UnregisterEventHotKey(hotKeyRef);
-        hotKeyRef = nullptr;
     }
+    hotKeyRefs.clear();
     if (eventHandler) {
         RemoveEventHandler(eventHandler);
         eventHandler = nullptr;
     }
 }
-#endif 
\ No newline at end of file
+#endif
+
+#if !defined(Q_OS_WIN) && !defined(Q_OS_MAC)
+// A press is looked up by keycode and modifiers; its release by keycode
+// alone, since the modifiers may have been let go first
+void HotkeyManager::readEvents()
+{
+    while (display && XPending(display)) {
+        XEvent event;
+        XNextEvent(display, &event);
+        if (event.type != KeyPress && event.type != KeyRelease) continue;
+        
+        const unsigned int keycode = event.xkey.keycode & 0xff;
+        if (event.type == KeyPress) {
+            const auto it = lookup.constFind(quint32(keycode) << 8 | (event.xkey.state & BindingModifiers));
+            if (it == lookup.constEnd()) continue;
+            held[keycode] = it.value();
+            press(it.value());
+            continue;
+        }
+        
+        // Without detectable auto-repeat a held key repeats as release and press at the same time
+        if (XEventsQueued(display, QueuedAfterReading)) {
+            XEvent next;
+            XPeekEvent(display, &next);
+            if (next.type == KeyPress && next.xkey.keycode == event.xkey.keycode && next.xkey.time == event.xkey.time) {
+                XNextEvent(display, &next);
+                continue;
+            }
+        }
+        
+        const int index = held[keycode];
+        held[keycode] = -1;
+        release(index);
+    }
+}
+#endif
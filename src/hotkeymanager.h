@@ -3,8 +3,9 @@
 
 #include <QObject>
 #include <QString>
-#include <QKeySequence>
 #include <QTimer>
+#include <QVector>
+#include <QHash>
 
 #ifdef Q_OS_WIN
 #include <windows.h>
@@ -17,11 +18,29 @@
 #include <X11/Xlib.h>
 #include <X11/keysym.h>
 #include <X11/extensions/XTest.h>
+#include <X11/XKBlib.h>
 #undef Status  // X11 defines Status, which conflicts with Qt
 #undef Bool    // X11 defines Bool, which can conflict with Qt
 #undef None    // X11 defines None, which can conflict with Qt
 #endif
 
+class QSocketNotifier;
+
+enum class HotkeyAction {
+    Toggle,  // Start or stop
+    Hold,    // Click exactly while the key is down
+    Profile, // Load an INI profile, restarting if running
+    Burst,   // A fixed number of clicks, then stop
+    Pause    // Pause or resume
+};
+
+struct HotkeyBinding {
+    QString keys; // "Ctrl+Shift+F6" style
+    HotkeyAction action = HotkeyAction::Toggle;
+    int burstClicks = 0;
+    QString profile;
+};
+
 class HotkeyManager : public QObject
 {
     Q_OBJECT
@@ -30,36 +49,60 @@ public:
     explicit HotkeyManager(QObject *parent = nullptr);
     ~HotkeyManager();
 
-    bool registerHotkey(const QString &keySequence);
+    // Registers the whole table, replacing the previous one. Nothing is
+    // registered if any binding cannot be, or two share a key.
+    bool setBindings(const QVector<HotkeyBinding> &bindings);
+    QVector<HotkeyBinding> bindings() const;
+
+    bool registerHotkey(const QString &keySequence); // A single toggle binding
     void unregisterHotkey();
     QString getCurrentHotkey() const;
     bool isHotkeyRegistered() const;
 
+    // Parses "Ctrl+Shift+F6" style text into a Qt::Key value and modifiers.
+    // Replaces QKeySequence so the engine only needs QtCore.
+    static bool parseHotkey(const QString &text, int *key, Qt::KeyboardModifiers *modifiers);
+
+    // "keys=action[:argument]", e.g. "F7=hold", "Ctrl+F8=burst:50", "F9=profile:fast.ini"
+    static bool parseBinding(const QString &text, HotkeyBinding *binding);
+    static QString actionName(HotkeyAction action);
+
 signals:
-    void hotkeyPressed();
+    // timeNs is the steady clock when the event was read, for latency
+    // measurements. Auto-repeat does not repeat bindingPressed().
+    void bindingPressed(int index, qint64 timeNs);
+    void bindingReleased(int index, qint64 timeNs);
 
 private:
     void setupGlobalHotkey();
     void cleanupGlobalHotkey();
-    
+    void press(int index);
+    void release(int index);
+
+    QVector<HotkeyBinding> table;
+    QVector<bool> down; // Per binding, to drop auto-repeat
+
 #ifdef Q_OS_WIN
     static LRESULT CALLBACK windowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
     HWND hwnd;
-    int hotkeyId;
+    QVector<int> virtualKeys; // Per binding; hotkey ids are index + 1
+    QTimer *releaseTimer;     // WM_HOTKEY has no release, so held keys are polled
 #elif defined(Q_OS_MAC)
+    static OSStatus eventHandlerProc(EventHandlerCallRef nextHandler, EventRef event, void *userData);
     EventHandlerRef eventHandler;
-    EventHotKeyRef hotKeyRef;
-    EventHotKeyID hotKeyID;
+    QVector<EventHotKeyRef> hotKeyRefs; // Per binding; hotkey ids are index + 1
 #else
+    void readEvents();
+
     Display *display;
     Window root;
-    int hotkeyKeycode;
-    unsigned int hotkeyModifiers;
-    QTimer *checkTimer;
+    QSocketNotifier *notifier;
+    QHash<quint32, int> lookup; // (keycode << 8 | modifier mask) to binding
+    int held[256];              // Binding pressed on each keycode, or -1
 #endif
 
     QString currentHotkey;
     bool registered;
 };
 
-#endif // HOTKEYMANAGER_H 
\ No newline at end of file
+#endif // HOTKEYMANAGER_H
@@ -0,0 +1,118 @@
+#include "inputprobe.h"
+#include <chrono>
+
+#if !defined(Q_OS_WIN) && !defined(Q_OS_MAC)
+#include <X11/Xlib.h>
+#include <X11/extensions/XInput2.h>
+#include <poll.h>
+#endif
+
+static qint64 nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+InputProbe::InputProbe()
+    : display(nullptr)
+    , opcode(0)
+{
+}
+
+InputProbe::~InputProbe()
+{
+    stop();
+}
+
+bool InputProbe::isActive() const
+{
+    return display != nullptr;
+}
+
+#if !defined(Q_OS_WIN) && !defined(Q_OS_MAC)
+bool InputProbe::start(QString *error)
+{
+    if (display) return true;
+
+    auto fail = [this, error](const QString &message) {
+        if (error) *error = message;
+        stop();
+        return false;
+    };
+
+    display = XOpenDisplay(nullptr);
+    if (!display) return fail("cannot open display");
+
+    // Raw events on the root window need XInput 2.1
+    int event = 0, errorBase = 0, major = 2, minor = 1;
+    if (!XQueryExtension(display, "XInputExtension", &opcode, &event, &errorBase) ||
+        XIQueryVersion(display, &major, &minor) != Success || major < 2 || (major == 2 && minor < 1)) {
+        return fail("XInput 2.1 not available");
+    }
+
+    unsigned char bits[XIMaskLen(XI_LASTEVENT)] = {};
+    XISetMask(bits, XI_RawButtonPress);
+    XIEventMask mask;
+    mask.deviceid = XIAllMasterDevices; // Once per press, not again for the slave device
+    mask.mask_len = sizeof(bits);
+    mask.mask = bits;
+    XISelectEvents(display, DefaultRootWindow(display), &mask, 1);
+    XSync(display, False);
+    return true;
+}
+
+void InputProbe::stop()
+{
+    if (!display) return;
+
+    XCloseDisplay(display);
+    display = nullptr;
+}
+
+int InputProbe::readPresses(bool stopAtFirst)
+{
+    int presses = 0;
+    while (XPending(display)) {
+        XEvent event;
+        XNextEvent(display, &event);
+        if (event.xcookie.type == GenericEvent && event.xcookie.extension == opcode &&
+            event.xcookie.evtype == XI_RawButtonPress) {
+            ++presses;
+            if (stopAtFirst) break;
+        }
+    }
+    return presses;
+}
+
+qint64 InputProbe::waitPress(int timeoutMs)
+{
+    if (!display) return -1;
+
+    const qint64 deadlineNs = nowNs() + qint64(timeoutMs) * 1000000;
+    for (;;) {
+        if (readPresses(true)) return nowNs();
+
+        const qint64 leftNs = deadlineNs - nowNs();
+        if (leftNs <= 0) return -1;
+
+        pollfd descriptor = {ConnectionNumber(display), POLLIN, 0};
+        poll(&descriptor, 1, int((leftNs + 999999) / 1000000));
+    }
+}
+
+quint64 InputProbe::drainPresses()
+{
+    return display ? quint64(readPresses(false)) : 0;
+}
+#else
+bool InputProbe::start(QString *error)
+{
+    if (error) *error = "the input probe needs X11";
+    return false;
+}
+
+void InputProbe::stop() {}
+int InputProbe::readPresses(bool) { return 0; }
+qint64 InputProbe::waitPress(int) { return -1; }
+quint64 InputProbe::drainPresses() { return 0; }
+#endif
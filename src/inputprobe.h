@@ -0,0 +1,35 @@
+#ifndef INPUTPROBE_H
+#define INPUTPROBE_H
+
+#include <QString>
+#include <QtGlobal>
+
+struct _XDisplay;
+
+// Watches button presses as the X server sees them, from any device, for
+// end-to-end injection latency. Uses XInput 2.1 raw events on the root
+// window on a connection of its own, so it needs no window or grab and
+// sees XTest and kernel devices alike.
+class InputProbe
+{
+public:
+    InputProbe();
+    ~InputProbe();
+
+    bool start(QString *error = nullptr); // On $DISPLAY
+    void stop();
+    bool isActive() const;
+
+    // Steady clock time at which the next press was read, or -1 if none
+    // arrives within the timeout
+    qint64 waitPress(int timeoutMs);
+    quint64 drainPresses(); // Presses already queued, without waiting
+
+private:
+    int readPresses(bool stopAtFirst);
+
+    _XDisplay *display;
+    int opcode;
+};
+
+#endif // INPUTPROBE_H
@@ -0,0 +1,212 @@
+#include "intervalgenerator.h"
+#include <QStringList>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+static inline quint64 rotl(quint64 x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+// Expands one seed into well-mixed state words
+static quint64 splitmix64(quint64 *x)
+{
+    quint64 z = (*x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+IntervalGenerator::IntervalGenerator()
+    : rate(10.0)
+    , elapsedSeconds(0.0)
+    , position(BlockSize)
+{
+    reset(IntervalProfile(), rate, 1);
+}
+
+void IntervalGenerator::reset(const IntervalProfile &newProfile, double clicksPerSecond, quint64 seed)
+{
+    profile = newProfile;
+    rate = qMax(1e-3, clicksPerSecond);
+    elapsedSeconds = 0.0;
+    position = BlockSize;
+
+    if (!seed) seed = quint64(std::chrono::steady_clock::now().time_since_epoch().count());
+    for (int word = 0; word < 4; ++word) {
+        for (int lane = 0; lane < Lanes; ++lane) {
+            state[word][lane] = splitmix64(&seed);
+        }
+    }
+}
+
+double IntervalGenerator::rateAt(double seconds) const
+{
+    double scale = 1.0;
+    if (profile.warmupSeconds > 0.0 && seconds < profile.warmupSeconds) {
+        const double start = qBound(0.01, profile.warmupStartFraction, 1.0);
+        scale = start + (1.0 - start) * seconds / profile.warmupSeconds;
+    }
+    if (profile.waveAmplitude > 0.0 && profile.wavePeriodSeconds > 0.0) {
+        scale *= 1.0 + qMin(profile.waveAmplitude, 0.95) * std::sin(2.0 * M_PI * seconds / profile.wavePeriodSeconds);
+    }
+    return rate * scale;
+}
+
+void IntervalGenerator::refill()
+{
+    alignas(32) double uniforms[BlockSize];
+
+    // Four xoshiro256+ streams stepped in lockstep: the lane loop has no
+    // dependencies between iterations and compiles to vector instructions
+    for (int i = 0; i < BlockSize && profile.distribution != IntervalProfile::Fixed; i += Lanes) {
+        for (int lane = 0; lane < Lanes; ++lane) {
+            quint64 &s0 = state[0][lane];
+            quint64 &s1 = state[1][lane];
+            quint64 &s2 = state[2][lane];
+            quint64 &s3 = state[3][lane];
+
+            const quint64 result = s0 + s3;
+            const quint64 t = s1 << 17;
+            s2 ^= s0;
+            s3 ^= s1;
+            s1 ^= s2;
+            s0 ^= s3;
+            s2 ^= t;
+            s3 = rotl(s3, 45);
+
+            // Top 53 bits into (0, 1]; never 0, so log() below is finite
+            uniforms[i + lane] = double((result >> 11) + 1) * (1.0 / 9007199254740992.0);
+        }
+    }
+
+    const double jitter = qMax(0.0, profile.jitter);
+    const double sigma = std::sqrt(std::log(1.0 + jitter * jitter)); // LogNormal shape for that jitter
+
+    for (int i = 0; i < BlockSize; i += 2) {
+        // Box-Muller: one pair of uniforms gives two independent normals
+        double z0 = 0.0, z1 = 0.0;
+        if (profile.distribution == IntervalProfile::Gaussian || profile.distribution == IntervalProfile::LogNormal) {
+            const double radius = std::sqrt(-2.0 * std::log(uniforms[i]));
+            const double angle = 2.0 * M_PI * uniforms[i + 1];
+            z0 = radius * std::cos(angle);
+            z1 = radius * std::sin(angle);
+        }
+
+        for (int k = 0; k < 2; ++k) {
+            const double mean = 1.0 / rateAt(elapsedSeconds);
+            double interval;
+            switch (profile.distribution) {
+                case IntervalProfile::Gaussian:
+                    // Truncated far in the tail so a click never lands on the previous one
+                    interval = qMax(mean * 0.05, mean * (1.0 + jitter * (k ? z1 : z0)));
+                    break;
+                case IntervalProfile::Poisson:
+                    interval = -mean * std::log(uniforms[i + k]);
+                    break;
+                case IntervalProfile::LogNormal:
+                    interval = mean * std::exp(sigma * (k ? z1 : z0) - 0.5 * sigma * sigma);
+                    break;
+                default:
+                    interval = mean;
+                    break;
+            }
+            elapsedSeconds += interval;
+            block[i + k] = qint64(interval * 1e9);
+        }
+    }
+    position = 0;
+}
+
+double IntervalGenerator::cdf(double intervalNs) const
+{
+    const double mean = 1e9 / rate;
+    const double jitter = qMax(1e-9, profile.jitter);
+    switch (profile.distribution) {
+        case IntervalProfile::Gaussian: {
+            // refill() clamps the lower tail, so its mass sits on the clamped interval
+            const double floorNs = double(qint64(1.0 / rate * 0.05 * 1e9)); // As refill() computes it
+            if (intervalNs < floorNs) return 0.0;
+            return 0.5 * std::erfc(-(qMax(intervalNs, mean * 0.05) - mean) / (jitter * mean * M_SQRT2));
+        }
+        case IntervalProfile::Poisson:
+            return intervalNs <= 0.0 ? 0.0 : 1.0 - std::exp(-intervalNs / mean);
+        case IntervalProfile::LogNormal: {
+            if (intervalNs <= 0.0) return 0.0;
+            const double sigma = std::sqrt(std::log(1.0 + jitter * jitter));
+            const double mu = std::log(mean) - 0.5 * sigma * sigma;
+            return 0.5 * std::erfc(-(std::log(intervalNs) - mu) / (sigma * M_SQRT2));
+        }
+        default:
+            return intervalNs < mean ? 0.0 : 1.0;
+    }
+}
+
+double IntervalGenerator::ksDistance(std::vector<double> &intervalsNs) const
+{
+    std::sort(intervalsNs.begin(), intervalsNs.end());
+    const double n = double(intervalsNs.size());
+    double distance = 0.0;
+    for (size_t i = 0; i < intervalsNs.size(); ++i) {
+        // Samples are whole nanoseconds, so half of one below is the left limit
+        // of the distribution there; it differs only at the clamped Gaussian tail
+        const double below = cdf(intervalsNs[i] - 0.5);
+        const double expected = cdf(intervalsNs[i]);
+        distance = qMax(distance, qMax(below - double(i) / n, double(i + 1) / n - expected));
+    }
+    return distance;
+}
+
+bool IntervalGenerator::parse(const QString &text, IntervalProfile *result)
+{
+    const QStringList parts = text.split(',');
+    const QString name = parts.value(0).trimmed().toLower();
+
+    IntervalProfile parsed = *result;
+    if (name == "fixed") {
+        parsed.distribution = IntervalProfile::Fixed;
+    } else if (name == "gaussian") {
+        parsed.distribution = IntervalProfile::Gaussian;
+    } else if (name == "poisson") {
+        parsed.distribution = IntervalProfile::Poisson;
+    } else if (name == "lognormal") {
+        parsed.distribution = IntervalProfile::LogNormal;
+    } else {
+        return false;
+    }
+
+    bool ok = true;
+    if (parts.size() > 1) parsed.jitter = parts[1].toDouble(&ok);
+    if (!ok || parts.size() > 2 || parsed.jitter < 0.0) return false;
+
+    *result = parsed;
+    return true;
+}
+
+bool IntervalGenerator::parseWave(const QString &text, IntervalProfile *result)
+{
+    const QStringList parts = text.split(',');
+    bool okAmplitude = false, okPeriod = true;
+    const double amplitude = parts.value(0).toDouble(&okAmplitude);
+    const double period = parts.size() > 1 ? parts[1].toDouble(&okPeriod) : result->wavePeriodSeconds;
+    if (!okAmplitude || !okPeriod || parts.size() > 2 || amplitude < 0.0 || amplitude >= 1.0 || period <= 0.0) return false;
+
+    result->waveAmplitude = amplitude;
+    result->wavePeriodSeconds = period;
+    return true;
+}
+
+QString IntervalGenerator::distributionName(IntervalProfile::Distribution distribution)
+{
+    switch (distribution) {
+        case IntervalProfile::Gaussian:
+            return "gaussian";
+        case IntervalProfile::Poisson:
+            return "poisson";
+        case IntervalProfile::LogNormal:
+            return "lognormal";
+        default:
+            return "fixed";
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef INTERVALGENERATOR_H
+#define INTERVALGENERATOR_H
+
+#include "types.h"
+#include <vector>
+
+// Precomputes click intervals in blocks. A vectorizable xoshiro256+ (four
+// interleaved streams) fills a block of uniforms, which are then shaped into
+// intervals in one pass; next() is an array read, so the clicking loop pays
+// no RNG cost per click. Ramps follow the generated timeline, not the wall
+// clock, so they are exact whatever the scheduler's lateness.
+class IntervalGenerator
+{
+public:
+    enum { BlockSize = 512, Lanes = 4 };
+
+    IntervalGenerator();
+
+    void reset(const IntervalProfile &profile, double clicksPerSecond, quint64 seed = 0); // 0 seeds from the clock
+
+    qint64 next() // Nanoseconds until the following click
+    {
+        if (position == BlockSize) refill();
+        return block[position++];
+    }
+
+    // Cumulative distribution of the intervals at a steady rate, for checking
+    // generated samples against the target (ramps not included)
+    double cdf(double intervalNs) const;
+    double ksDistance(std::vector<double> &intervalsNs) const; // Kolmogorov-Smirnov; sorts the samples
+
+    // "distribution[,jitter]" with distribution fixed, gaussian, poisson or lognormal
+    static bool parse(const QString &text, IntervalProfile *profile);
+    static bool parseWave(const QString &text, IntervalProfile *profile); // "amplitude,period-seconds"
+    static QString distributionName(IntervalProfile::Distribution distribution);
+
+private:
+    void refill();
+    double rateAt(double seconds) const;
+
+    IntervalProfile profile;
+    double rate;
+    double elapsedSeconds; // End of the generated timeline
+
+    alignas(32) quint64 state[4][Lanes]; // xoshiro256+ words, one column per stream
+    qint64 block[BlockSize];
+    int position;
+};
+
+#endif // INTERVALGENERATOR_H
@@ -1,9 +1,12 @@
 #include <QApplication>
 #include <QStyleFactory>
 #include <QDir>
+#include <QElapsedTimer>
+#include <QTimer>
 #include <csignal>
 #include <QDebug>
 #include "mainwindow.h"
+#include "processstats.h"
 
 #if defined(QT_STATIC) && defined(QT_FEATURE_static)
 #include <QtPlugin>
@@ -24,6 +27,9 @@ void signalHandler(int signal)
 
 int main(int argc, char *argv[])
 {
+    QElapsedTimer startupTimer;
+    startupTimer.start();
+    
     QApplication app(argc, argv);
     
     // Set application properties
@@ -63,6 +69,13 @@ int main(int argc, char *argv[])
     g_mainWindow = &window;
     window.show();
     
+    // Same report as gert-clickd --report-startup, for comparing the builds
+    if (qEnvironmentVariableIsSet("GERT_REPORT_STARTUP")) {
+        QTimer::singleShot(0, &app, [&startupTimer]() {
+            ProcessStats::reportStartup("GertAutoClicker", startupTimer);
+        });
+    }
+    
     int result = app.exec();
     
     // Clean up global reference
@@ -1,4 +1,6 @@
 #include "mainwindow.h"
+#include "clickerthread.h"
+#include "screenwatcher.h"
 #include <QApplication>
 #include <QCloseEvent>
 #include <QMessageBox>
@@ -17,11 +19,13 @@ MainWindow::MainWindow(QWidget *parent)
     , testClickCount(0)
 {
     setWindowTitle("Gert Auto Clicker");
-    setFixedSize(500, 400);  // Increased height for new controls
+    setFixedSize(500, 440);  // Increased height for new controls
     setWindowIcon(style()->standardIcon(QStyle::SP_ComputerIcon));
     
     autoClicker = new AutoClicker(this);
     hotkeyManager = new HotkeyManager(this);
+    hotkeyDispatcher = new HotkeyDispatcher(hotkeyManager, autoClicker, this);
+    controlServer = new ControlServer(autoClicker, this);
     
     setupUI();
     setupTrayIcon();
@@ -44,7 +48,50 @@ MainWindow::MainWindow(QWidget *parent)
     
 
     
-    connect(hotkeyManager, &HotkeyManager::hotkeyPressed, this, &MainWindow::toggleClicking);
+    // The engine can also be started and stopped from the control socket
+    connect(autoClicker, &AutoClicker::runningChanged, this, &MainWindow::onRunningChanged);
+    
+    // Kernel uinput pointer instead of XTest, opt-in via environment
+    if (qEnvironmentVariableIsSet("GERT_BACKEND")) {
+        InjectionBackend backend;
+        QString error;
+        if (!ClickerThread::parseBackend(qEnvironmentVariable("GERT_BACKEND"), &backend)) {
+            qWarning() << "Unknown injection backend" << qEnvironmentVariable("GERT_BACKEND");
+        } else if (!ClickerThread::setBackend(backend, &error)) {
+            qWarning().noquote() << "Falling back to XTest:" << error;
+        }
+    }
+    
+    // Many stored profiles, switched in place from the control socket or hotkeys
+    if (qEnvironmentVariableIsSet("GERT_PROFILES")) {
+        if (profileStore.open(qEnvironmentVariable("GERT_PROFILES"))) {
+            controlServer->setProfileStore(&profileStore);
+            hotkeyDispatcher->setProfileStore(&profileStore);
+        } else {
+            qWarning() << "Cannot open profile store" << qEnvironmentVariable("GERT_PROFILES");
+        }
+    }
+    
+    // Local control socket for external orchestration, opt-in via environment
+    if (qEnvironmentVariableIsSet("GERT_CONTROL_SOCKET")) {
+        const QString path = qEnvironmentVariable("GERT_CONTROL_SOCKET");
+        controlServer->listen(path.isEmpty() ? ControlServer::defaultSocketPath() : path);
+    }
+    
+    // Shared-memory target feed for producers that push click points at high rate
+    if (qEnvironmentVariableIsSet("GERT_TARGET_FEED")) {
+        autoClicker->setTargetFeed(true, qEnvironmentVariable("GERT_TARGET_FEED"));
+    }
+    
+    // Pixel trigger in the --trigger syntax; clicks follow the screen instead of the schedule
+    if (qEnvironmentVariableIsSet("GERT_TRIGGER")) {
+        ScreenTrigger trigger;
+        if (ScreenWatcher::parseTrigger(qEnvironmentVariable("GERT_TRIGGER"), &trigger)) {
+            autoClicker->setScreenTrigger(true, trigger); // Warns if the template cannot be loaded
+        } else {
+            qWarning() << "Invalid trigger" << qEnvironmentVariable("GERT_TRIGGER");
+        }
+    }
     
     // Status update timer disabled for maximum performance
 }
@@ -56,6 +103,8 @@ MainWindow::~MainWindow()
         autoClicker->stop();
     }
     hotkeyManager->unregisterHotkey();
+    controlServer->close();
+    autoClicker->useProfile(nullptr); // Before the store is unmapped
 }
 
 void MainWindow::setupUI()
@@ -99,10 +148,20 @@ void MainWindow::setupUI()
     // Click type
     clickTypeLabel = new QLabel("Click Type:");
     clickTypeCombo = new QComboBox;
-    clickTypeCombo->addItems({"Left Click", "Right Click", "Middle Click", "Double Click"});
+    clickTypeCombo->addItems({"Left Click", "Right Click", "Middle Click", "Double Click", "Triple Click",
+                              "Scroll Up", "Scroll Down", "Scroll Left", "Scroll Right"});
     connect(clickTypeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
             this, &MainWindow::updateClickType);
     
+    // Wheel notches per scroll, sent as one batch
+    scrollNotchesLabel = new QLabel("Scroll Notches:");
+    scrollNotchesSpinBox = new QSpinBox;
+    scrollNotchesSpinBox->setRange(1, 1000);
+    scrollNotchesSpinBox->setValue(1);
+    scrollNotchesSpinBox->setEnabled(false);
+    connect(scrollNotchesSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, &MainWindow::updateScrollNotches);
+    
     // Mouse mode
     mouseModeLabel = new QLabel("Mouse Mode:");
     mouseModeCombo = new QComboBox;
@@ -116,6 +175,12 @@ void MainWindow::setupUI()
     currentHotkey = "F6";
     connect(hotkeyButton, &QPushButton::clicked, this, &MainWindow::updateHotkey);
     
+    // Target window (WM_CLASS or title); clicks pause while it is unmapped
+    targetWindowLabel = new QLabel("Target Window:");
+    targetWindowEdit = new QLineEdit;
+    targetWindowEdit->setPlaceholderText("Any window");
+    connect(targetWindowEdit, &QLineEdit::editingFinished, this, &MainWindow::updateTargetWindow);
+    
     // Add to layout
     clickSettingsLayout->addWidget(clickModeLabel, 0, 0);
     clickSettingsLayout->addWidget(clickModeCombo, 0, 1);
@@ -125,10 +190,14 @@ void MainWindow::setupUI()
     clickSettingsLayout->addWidget(intervalDelaySpinBox, 2, 1);
     clickSettingsLayout->addWidget(clickTypeLabel, 3, 0);
     clickSettingsLayout->addWidget(clickTypeCombo, 3, 1);
-    clickSettingsLayout->addWidget(mouseModeLabel, 4, 0);
-    clickSettingsLayout->addWidget(mouseModeCombo, 4, 1);
-    clickSettingsLayout->addWidget(hotkeyLabel, 5, 0);
-    clickSettingsLayout->addWidget(hotkeyButton, 5, 1);
+    clickSettingsLayout->addWidget(scrollNotchesLabel, 4, 0);
+    clickSettingsLayout->addWidget(scrollNotchesSpinBox, 4, 1);
+    clickSettingsLayout->addWidget(mouseModeLabel, 5, 0);
+    clickSettingsLayout->addWidget(mouseModeCombo, 5, 1);
+    clickSettingsLayout->addWidget(hotkeyLabel, 6, 0);
+    clickSettingsLayout->addWidget(hotkeyButton, 6, 1);
+    clickSettingsLayout->addWidget(targetWindowLabel, 7, 0);
+    clickSettingsLayout->addWidget(targetWindowEdit, 7, 1);
     
     mainLayout->addWidget(clickSettingsGroup);
     
@@ -178,9 +247,6 @@ void MainWindow::setupUI()
     mainLayout->addWidget(statusLabel);
     mainLayout->addWidget(githubLink);
     mainLayout->addStretch();
-    
-    // Register initial hotkey
-    hotkeyManager->registerHotkey(currentHotkey);
 }
 
 void MainWindow::setupTrayIcon()
@@ -212,8 +278,16 @@ void MainWindow::setupTrayIcon()
 
 void MainWindow::toggleClicking()
 {
-    if (isClicking) {
+    if (autoClicker->isRunning()) {
         autoClicker->stop();
+    } else {
+        autoClicker->start();
+    }
+}
+
+void MainWindow::onRunningChanged(bool running)
+{
+    if (!running) {
         isClicking = false;
         startStopButton->setText("Start (F6)");
         startStopButton->setStyleSheet(
@@ -224,7 +298,6 @@ void MainWindow::toggleClicking()
         startStopAction->setText("Start");
         // No GUI updates for maximum performance
     } else {
-        autoClicker->start();
         isClicking = true;
         startStopButton->setText("Stop (F6)");
         startStopButton->setStyleSheet(
@@ -284,6 +357,12 @@ void MainWindow::updateClickType()
 {
     ClickType type = static_cast<ClickType>(clickTypeCombo->currentIndex());
     autoClicker->setClickType(type);
+    scrollNotchesSpinBox->setEnabled(isScroll(type));
+}
+
+void MainWindow::updateScrollNotches()
+{
+    autoClicker->setScrollNotches(scrollNotchesSpinBox->value());
 }
 
 void MainWindow::updateHotkey()
@@ -294,8 +373,34 @@ void MainWindow::updateHotkey()
     currentIndex = (currentIndex + 1) % hotkeys.size();
     currentHotkey = hotkeys[currentIndex];
     hotkeyButton->setText(currentHotkey);
-    hotkeyManager->unregisterHotkey();
-    hotkeyManager->registerHotkey(currentHotkey);
+    applyHotkeys();
+}
+
+// The hotkey button's key toggles; the other bindings come from settings
+void MainWindow::applyHotkeys()
+{
+    QVector<HotkeyBinding> table;
+    HotkeyBinding toggle;
+    toggle.keys = currentHotkey;
+    table.append(toggle);
+    
+    for (const QString &text : extraBindings) {
+        HotkeyBinding binding;
+        if (HotkeyManager::parseBinding(text.trimmed(), &binding)) {
+            table.append(binding);
+        } else {
+            qWarning() << "Ignoring invalid hotkey binding" << text;
+        }
+    }
+    
+    if (!hotkeyManager->setBindings(table)) {
+        statusLabel->setText("Status: Hotkeys not registered");
+    }
+}
+
+void MainWindow::updateTargetWindow()
+{
+    autoClicker->setTargetWindow(targetWindowEdit->text().trimmed());
 }
 
 void MainWindow::minimizeToTray()
@@ -331,9 +436,14 @@ void MainWindow::loadSettings()
     cpsSpinBox->setValue(settings.value("clicksPerSecond", 10).toInt()); // Load CPS with default of 10
     intervalDelaySpinBox->setValue(settings.value("intervalClickDelay", 1).toInt()); // Load as seconds
     clickTypeCombo->setCurrentIndex(settings.value("clickType", 0).toInt());
+    scrollNotchesSpinBox->setValue(settings.value("scrollNotches", 1).toInt());
     mouseModeCombo->setCurrentIndex(settings.value("mouseMode", 0).toInt());
     currentHotkey = settings.value("hotkey", "F6").toString();
+    extraBindings = settings.value("bindings").toStringList();
     hotkeyButton->setText(currentHotkey);
+    applyHotkeys(); // Registered once the saved keys are known
+    targetWindowEdit->setText(settings.value("targetWindow").toString());
+    updateTargetWindow();
     
     // Apply the click mode to show/hide appropriate controls
     updateClickMode();
@@ -346,8 +456,11 @@ void MainWindow::saveSettings()
     settings.setValue("clicksPerSecond", cpsSpinBox->value()); // Save CPS
     settings.setValue("intervalClickDelay", intervalDelaySpinBox->value()); // Save as seconds
     settings.setValue("clickType", clickTypeCombo->currentIndex());
+    settings.setValue("scrollNotches", scrollNotchesSpinBox->value());
     settings.setValue("mouseMode", mouseModeCombo->currentIndex());
     settings.setValue("hotkey", currentHotkey);
+    settings.setValue("bindings", extraBindings);
+    settings.setValue("targetWindow", targetWindowEdit->text().trimmed());
 }
 
 void MainWindow::closeEvent(QCloseEvent *event)
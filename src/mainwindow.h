@@ -9,6 +9,7 @@
 #include <QSpinBox>
 #include <QPushButton>
 #include <QCheckBox>
+#include <QLineEdit>
 #include <QComboBox>
 #include <QGroupBox>
 #include <QSlider>
@@ -19,6 +20,9 @@
 #include <QSettings>
 #include "autoclicker.h"
 #include "hotkeymanager.h"
+#include "hotkeydispatcher.h"
+#include "controlserver.h"
+#include "profilestore.h"
 #include "types.h"
 
 class MainWindow : public QMainWindow
@@ -31,12 +35,15 @@ public:
 
 private slots:
     void toggleClicking();
+    void onRunningChanged(bool running);
     void updateClickMode();
     void updateCPS();
     void updateMouseMode();
     void updateClickType();
+    void updateScrollNotches();
     void updateIntervalDelay();
     void updateHotkey();
+    void updateTargetWindow();
     void minimizeToTray();
     void restoreFromTray();
     void showTrayMenu();
@@ -48,6 +55,7 @@ private slots:
 private:
     void setupUI();
     void setupTrayIcon();
+    void applyHotkeys();
 
     // UI Components
     QWidget *centralWidget;
@@ -72,10 +80,14 @@ private:
     // General Settings
     QLabel *clickTypeLabel;
     QComboBox *clickTypeCombo;
+    QLabel *scrollNotchesLabel;
+    QSpinBox *scrollNotchesSpinBox;
     QLabel *mouseModeLabel;
     QComboBox *mouseModeCombo;
     QLabel *hotkeyLabel;
     QPushButton *hotkeyButton;
+    QLabel *targetWindowLabel;
+    QLineEdit *targetWindowEdit;
     
     // Control Buttons
     QHBoxLayout *controlLayout;
@@ -89,6 +101,9 @@ private:
     // Core Components
     AutoClicker *autoClicker;
     HotkeyManager *hotkeyManager;
+    HotkeyDispatcher *hotkeyDispatcher;
+    ControlServer *controlServer;
+    ProfileStore profileStore; // Opt-in via GERT_PROFILES
     
     // Tray
     QSystemTrayIcon *trayIcon;
@@ -102,6 +117,7 @@ private:
     int clickCount;
     int testClickCount; // Counter for test clicks
     QString currentHotkey;
+    QStringList extraBindings; // "bindings" setting: hold, burst, profile and pause keys
 };
 
 #endif // MAINWINDOW_H 
\ No newline at end of file
@@ -0,0 +1,272 @@
+#include "metricsserver.h"
+#include "auditlog.h"
+#include "clickmetrics.h"
+#include "clicktrace.h"
+#include <QDebug>
+#include <QList>
+#include <chrono>
+#include <cstring>
+
+#ifndef Q_OS_WIN
+#include <errno.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+#endif
+
+static qint64 nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+MetricsServer::MetricsServer(QObject *parent)
+    : QThread(parent)
+    , listenFd(-1)
+    , listenPort(0)
+    , running(false)
+    , samples(0)
+    , actualRate(0.0)
+{
+    wakeFds[0] = -1;
+    wakeFds[1] = -1;
+}
+
+MetricsServer::~MetricsServer()
+{
+    close();
+}
+
+quint16 MetricsServer::port() const
+{
+    return listenPort;
+}
+
+static void appendHeader(QByteArray *text, const char *name, const char *type, const char *help)
+{
+    *text += QByteArray("# HELP ") + name + " " + help + "\n";
+    *text += QByteArray("# TYPE ") + name + " " + type + "\n";
+}
+
+QByteArray MetricsServer::render() const
+{
+    const ClickMetrics::Snapshot snapshot = ClickMetrics::snapshot();
+    QByteArray text;
+    text.reserve(4096);
+
+    appendHeader(&text, "gert_clicks_total", "counter", "Clicks and key actions injected.");
+    text += "gert_clicks_total " + QByteArray::number(snapshot.clicks) + "\n";
+
+    appendHeader(&text, "gert_missed_deadlines_total", "counter",
+                 "Click slots skipped because an engine fell behind, and feed records past their deadline.");
+    text += "gert_missed_deadlines_total " + QByteArray::number(snapshot.missed) + "\n";
+
+    appendHeader(&text, "gert_dropped_events_total", "counter", "Events lost because a ring was full.");
+    text += "gert_dropped_events_total{ring=\"trace\"} " + QByteArray::number(ClickTrace::droppedEvents()) + "\n";
+    text += "gert_dropped_events_total{ring=\"audit\"} " + QByteArray::number(AuditLog::droppedCount()) + "\n";
+    text += "gert_dropped_events_total{ring=\"feed\"} " + QByteArray::number(snapshot.queueDropped) + "\n";
+
+    appendHeader(&text, "gert_target_clicks_per_second", "gauge", "Configured click rate; 0 while stopped or externally driven.");
+    text += "gert_target_clicks_per_second " + QByteArray::number(ClickMetrics::targetRate(), 'g', 10) + "\n";
+
+    appendHeader(&text, "gert_clicks_per_second", "gauge", "Achieved click rate over the last 5 seconds.");
+    text += "gert_clicks_per_second " + QByteArray::number(actualRate.load(std::memory_order_relaxed), 'f', 1) + "\n";
+
+    appendHeader(&text, "gert_queue_depth", "gauge", "Feed records waiting to be clicked.");
+    text += "gert_queue_depth " + QByteArray::number(snapshot.queueDepth) + "\n";
+
+    appendHeader(&text, "gert_interval_error_seconds", "histogram", "Distance of each click from its scheduled time.");
+    quint64 cumulative = 0;
+    for (int i = 0; i < ClickMetrics::BucketCount; ++i) {
+        cumulative += snapshot.buckets[i];
+        text += "gert_interval_error_seconds_bucket{le=\""
+            + QByteArray::number(ClickMetrics::bucketBoundsNs[i] / 1e9, 'g', 6) + "\"} "
+            + QByteArray::number(cumulative) + "\n";
+    }
+    text += "gert_interval_error_seconds_bucket{le=\"+Inf\"} " + QByteArray::number(snapshot.samples) + "\n";
+    text += "gert_interval_error_seconds_sum " + QByteArray::number(snapshot.errorTotalNs / 1e9, 'g', 12) + "\n";
+    text += "gert_interval_error_seconds_count " + QByteArray::number(snapshot.samples) + "\n";
+    return text;
+}
+
+// Published counts move in 100 ms steps, so the rate is taken over 5 s
+void MetricsServer::sampleRate()
+{
+    const qint64 now = nowNs();
+    if (samples && now - sampleNs[(samples - 1) % RateSamples] < 1000000000LL) return;
+
+    const int slot = samples % RateSamples;
+    sampleClicks[slot] = ClickMetrics::snapshot().clicks;
+    sampleNs[slot] = now;
+    ++samples;
+
+    const int oldest = samples < RateSamples ? 0 : samples % RateSamples;
+    const qint64 elapsed = now - sampleNs[oldest];
+    if (elapsed > 0) actualRate.store((sampleClicks[slot] - sampleClicks[oldest]) * 1e9 / elapsed, std::memory_order_relaxed);
+}
+
+QByteArray MetricsServer::handleRequest(const QByteArray &request) const
+{
+    const QList<QByteArray> requestLine = request.left(request.indexOf('\r')).split(' ');
+    const QByteArray method = requestLine.value(0);
+    const QByteArray target = requestLine.value(1);
+
+    QByteArray status = "200 OK";
+    QByteArray body;
+    if (method != "GET" && method != "HEAD") {
+        status = "405 Method Not Allowed";
+    } else if (target != "/metrics" && !target.startsWith("/metrics?")) {
+        status = "404 Not Found";
+    } else {
+        body = render();
+    }
+
+    QByteArray response = "HTTP/1.1 " + status + "\r\n"
+        "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+        "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+        "Connection: close\r\n\r\n";
+    if (method != "HEAD") response += body;
+    return response;
+}
+
+#ifndef Q_OS_WIN
+bool MetricsServer::listen(quint16 port)
+{
+    close();
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) return false;
+
+    const int reuse = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (bind(listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 ||
+        ::listen(listenFd, 8) < 0 ||
+        pipe(wakeFds) < 0) {
+        qWarning() << "MetricsServer: cannot listen on port" << port;
+        close();
+        return false;
+    }
+
+    listenPort = port;
+    samples = 0;
+    running.store(true);
+    start();
+    return true;
+}
+
+void MetricsServer::close()
+{
+    if (running.exchange(false)) {
+        const char wake = 0;
+        if (::write(wakeFds[1], &wake, 1) < 0) {
+            // Nothing else to do; poll() still times out below
+        }
+        wait();
+    }
+
+    for (int *fd : { &listenFd, &wakeFds[0], &wakeFds[1] }) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+    listenPort = 0;
+}
+
+void MetricsServer::run()
+{
+    std::vector<pollfd> fds;
+
+    while (running.load(std::memory_order_relaxed)) {
+        sampleRate();
+
+        // Clients that never finish a request are dropped
+        const qint64 now = nowNs();
+        for (auto it = pending.begin(); it != pending.end();) {
+            if (now - it.value().acceptedNs > ClientTimeoutNs) {
+                ::close(it.key());
+                it = pending.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        fds.clear();
+        fds.push_back({ listenFd, POLLIN, 0 });
+        fds.push_back({ wakeFds[0], POLLIN, 0 });
+        for (auto it = pending.cbegin(); it != pending.cend(); ++it) {
+            fds.push_back({ it.key(), POLLIN, 0 });
+        }
+
+        if (poll(fds.data(), fds.size(), 1000) <= 0) continue;
+        if (fds[1].revents) break;
+
+        if (fds[0].revents & POLLIN) {
+            const int client = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (client >= 0 && pending.size() >= MaxPendingClients) {
+                ::close(client);
+            } else if (client >= 0) {
+                pending.insert(client, PendingClient{ QByteArray(), nowNs() });
+            }
+        }
+
+        for (size_t i = 2; i < fds.size(); ++i) {
+            if (!fds[i].revents) continue;
+
+            const int client = fds[i].fd;
+            char buffer[1024];
+            const ssize_t count = ::read(client, buffer, sizeof(buffer));
+            if (count <= 0) {
+                ::close(client);
+                pending.remove(client);
+                continue;
+            }
+
+            QByteArray &input = pending[client].input;
+            input.append(buffer, static_cast<int>(count));
+
+            // One request per connection; headers are not needed beyond the request line
+            if (input.contains("\r\n\r\n") || input.contains("\n\n")) {
+                const QByteArray response = handleRequest(input);
+                qint64 written = 0;
+                while (written < response.size()) {
+                    const ssize_t sent = ::send(client, response.constData() + written, response.size() - written, MSG_NOSIGNAL);
+                    if (sent <= 0) break;
+                    written += sent;
+                }
+                ::close(client);
+                pending.remove(client);
+            } else if (input.size() > 8192) {
+                ::close(client);
+                pending.remove(client);
+            }
+        }
+    }
+
+    for (auto it = pending.cbegin(); it != pending.cend(); ++it) {
+        ::close(it.key());
+    }
+    pending.clear();
+}
+#else
+bool MetricsServer::listen(quint16)
+{
+    qWarning() << "MetricsServer: not supported on this platform";
+    return false;
+}
+
+void MetricsServer::close()
+{
+}
+
+void MetricsServer::run()
+{
+}
+#endif
@@ -0,0 +1,64 @@
+#ifndef METRICSSERVER_H
+#define METRICSSERVER_H
+
+#include <QThread>
+#include <QByteArray>
+#include <QHash>
+#include <atomic>
+
+// Prometheus metrics over HTTP on a loopback port, served from a dedicated
+// thread. Only GET /metrics is answered. Values come from ClickMetrics'
+// published slots and the trace and audit ring counters, so a scrape never
+// blocks or writes to a click thread.
+//
+//   gert_clicks_total                    counter
+//   gert_missed_deadlines_total          counter
+//   gert_dropped_events_total{ring}      counter: trace, audit, feed
+//   gert_target_clicks_per_second        gauge
+//   gert_clicks_per_second               gauge, over the last 5 s
+//   gert_queue_depth                     gauge: feed records waiting
+//   gert_interval_error_seconds          histogram
+class MetricsServer : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit MetricsServer(QObject *parent = nullptr);
+    ~MetricsServer();
+
+    bool listen(quint16 port); // Binds 127.0.0.1 only
+    void close();
+    quint16 port() const;
+
+    QByteArray render() const; // Exposition text format 0.0.4
+
+protected:
+    void run() override;
+
+private:
+    static const int RateSamples = 6; // One a second
+    static const int MaxPendingClients = 64;
+    static const qint64 ClientTimeoutNs = 5000000000LL; // To send a full request
+
+    struct PendingClient {
+        QByteArray input; // Partial request
+        qint64 acceptedNs = 0;
+    };
+
+    QByteArray handleRequest(const QByteArray &request) const;
+    void sampleRate();
+
+    int listenFd;
+    int wakeFds[2]; // Self-pipe used to interrupt poll() on close
+    quint16 listenPort;
+    std::atomic<bool> running;
+    QHash<int, PendingClient> pending;
+
+    // Click totals once a second, for the achieved rate
+    quint64 sampleClicks[RateSamples];
+    qint64 sampleNs[RateSamples];
+    int samples;
+    std::atomic<double> actualRate;
+};
+
+#endif // METRICSSERVER_H
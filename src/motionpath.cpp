@@ -0,0 +1,149 @@
+#include "motionpath.h"
+#include "clickerthread.h"
+#include <QStringList>
+#include <cmath>
+
+int MotionPath::pointCount(const MotionSettings &settings)
+{
+    const qint64 samples = qint64(qMax(0, settings.durationUs)) * qMax(1, settings.sampleRate) / 1000000;
+    return int(qBound(qint64(2), samples + 1, qint64(1000000)));
+}
+
+int MotionPath::generate(const MotionSettings &settings, const QPoint &from, const QPoint &to,
+                         QPoint *out, int capacity)
+{
+    const int count = qMin(pointCount(settings), capacity);
+    if (count < 2) return 0;
+
+    const double x0 = from.x(), y0 = from.y();
+    const double dx = to.x() - x0, dy = to.y() - y0;
+    const double step = 1.0 / (count - 1);
+
+    switch (settings.curve) {
+        case MotionCurve::Linear:
+            for (int i = 0; i < count; ++i) {
+                const double t = i * step;
+                out[i] = QPoint(qRound(x0 + dx * t), qRound(y0 + dy * t));
+            }
+            break;
+        case MotionCurve::MinimumJerk:
+            // s(t) = 10t^3 - 15t^4 + 6t^5: zero speed and acceleration at both ends
+            for (int i = 0; i < count; ++i) {
+                const double t = i * step;
+                const double s = t * t * t * (10.0 + t * (-15.0 + 6.0 * t));
+                out[i] = QPoint(qRound(x0 + dx * s), qRound(y0 + dy * s));
+            }
+            break;
+        case MotionCurve::Bezier: {
+            // Both control points pushed the same way along the normal, so the path arcs
+            const double nx = -dy * settings.curvature, ny = dx * settings.curvature;
+            const double x1 = x0 + dx / 3 + nx, y1 = y0 + dy / 3 + ny;
+            const double x2 = x0 + dx * 2 / 3 + nx, y2 = y0 + dy * 2 / 3 + ny;
+            const double x3 = to.x(), y3 = to.y();
+
+            // Power basis, evaluated with Horner's rule
+            const double ax = 3 * (x1 - x0), bx = 3 * (x0 - 2 * x1 + x2), cx = x3 - x0 + 3 * (x1 - x2);
+            const double ay = 3 * (y1 - y0), by = 3 * (y0 - 2 * y1 + y2), cy = y3 - y0 + 3 * (y1 - y2);
+            for (int i = 0; i < count; ++i) {
+                const double t = i * step;
+                out[i] = QPoint(qRound(x0 + t * (ax + t * (bx + t * cx))),
+                                qRound(y0 + t * (ay + t * (by + t * cy))));
+            }
+            break;
+        }
+    }
+
+    // Land exactly on the target whatever the rounding did
+    out[count - 1] = to;
+    return count;
+}
+
+bool MotionPath::parse(const QString &text, MotionSettings *settings)
+{
+    const QStringList parts = text.split(',');
+    const QString curve = parts.value(0).trimmed().toLower();
+
+    MotionSettings result;
+    if (curve == "linear") {
+        result.curve = MotionCurve::Linear;
+    } else if (curve == "bezier") {
+        result.curve = MotionCurve::Bezier;
+    } else if (curve == "minjerk") {
+        result.curve = MotionCurve::MinimumJerk;
+    } else {
+        return false;
+    }
+
+    bool okDuration = true, okRate = true;
+    result.durationUs = parts.size() > 1 ? parts[1].toInt(&okDuration) : 100000;
+    if (parts.size() > 2) result.sampleRate = parts[2].toInt(&okRate);
+    if (!okDuration || !okRate || parts.size() > 3 || result.durationUs < 0 || result.sampleRate <= 0) {
+        return false;
+    }
+
+    *settings = result;
+    return true;
+}
+
+QString MotionPath::curveName(MotionCurve curve)
+{
+    switch (curve) {
+        case MotionCurve::Bezier:
+            return "bezier";
+        case MotionCurve::MinimumJerk:
+            return "minjerk";
+        default:
+            return "linear";
+    }
+}
+
+MotionStream::MotionStream()
+    : count(0)
+    , sent(0)
+    , startNs(0)
+    , periodNs(1)
+{
+}
+
+void MotionStream::reserve(const MotionSettings &settings)
+{
+    const int needed = MotionPath::pointCount(settings);
+    if (points.size() < needed) points.resize(needed);
+}
+
+void MotionStream::begin(const MotionSettings &settings, const QPoint &from, const QPoint &to, qint64 start)
+{
+    reserve(settings);
+    count = MotionPath::generate(settings, from, to, points.data(), int(points.size()));
+    sent = 0;
+    startNs = start;
+    periodNs = settings.isEnabled() ? 1000000000LL / qMax(1, settings.sampleRate) : 0;
+}
+
+bool MotionStream::isActive() const
+{
+    return sent < count;
+}
+
+QPoint MotionStream::target() const
+{
+    return count ? points[count - 1] : QPoint();
+}
+
+qint64 MotionStream::step(ClickerThread *injector, qint64 nowNs)
+{
+    if (!isActive()) return -1;
+
+    // Every point due by now in one batch, at least one per call
+    int due = periodNs ? int(qMin(qint64(count), (nowNs - startNs) / periodNs + 1)) : count;
+    due = qMax(due, sent + 1);
+    injector->movePointer(points.constData() + sent, due - sent);
+    sent = due;
+
+    return isActive() ? startNs + qint64(sent) * periodNs : -1;
+}
+
+void MotionStream::cancel()
+{
+    sent = count;
+}
@@ -0,0 +1,54 @@
+#ifndef MOTIONPATH_H
+#define MOTIONPATH_H
+
+#include <QPoint>
+#include <QString>
+#include <QVector>
+#include "types.h"
+
+class ClickerThread;
+
+// Pointer paths between two targets, sampled at a fixed rate into a buffer
+// the caller allocated up front. Generation is a single pass without
+// allocation, a few nanoseconds per point.
+class MotionPath
+{
+public:
+    // Points a path with these settings has, including both ends
+    static int pointCount(const MotionSettings &settings);
+
+    // Writes up to capacity points from 'from' to 'to'; returns the number written
+    static int generate(const MotionSettings &settings, const QPoint &from, const QPoint &to,
+                        QPoint *out, int capacity);
+
+    // "curve[,duration-us[,sample-hz]]", curve being linear, bezier or minjerk
+    static bool parse(const QString &text, MotionSettings *settings);
+    static QString curveName(MotionCurve curve);
+};
+
+// Plays one path through an injection session at its sample rate. The
+// scheduler calls step() when the next point is due; every point due by
+// then goes out in one batch.
+class MotionStream
+{
+public:
+    MotionStream();
+
+    void reserve(const MotionSettings &settings); // So begin() does not allocate
+    void begin(const MotionSettings &settings, const QPoint &from, const QPoint &to, qint64 startNs);
+    bool isActive() const;
+    QPoint target() const;
+
+    // Sends the points due at nowNs; returns when the next one is due, or -1 once the target was sent
+    qint64 step(ClickerThread *injector, qint64 nowNs);
+    void cancel();
+
+private:
+    QVector<QPoint> points;
+    int count;
+    int sent;
+    qint64 startNs;
+    qint64 periodNs;
+};
+
+#endif // MOTIONPATH_H
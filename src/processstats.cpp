@@ -0,0 +1,97 @@
+#include "processstats.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QList>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#if !defined(Q_OS_WIN) && !defined(Q_OS_MAC)
+#include <unistd.h>
+
+static qint64 statusFieldKb(const char *field)
+{
+    QFile status("/proc/self/status");
+    if (!status.open(QIODevice::ReadOnly)) return -1;
+
+    const QByteArray prefix(field);
+    for (const QByteArray &line : status.readAll().split('\n')) {
+        if (line.startsWith(prefix)) {
+            // "VmRSS:	   12345 kB"
+            return line.mid(prefix.size()).simplified().split(' ').value(0).toLongLong();
+        }
+    }
+    return -1;
+}
+
+qint64 ProcessStats::residentKb()
+{
+    return statusFieldKb("VmRSS:");
+}
+
+qint64 ProcessStats::peakResidentKb()
+{
+    return statusFieldKb("VmHWM:");
+}
+
+double ProcessStats::msSinceExec()
+{
+    QFile stat("/proc/self/stat");
+    QFile uptime("/proc/uptime");
+    if (!stat.open(QIODevice::ReadOnly) || !uptime.open(QIODevice::ReadOnly)) return -1;
+
+    // Field 22 is the start time in clock ticks since boot; the command name
+    // in field 2 may contain spaces, so count from the closing parenthesis
+    const QByteArray line = stat.readAll();
+    const QList<QByteArray> fields = line.mid(line.lastIndexOf(')') + 2).split(' ');
+    const double startTicks = fields.value(19).toDouble();
+    const double bootSeconds = uptime.readAll().split(' ').value(0).toDouble();
+    return (bootSeconds - startTicks / sysconf(_SC_CLK_TCK)) * 1000.0;
+}
+#else
+qint64 ProcessStats::residentKb()
+{
+    return -1;
+}
+
+qint64 ProcessStats::peakResidentKb()
+{
+    return -1;
+}
+
+double ProcessStats::msSinceExec()
+{
+    return -1;
+}
+#endif
+
+double ProcessStats::cpuSeconds()
+{
+#ifdef Q_OS_WIN
+    FILETIME created, exited, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) return 0.0;
+    const auto toSeconds = [](const FILETIME &time) {
+        return ((quint64(time.dwHighDateTime) << 32) | time.dwLowDateTime) / 1e7;
+    };
+    return toSeconds(kernel) + toSeconds(user);
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0.0;
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+           usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+#endif
+}
+
+void ProcessStats::reportStartup(const char *name, const QElapsedTimer &sinceMain)
+{
+    qInfo().noquote() << QString("%1: ready %2 ms after main(), %3 ms after exec; RSS %4 kB (peak %5 kB)")
+                             .arg(name)
+                             .arg(sinceMain.nsecsElapsed() / 1e6, 0, 'f', 1)
+                             .arg(msSinceExec(), 0, 'f', 0)
+                             .arg(residentKb())
+                             .arg(peakResidentKb());
+}
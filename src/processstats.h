@@ -0,0 +1,21 @@
+#ifndef PROCESSSTATS_H
+#define PROCESSSTATS_H
+
+#include <QtGlobal>
+
+class QElapsedTimer;
+
+// Startup time and memory figures for comparing the GUI and daemon builds
+class ProcessStats
+{
+public:
+    static qint64 residentKb();     // Current resident set size, -1 if unknown
+    static qint64 peakResidentKb(); // High-water mark, -1 if unknown
+    static double msSinceExec();    // Since the kernel started the process, -1 if unknown
+    static double cpuSeconds();     // User plus system time of all threads
+
+    // Logs one line: time since main() (timer started there), since exec, and RSS
+    static void reportStartup(const char *name, const QElapsedTimer &sinceMain);
+};
+
+#endif // PROCESSSTATS_H
@@ -0,0 +1,297 @@
+#include "profilestore.h"
+#include "intervalgenerator.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSet>
+#include <QSettings>
+#include <QStringList>
+#include <cstring>
+
+static quint64 nameHash(const QByteArray &name)
+{
+    // FNV-1a
+    quint64 hash = 14695981039346656037ULL;
+    for (char c : name) {
+        hash ^= quint8(c);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static quint64 recordsOffset(quint32 bucketCount)
+{
+    return (sizeof(ProfileStoreHeader) + quint64(bucketCount) * sizeof(quint32) + 7) & ~quint64(7);
+}
+
+QString StoredProfile::name() const
+{
+    return QString::fromUtf8(reinterpret_cast<const char *>(this) + nameOffset, int(nameLength));
+}
+
+ClickTiming StoredProfile::timing() const
+{
+    ClickTiming result;
+    result.pressUs = pressUs;
+    result.gapUs = gapUs;
+    return result;
+}
+
+IntervalProfile StoredProfile::intervals() const
+{
+    IntervalProfile result;
+    result.distribution = static_cast<IntervalProfile::Distribution>(distribution);
+    result.jitter = jitter;
+    result.warmupSeconds = warmupSeconds;
+    result.waveAmplitude = waveAmplitude;
+    result.wavePeriodSeconds = wavePeriodSeconds;
+    return result;
+}
+
+ProfileStore::ProfileStore()
+    : data(nullptr)
+    , size(0)
+    , header(nullptr)
+    , buckets(nullptr)
+    , records(nullptr)
+{
+}
+
+ProfileStore::~ProfileStore()
+{
+    close();
+}
+
+bool ProfileStore::open(const QString &path)
+{
+    close();
+    file.reset(new QFile(path));
+    if (!file->open(QIODevice::ReadOnly) || file->size() < qint64(sizeof(ProfileStoreHeader))) {
+        close();
+        return false;
+    }
+
+    data = file->map(0, file->size());
+    size = quint64(file->size());
+    header = reinterpret_cast<const ProfileStoreHeader *>(data);
+    if (!data || std::memcmp(header->magic, "GPS1", 4) != 0 || header->recordSize != sizeof(StoredProfile) ||
+        header->fileSize != size) {
+        close();
+        return false;
+    }
+
+    // The header and table sizes only; records are checked as they are looked up
+    const quint32 bucketCount = header->bucketCount;
+    if (!bucketCount || (bucketCount & (bucketCount - 1)) || bucketCount < header->count ||
+        recordsOffset(bucketCount) + quint64(header->count) * sizeof(StoredProfile) > size) {
+        close();
+        return false;
+    }
+
+    buckets = reinterpret_cast<const quint32 *>(data + sizeof(ProfileStoreHeader));
+    records = reinterpret_cast<const StoredProfile *>(data + recordsOffset(bucketCount));
+    return true;
+}
+
+void ProfileStore::close()
+{
+    if (file) {
+        if (data) file->unmap(const_cast<uchar *>(data));
+        file.reset();
+    }
+    data = nullptr;
+    size = 0;
+    header = nullptr;
+    buckets = nullptr;
+    records = nullptr;
+}
+
+bool ProfileStore::isOpen() const
+{
+    return header != nullptr;
+}
+
+QString ProfileStore::path() const
+{
+    return file ? file->fileName() : QString();
+}
+
+quint32 ProfileStore::count() const
+{
+    return header ? header->count : 0;
+}
+
+const StoredProfile *ProfileStore::at(quint32 index) const
+{
+    return header && index < header->count ? checked(index) : nullptr;
+}
+
+const StoredProfile *ProfileStore::checked(quint32 index) const
+{
+    const StoredProfile *record = records + index;
+    const qint64 base = reinterpret_cast<const uchar *>(record) - data;
+    const qint64 nameStart = base + record->nameOffset;
+    const qint64 positionsStart = base + record->positionsOffset;
+    if (nameStart < 0 || nameStart + qint64(record->nameLength) > qint64(size)) return nullptr;
+    if (positionsStart < 0 || positionsStart % 4 ||
+        positionsStart + qint64(record->positionCount) * 8 > qint64(size)) return nullptr;
+
+    // The engine divides by the rate and casts the enum bytes as they are
+    if (record->clicksPerSecond < 1 || record->clicksPerSecond > 10000) return nullptr;
+    if (record->clickType > quint8(ClickType::ScrollRight) || record->mouseMode > quint8(MouseMode::Locked) ||
+        record->distribution > quint8(IntervalProfile::LogNormal)) return nullptr;
+    if (record->pressUs < 0 || record->gapUs < 0) return nullptr;
+    return record;
+}
+
+const StoredProfile *ProfileStore::find(const QString &name) const
+{
+    if (!header) return nullptr;
+
+    const QByteArray utf8 = name.toUtf8();
+    const quint64 hash = nameHash(utf8);
+    const quint32 mask = header->bucketCount - 1;
+
+    // Linear probing over a table at most half full
+    for (quint32 i = quint32(hash) & mask, probes = 0; probes <= mask; i = (i + 1) & mask, ++probes) {
+        const quint32 entry = buckets[i];
+        if (!entry || entry > header->count) return nullptr;
+
+        const StoredProfile *record = checked(entry - 1);
+        if (record && record->nameHash == hash && record->nameLength == quint32(utf8.size()) &&
+            std::memcmp(reinterpret_cast<const char *>(record) + record->nameOffset, utf8.constData(), utf8.size()) == 0) {
+            return record;
+        }
+    }
+    return nullptr;
+}
+
+bool ProfileStore::readIni(const QString &path, ProfileData *profile)
+{
+    QSettings settings(path, QSettings::IniFormat);
+    if (settings.status() != QSettings::NoError || settings.allKeys().isEmpty()) return false;
+
+    ProfileData result;
+    result.name = QFileInfo(path).completeBaseName();
+    result.clicksPerSecond = qBound(1, settings.value("clicksPerSecond", 10).toInt(), 10000);
+    result.clickType = static_cast<ClickType>(qBound(0, settings.value("clickType", 0).toInt(), int(ClickType::ScrollRight)));
+    result.mouseMode = static_cast<MouseMode>(qBound(0, settings.value("mouseMode", 0).toInt(), 1));
+    if (settings.value("clickMode").toInt() == 1) {
+        // Interval delay is stored in seconds, as in the GUI settings
+        result.intervalDelayMs = qMax(1, settings.value("intervalClickDelay", 1).toInt() * 1000);
+    }
+    result.timing.pressUs = settings.value("pressUs", 0).toInt();
+    result.timing.gapUs = settings.value("gapUs", 0).toInt();
+
+    // QSettings splits values on commas, so lists are joined back first
+    result.intervals.warmupSeconds = settings.value("warmup", 0.0).toDouble();
+    if ((settings.contains("intervals") && !IntervalGenerator::parse(settings.value("intervals").toStringList().join(','), &result.intervals)) ||
+        (settings.contains("wave") && !IntervalGenerator::parseWave(settings.value("wave").toStringList().join(','), &result.intervals))) {
+        return false;
+    }
+
+    if (settings.contains("positions")) {
+        const QString text = settings.value("positions").toStringList().join(',');
+        for (const QString &point : text.split(' ', Qt::SkipEmptyParts)) {
+            const QStringList xy = point.split(',');
+            bool okX = false, okY = false;
+            if (xy.size() != 2) return false;
+            result.positions.append(QPoint(xy[0].toInt(&okX), xy[1].toInt(&okY)));
+            if (!okX || !okY) return false;
+        }
+    } else if (settings.contains("positionX") && settings.contains("positionY")) {
+        result.positions.append(QPoint(settings.value("positionX").toInt(), settings.value("positionY").toInt()));
+    }
+
+    *profile = result;
+    return true;
+}
+
+bool ProfileStore::write(const QString &path, const QVector<ProfileData> &profiles, QString *error)
+{
+    auto fail = [error](const QString &message) {
+        if (error) *error = message;
+        return false;
+    };
+
+    quint32 bucketCount = 4;
+    while (bucketCount < 2 * quint32(profiles.size())) bucketCount *= 2;
+
+    // Names, then position sequences, after the records
+    const quint64 poolStart = recordsOffset(bucketCount) + quint64(profiles.size()) * sizeof(StoredProfile);
+    QVector<QByteArray> names;
+    quint64 namesSize = 0;
+    quint64 positionsSize = 0;
+    QSet<QByteArray> seen;
+    for (const ProfileData &profile : profiles) {
+        const QByteArray name = profile.name.toUtf8();
+        if (name.isEmpty() || seen.contains(name)) return fail("empty or duplicate profile name " + profile.name);
+        seen.insert(name);
+        names.append(name);
+        namesSize += quint64(name.size()) + 1;
+        positionsSize += quint64(profile.positions.size()) * 8;
+    }
+    namesSize = (namesSize + 3) & ~quint64(3);
+
+    QByteArray buffer(int(poolStart + namesSize + positionsSize), '\0');
+    char *out = buffer.data();
+
+    ProfileStoreHeader *header = reinterpret_cast<ProfileStoreHeader *>(out);
+    std::memcpy(header->magic, "GPS1", 4);
+    header->recordSize = sizeof(StoredProfile);
+    header->count = quint32(profiles.size());
+    header->bucketCount = bucketCount;
+    header->fileSize = quint64(buffer.size());
+
+    quint32 *buckets = reinterpret_cast<quint32 *>(out + sizeof(ProfileStoreHeader));
+    StoredProfile *records = reinterpret_cast<StoredProfile *>(out + recordsOffset(bucketCount));
+    quint64 nameAt = poolStart;
+    quint64 positionsAt = poolStart + namesSize;
+
+    for (int i = 0; i < profiles.size(); ++i) {
+        const ProfileData &profile = profiles[i];
+        StoredProfile &record = records[i];
+        const qint64 recordAt = reinterpret_cast<char *>(&record) - out;
+
+        record.nameHash = nameHash(names[i]);
+        record.nameOffset = qint32(qint64(nameAt) - recordAt);
+        record.nameLength = quint32(names[i].size());
+        std::memcpy(out + nameAt, names[i].constData(), size_t(names[i].size()));
+        nameAt += quint64(names[i].size()) + 1;
+
+        record.positionsOffset = qint32(qint64(positionsAt) - recordAt);
+        record.positionCount = quint32(profile.positions.size());
+        qint32 *xy = reinterpret_cast<qint32 *>(out + positionsAt);
+        for (const QPoint &position : profile.positions) {
+            *xy++ = position.x();
+            *xy++ = position.y();
+        }
+        positionsAt += quint64(profile.positions.size()) * 8;
+
+        record.clicksPerSecond = quint32(qBound(1, profile.clicksPerSecond, 10000));
+        record.intervalDelayMs = profile.intervalDelayMs;
+        record.pressUs = profile.timing.pressUs;
+        record.gapUs = profile.timing.gapUs;
+        record.clickType = quint8(profile.clickType);
+        record.mouseMode = quint8(profile.mouseMode);
+        record.distribution = quint8(profile.intervals.distribution);
+        record.jitter = float(profile.intervals.jitter);
+        record.warmupSeconds = float(profile.intervals.warmupSeconds);
+        record.waveAmplitude = float(profile.intervals.waveAmplitude);
+        record.wavePeriodSeconds = float(profile.intervals.wavePeriodSeconds);
+
+        for (quint32 slot = quint32(record.nameHash) & (bucketCount - 1);; slot = (slot + 1) & (bucketCount - 1)) {
+            if (!buckets[slot]) {
+                buckets[slot] = quint32(i) + 1;
+                break;
+            }
+        }
+    }
+
+    // Readers with the old file mapped keep it; the new one replaces it whole
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(buffer) != buffer.size() || !file.commit()) {
+        return fail("cannot write " + path);
+    }
+    return true;
+}
@@ -0,0 +1,112 @@
+#ifndef PROFILESTORE_H
+#define PROFILESTORE_H
+
+#include <QPoint>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+#include <memory>
+#include "types.h"
+
+class QFile;
+
+// Profile store file: one ProfileStoreHeader, a hash table of bucketCount
+// quint32 entries (record index + 1, 0 for empty), count StoredProfiles,
+// then the names and position sequences they point to. Host byte order.
+struct ProfileStoreHeader {
+    char magic[4];         // "GPS1"
+    quint32 recordSize;    // sizeof(StoredProfile)
+    quint32 count;
+    quint32 bucketCount;   // A power of two, at least twice count
+    quint64 fileSize;
+    quint64 reserved;
+};
+
+// One profile, used in place in the mapped file. Offsets are relative to
+// the record itself, so a pointer to it is all the engine needs.
+struct StoredProfile {
+    quint64 nameHash;        // FNV-1a of the UTF-8 name
+    qint32 nameOffset;
+    quint32 nameLength;
+    qint32 positionsOffset;  // positionCount x,y pairs of qint32
+    quint32 positionCount;   // Clicked in turn; 0 clicks where the engine would
+    quint32 clicksPerSecond;
+    qint32 intervalDelayMs;  // Interval mode when > 0
+    qint32 pressUs;
+    qint32 gapUs;
+    quint8 clickType;        // ClickType
+    quint8 mouseMode;        // MouseMode
+    quint8 distribution;     // IntervalProfile::Distribution
+    quint8 reserved;
+    float jitter;
+    float warmupSeconds;
+    float waveAmplitude;
+    float wavePeriodSeconds;
+    quint32 padding;
+
+    QString name() const;
+    QPoint position(quint32 index) const
+    {
+        const qint32 *xy = reinterpret_cast<const qint32 *>(reinterpret_cast<const char *>(this) + positionsOffset) + 2 * index;
+        return QPoint(xy[0], xy[1]);
+    }
+    bool isInterval() const { return intervalDelayMs > 0; }
+    ClickTiming timing() const;
+    IntervalProfile intervals() const;
+};
+
+static_assert(sizeof(ProfileStoreHeader) == 32, "profile store header layout");
+static_assert(sizeof(StoredProfile) == 64, "stored profile layout");
+
+// The settings of one profile, for building a store
+struct ProfileData {
+    QString name;
+    int clicksPerSecond = 10;
+    ClickType clickType = ClickType::LeftClick;
+    MouseMode mouseMode = MouseMode::Unlocked;
+    int intervalDelayMs = 0;
+    ClickTiming timing;
+    IntervalProfile intervals;
+    QVector<QPoint> positions;
+};
+
+// Many named profiles in one memory-mapped file. Opening maps the file and
+// checks the header only, and find() is one hash probe, so both take the
+// same time for ten profiles or ten thousand. Records are checked against
+// the file bounds, and their rate, enums and timing against the ranges the
+// engine accepts, when they are looked up.
+//
+// Profiles handed to AutoClicker::useProfile() point into the mapping: detach
+// them from the engine before the store is closed or destroyed.
+class ProfileStore
+{
+public:
+    ProfileStore();
+    ~ProfileStore();
+
+    bool open(const QString &path);
+    void close();
+    bool isOpen() const;
+    QString path() const;
+
+    const StoredProfile *find(const QString &name) const;
+    quint32 count() const;
+    const StoredProfile *at(quint32 index) const; // In build order
+
+    // The GUI's settings keys as in AutoClicker::loadProfile(), plus
+    // positions=x,y x,y ... for a sequence; named after the file
+    static bool readIni(const QString &path, ProfileData *profile);
+    static bool write(const QString &path, const QVector<ProfileData> &profiles, QString *error = nullptr);
+
+private:
+    const StoredProfile *checked(quint32 index) const;
+
+    std::unique_ptr<QFile> file;
+    const uchar *data;
+    quint64 size;
+    const ProfileStoreHeader *header;
+    const quint32 *buckets;
+    const StoredProfile *records;
+};
+
+#endif // PROFILESTORE_H
@@ -0,0 +1,216 @@
+#include "screenlayout.h"
+#include <QDebug>
+#include <QMutexLocker>
+#include <QSocketNotifier>
+
+#if !defined(Q_OS_WIN) && !defined(Q_OS_MAC)
+#include <X11/Xlib.h>
+#include <X11/extensions/Xrandr.h>
+#endif
+
+ScreenLayout::ScreenLayout(QObject *parent)
+    : QObject(parent)
+    , display(nullptr)
+    , root(0)
+    , notifier(nullptr)
+    , eventBase(0)
+{
+    for (int i = 0; i < MaxMonitors; ++i) {
+        origins[i].store(0);
+        connected[i].store(false);
+    }
+}
+
+ScreenLayout::~ScreenLayout()
+{
+    stop();
+}
+
+bool ScreenLayout::start()
+{
+    if (display) return true;
+
+#ifdef Q_OS_WIN
+    return false;
+#elif defined(Q_OS_MAC)
+    return false;
+#else
+    display = XOpenDisplay(nullptr);
+    if (!display) return false;
+
+    // Monitors need RandR 1.5
+    int errorBase = 0, major = 0, minor = 0;
+    if (!XRRQueryExtension(display, &eventBase, &errorBase) || !XRRQueryVersion(display, &major, &minor) ||
+        major < 1 || (major == 1 && minor < 5)) {
+        qWarning() << "ScreenLayout: RandR 1.5 not available";
+        XCloseDisplay(display);
+        display = nullptr;
+        return false;
+    }
+
+    root = DefaultRootWindow(display);
+
+    // Select before reading so a change in between is not missed
+    XRRSelectInput(display, root, RRScreenChangeNotifyMask | RRCrtcChangeNotifyMask | RROutputChangeNotifyMask);
+    refresh();
+
+    notifier = new QSocketNotifier(ConnectionNumber(display), QSocketNotifier::Read, this);
+    connect(notifier, &QSocketNotifier::activated, this, &ScreenLayout::processXEvents);
+
+    processXEvents();
+    return true;
+#endif
+}
+
+void ScreenLayout::stop()
+{
+    if (!display) return;
+
+    delete notifier;
+    notifier = nullptr;
+
+#if !defined(Q_OS_WIN) && !defined(Q_OS_MAC)
+    XCloseDisplay(display);
+#endif
+    display = nullptr;
+
+    // Slots stay allocated; their positions wait for a restart
+    QMutexLocker locker(&mutex);
+    current.clear();
+    for (int i = 0; i < names.size(); ++i) {
+        connected[i].store(false, std::memory_order_release);
+    }
+}
+
+bool ScreenLayout::isActive() const
+{
+    return display != nullptr;
+}
+
+QVector<MonitorInfo> ScreenLayout::monitors() const
+{
+    QMutexLocker locker(&mutex);
+    return current;
+}
+
+int ScreenLayout::monitorSlot(const QString &name)
+{
+    if (name.isEmpty()) return -1;
+
+    QMutexLocker locker(&mutex);
+    if (!display) return -1;
+
+    int slot = names.indexOf(name);
+    if (slot < 0) {
+        if (names.size() >= MaxMonitors) return -1;
+        slot = names.size();
+        names.append(name);
+        publish(slot);
+    }
+    return slot;
+}
+
+int ScreenLayout::slotAt(const QPoint &position)
+{
+    QString name;
+    {
+        QMutexLocker locker(&mutex);
+        for (const MonitorInfo &monitor : current) {
+            if (monitor.geometry.contains(position)) {
+                name = monitor.name;
+                break;
+            }
+        }
+    }
+    return monitorSlot(name);
+}
+
+QString ScreenLayout::slotName(int slot) const
+{
+    QMutexLocker locker(&mutex);
+    return names.value(slot);
+}
+
+bool ScreenLayout::parsePosition(const QString &text, QString *monitor, QPoint *offset)
+{
+    // Monitor names may contain colons, the coordinates never do
+    const int colon = text.lastIndexOf(':');
+    const QString name = colon >= 0 ? text.left(colon) : QString();
+    const QStringList coordinates = text.mid(colon + 1).split(',');
+    bool okX = false, okY = false;
+    const int x = coordinates.value(0).toInt(&okX);
+    const int y = coordinates.value(1).toInt(&okY);
+    if (coordinates.size() != 2 || !okX || !okY || (colon >= 0 && name.isEmpty())) return false;
+
+    *monitor = name;
+    *offset = QPoint(x, y);
+    return true;
+}
+
+void ScreenLayout::publish(int slot)
+{
+    const QString &name = names[slot];
+    for (const MonitorInfo &monitor : current) {
+        if (monitor.name == name || (monitor.primary && name == "primary")) {
+            // Origin first, so a reader that sees the slot connected sees it too
+            origins[slot].store(packPoint(monitor.geometry.topLeft()), std::memory_order_relaxed);
+            connected[slot].store(true, std::memory_order_release);
+            return;
+        }
+    }
+    connected[slot].store(false, std::memory_order_release);
+}
+
+#if !defined(Q_OS_WIN) && !defined(Q_OS_MAC)
+void ScreenLayout::refresh()
+{
+    QVector<MonitorInfo> layout;
+    int count = 0;
+    XRRMonitorInfo *list = XRRGetMonitors(display, root, True, &count);
+    for (int i = 0; i < count; ++i) {
+        MonitorInfo monitor;
+        if (char *name = XGetAtomName(display, list[i].name)) {
+            monitor.name = QString::fromLatin1(name);
+            XFree(name);
+        }
+        monitor.geometry = QRect(list[i].x, list[i].y, list[i].width, list[i].height);
+        monitor.primary = list[i].primary;
+        layout.append(monitor);
+    }
+    if (list) XRRFreeMonitors(list);
+
+    {
+        QMutexLocker locker(&mutex);
+        current = layout;
+        for (int i = 0; i < names.size(); ++i) {
+            publish(i);
+        }
+    }
+    emit layoutChanged();
+}
+
+void ScreenLayout::processXEvents()
+{
+    if (!display) return;
+
+    bool dirty = false;
+
+    while (XPending(display)) {
+        XEvent event;
+        XNextEvent(display, &event);
+
+        // Several events arrive for one change; the layout is read once after them
+        if (event.type == eventBase + RRScreenChangeNotify) {
+            XRRUpdateConfiguration(&event);
+            dirty = true;
+        } else if (event.type == eventBase + RRNotify) {
+            dirty = true;
+        }
+    }
+
+    if (dirty) refresh();
+}
+#else
+void ScreenLayout::refresh() {}
+void ScreenLayout::processXEvents() {}
+#endif
@@ -0,0 +1,90 @@
+#ifndef SCREENLAYOUT_H
+#define SCREENLAYOUT_H
+
+#include <QObject>
+#include <QMutex>
+#include <QPoint>
+#include <QRect>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <atomic>
+#include "types.h"
+
+class QSocketNotifier;
+struct _XDisplay;
+
+struct MonitorInfo {
+    QString name; // RandR monitor name, usually the output's, e.g. "DP-1"
+    QRect geometry; // Root window coordinates
+    bool primary = false;
+};
+
+// Caches the monitor layout from XRandR so monitor-relative positions
+// resolve without a server round trip. Read once on start, then refreshed
+// from RRScreenChangeNotify and RRNotify events when monitors are plugged,
+// unplugged or rearranged.
+//
+// Monitors are addressed by name through slots that keep their index for
+// the lifetime of the layout, so the click engine holds a slot number and
+// resolving it is one atomic load. A slot whose monitor is gone stays
+// allocated and reports disconnected until a monitor of that name returns.
+// The name "primary" follows whichever monitor is primary.
+class ScreenLayout : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int MaxMonitors = 16;
+
+    explicit ScreenLayout(QObject *parent = nullptr);
+    ~ScreenLayout();
+
+    bool start();
+    void stop();
+    bool isActive() const;
+
+    QVector<MonitorInfo> monitors() const;
+
+    // Safe from any thread; -1 when the table is full or the layout inactive
+    int monitorSlot(const QString &name);
+    int slotAt(const QPoint &position); // Slot of the monitor under a root position
+    QString slotName(int slot) const;
+
+    // Hot path: no locking and no X requests
+    bool isConnected(int slot) const
+    {
+        return connected[slot].load(std::memory_order_acquire);
+    }
+    QPoint origin(int slot) const
+    {
+        return unpackPoint(origins[slot].load(std::memory_order_relaxed));
+    }
+
+    // "[monitor:]x,y"; monitor is left empty for root coordinates
+    static bool parsePosition(const QString &text, QString *monitor, QPoint *offset);
+
+signals:
+    void layoutChanged();
+
+private slots:
+    void processXEvents();
+
+private:
+    void refresh();
+    void publish(int slot); // Caller holds the mutex
+
+    _XDisplay *display;
+    unsigned long root;
+    QSocketNotifier *notifier;
+    int eventBase;
+
+    mutable QMutex mutex; // Guards current and names
+    QVector<MonitorInfo> current;
+    QStringList names; // Slot index to monitor name
+
+    std::atomic<qint64> origins[MaxMonitors]; // packPoint()
+    std::atomic<bool> connected[MaxMonitors];
+};
+
+#endif // SCREENLAYOUT_H
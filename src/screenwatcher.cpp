@@ -0,0 +1,416 @@
+#include "screenwatcher.h"
+#include "clickerthread.h"
+#include "auditlog.h"
+#include "clickmetrics.h"
+#include <QDebug>
+#include <QStringList>
+#include <chrono>
+
+#if !defined(Q_OS_WIN) && !defined(Q_OS_MAC)
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+#include <X11/extensions/Xdamage.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <poll.h>
+
+struct ShmCapture {
+    XShmSegmentInfo info;
+    XImage *image = nullptr;
+};
+
+// XShmAttach reports a server that cannot map the segment, e.g. a remote
+// one, asynchronously as an X error
+static bool attachFailed = false;
+
+static int attachErrorHandler(Display *, XErrorEvent *)
+{
+    attachFailed = true;
+    return 0;
+}
+#else
+struct ShmCapture {};
+#endif
+
+ScreenWatcher::ScreenWatcher(ClickerThread *clicker, QObject *parent)
+    : QThread(parent)
+    , clickerThread(clicker)
+    , running(false)
+    , paused(false)
+    , display(nullptr)
+    , shm(nullptr)
+    , damage(0)
+    , damageEventBase(0)
+    , matched(false)
+    , triggers(0)
+    , totalLatencyNs(0)
+    , lastLatencyNs(0)
+    , maxLatencyNs(0)
+{
+}
+
+ScreenWatcher::~ScreenWatcher()
+{
+    stop();
+}
+
+bool ScreenWatcher::parseTrigger(const QString &spec, ScreenTrigger *trigger)
+{
+    QStringList parts = spec.split(',');
+    const QString rule = parts.value(0).trimmed().toLower();
+
+    // The image file of a template rule follows the region
+    QString file;
+    if (rule == "template") {
+        if (parts.size() < 6 || parts.size() > 7) return false;
+        file = parts.takeAt(5).trimmed();
+        if (file.isEmpty()) return false;
+    }
+
+    QVector<int> values;
+    for (int i = 1; i < parts.size(); ++i) {
+        bool ok = false;
+        const QString part = parts[i].trimmed();
+        // The color of a pixel rule is hex, with or without a leading #
+        const int value = rule == "pixel" && i == 3 ? part.mid(part.startsWith('#') ? 1 : 0).toInt(&ok, 16)
+                                                    : part.toInt(&ok);
+        if (!ok || value < 0) return false;
+        values.append(value);
+    }
+
+    ScreenTrigger result;
+    if (rule == "pixel" && (values.size() == 3 || values.size() == 4)) {
+        result.rule = ScreenTrigger::PixelColor;
+        result.region = QRect(values[0], values[1], 1, 1);
+        result.color = quint32(values[2]) & 0xFFFFFF;
+        result.tolerance = values.value(3, 0);
+    } else if (rule == "change" && values.size() >= 4 && values.size() <= 6) {
+        result.rule = ScreenTrigger::RegionChanged;
+        result.region = QRect(values[0], values[1], values[2], values[3]);
+        result.tolerance = values.value(4, 0);
+        result.minChangedPixels = qMax(1, values.value(5, 1));
+    } else if (rule == "template" && (values.size() == 4 || values.size() == 5)) {
+        result.rule = ScreenTrigger::TemplateFound;
+        result.region = QRect(values[0], values[1], values[2], values[3]);
+        result.templateFile = file;
+        result.matchThreshold = values.value(4, result.matchThreshold);
+        if (result.matchThreshold > 255) return false;
+    } else {
+        return false;
+    }
+    if (result.region.isEmpty()) return false;
+
+    *trigger = result;
+    return true;
+}
+
+void ScreenWatcher::setTrigger(const ScreenTrigger &newTrigger)
+{
+    // Applied on the next start; the capture segment is sized from the region
+    trigger = newTrigger;
+}
+
+void ScreenWatcher::setTemplate(const GrayImage &templ)
+{
+    matcher.setTemplate(templ);
+}
+
+void ScreenWatcher::startWatching()
+{
+    if (isRunning()) return;
+    running.store(true);
+    start();
+}
+
+void ScreenWatcher::stop()
+{
+    running.store(false);
+    wait();
+}
+
+void ScreenWatcher::setPaused(bool pause)
+{
+    paused.store(pause, std::memory_order_relaxed);
+}
+
+quint64 ScreenWatcher::triggerCount() const
+{
+    return triggers.load(std::memory_order_relaxed);
+}
+
+double ScreenWatcher::lastLatencyUs() const
+{
+    return lastLatencyNs.load(std::memory_order_relaxed) / 1000.0;
+}
+
+double ScreenWatcher::maxLatencyUs() const
+{
+    return maxLatencyNs.load(std::memory_order_relaxed) / 1000.0;
+}
+
+double ScreenWatcher::meanLatencyUs() const
+{
+    const quint64 count = triggers.load(std::memory_order_relaxed);
+    return count ? totalLatencyNs.load(std::memory_order_relaxed) / 1000.0 / count : 0.0;
+}
+
+#if !defined(Q_OS_WIN) && !defined(Q_OS_MAC)
+bool ScreenWatcher::setupCapture()
+{
+    if (trigger.region.isEmpty()) return false;
+
+    display = XOpenDisplay(nullptr);
+    if (!display) return false;
+
+    int damageErrorBase = 0;
+    if (!XShmQueryExtension(display) ||
+        !XDamageQueryExtension(display, &damageEventBase, &damageErrorBase)) {
+        qWarning() << "ScreenWatcher: MIT-SHM and XDamage are required";
+        XCloseDisplay(display);
+        display = nullptr;
+        return false;
+    }
+
+    // XShmGetImage fails with BadMatch, fatal under the default handler, for
+    // an area off the root window; keep only the part that is on screen
+    const int screen = DefaultScreen(display);
+    const QRect visible = trigger.region.intersected(
+        QRect(0, 0, DisplayWidth(display, screen), DisplayHeight(display, screen)));
+    if (visible.isEmpty()) {
+        qWarning() << "ScreenWatcher: region" << trigger.region << "is off screen";
+        XCloseDisplay(display);
+        display = nullptr;
+        return false;
+    }
+    if (visible != trigger.region) {
+        qWarning() << "ScreenWatcher: region clipped to" << visible;
+        trigger.pixel -= visible.topLeft() - trigger.region.topLeft();
+        trigger.region = visible;
+    }
+
+    shm = new ShmCapture;
+    shm->image = XShmCreateImage(display, DefaultVisual(display, screen), DefaultDepth(display, screen),
+                                 ZPixmap, nullptr, &shm->info,
+                                 trigger.region.width(), trigger.region.height());
+    if (!shm->image) {
+        releaseCapture();
+        return false;
+    }
+
+    // pixelAt() and the template search read 32-bit BGRX pixels
+    if (shm->image->bits_per_pixel != 32) {
+        qWarning() << "ScreenWatcher: needs a 32 bpp visual, not" << shm->image->bits_per_pixel;
+        releaseCapture();
+        return false;
+    }
+
+    shm->info.shmid = shmget(IPC_PRIVATE, shm->image->bytes_per_line * shm->image->height, IPC_CREAT | 0600);
+    if (shm->info.shmid < 0) {
+        releaseCapture();
+        return false;
+    }
+
+    // Mark for removal now; the segment lives until both sides detach
+    void *address = shmat(shm->info.shmid, nullptr, 0);
+    shmctl(shm->info.shmid, IPC_RMID, nullptr);
+    if (address == reinterpret_cast<void *>(-1)) {
+        qWarning() << "ScreenWatcher: cannot attach the capture segment";
+        releaseCapture();
+        return false;
+    }
+
+    shm->info.shmaddr = shm->image->data = static_cast<char *>(address);
+    shm->info.readOnly = False;
+    attachFailed = false;
+    XErrorHandler previousHandler = XSetErrorHandler(attachErrorHandler);
+    const bool attached = XShmAttach(display, &shm->info);
+    XSync(display, False);
+    XSetErrorHandler(previousHandler);
+    if (!attached || attachFailed) {
+        qWarning() << "ScreenWatcher: the X server cannot attach the capture segment";
+        shmdt(shm->info.shmaddr);
+        shm->image->data = nullptr;
+        releaseCapture();
+        return false;
+    }
+
+    damage = XDamageCreate(display, DefaultRootWindow(display), XDamageReportRawRectangles);
+    return true;
+}
+
+void ScreenWatcher::releaseCapture()
+{
+    if (display && damage) {
+        XDamageDestroy(display, damage);
+        damage = 0;
+    }
+
+    if (shm) {
+        if (shm->image) {
+            if (shm->image->data) {
+                XShmDetach(display, &shm->info);
+                shmdt(shm->info.shmaddr);
+                shm->image->data = nullptr;
+            }
+            XDestroyImage(shm->image);
+        }
+        delete shm;
+        shm = nullptr;
+    }
+
+    if (display) {
+        XCloseDisplay(display);
+        display = nullptr;
+    }
+}
+
+bool ScreenWatcher::capture()
+{
+    return XShmGetImage(display, DefaultRootWindow(display), shm->image,
+                        trigger.region.x(), trigger.region.y(), AllPlanes);
+}
+
+quint32 ScreenWatcher::pixelAt(int x, int y) const
+{
+    const char *row = shm->image->data + y * shm->image->bytes_per_line;
+    return reinterpret_cast<const quint32 *>(row)[x] & 0xFFFFFF;
+}
+
+static inline bool channelsWithin(quint32 a, quint32 b, int tolerance)
+{
+    return qAbs(int((a >> 16) & 0xFF) - int((b >> 16) & 0xFF)) <= tolerance &&
+           qAbs(int((a >> 8) & 0xFF) - int((b >> 8) & 0xFF)) <= tolerance &&
+           qAbs(int(a & 0xFF) - int(b & 0xFF)) <= tolerance;
+}
+
+bool ScreenWatcher::evaluate()
+{
+    const int width = trigger.region.width();
+    const int height = trigger.region.height();
+
+    if (trigger.rule == ScreenTrigger::TemplateFound) {
+        const GrayImage gray = GrayImage::fromBgra(reinterpret_cast<const quint32 *>(shm->image->data),
+                                                   width, height, shm->image->bytes_per_line);
+        const TemplateMatcher::Match match = matcher.find(gray);
+        if (!match.found) return false;
+
+        const QPoint position = trigger.region.topLeft() + match.center;
+        const bool moved = position != foundPosition;
+        foundPosition = position;
+        // A target that reappears elsewhere counts as a new match
+        if (moved) matched = false;
+        return true;
+    }
+
+    if (trigger.rule == ScreenTrigger::PixelColor) {
+        const int x = qBound(0, trigger.pixel.x(), width - 1);
+        const int y = qBound(0, trigger.pixel.y(), height - 1);
+        return channelsWithin(pixelAt(x, y), trigger.color, trigger.tolerance);
+    }
+
+    int changed = 0;
+    for (int y = 0; y < height; ++y) {
+        const quint32 *base = baseline.constData() + y * width;
+        for (int x = 0; x < width; ++x) {
+            if (!channelsWithin(pixelAt(x, y), base[x], trigger.tolerance) &&
+                ++changed >= trigger.minChangedPixels) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ScreenWatcher::run()
+{
+    AuditLog::setThreadContext(AuditLog::Trigger);
+    if (!setupCapture()) {
+        qWarning() << "ScreenWatcher: unable to start capture";
+        running.store(false);
+        return;
+    }
+
+    const int width = trigger.region.width();
+    const int height = trigger.region.height();
+    const QRect &region = trigger.region;
+
+    capture();
+    baseline.resize(width * height);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            baseline[y * width + x] = pixelAt(x, y);
+        }
+    }
+    matched = false;
+    foundPosition = QPoint(-1, -1);
+    matcher.setThreshold(trigger.matchThreshold);
+
+    pollfd pfd;
+    pfd.fd = ConnectionNumber(display);
+    pfd.events = POLLIN;
+
+    while (running.load(std::memory_order_relaxed)) {
+        // Short timeout only so stop() is honoured; captures are event-driven
+        if (!XPending(display) && poll(&pfd, 1, 50) <= 0) continue;
+
+        bool dirty = false;
+        while (XPending(display)) {
+            XEvent event;
+            XNextEvent(display, &event);
+            if (event.type == damageEventBase + XDamageNotify) {
+                const XDamageNotifyEvent *notify = reinterpret_cast<XDamageNotifyEvent *>(&event);
+                const QRect area(notify->area.x, notify->area.y, notify->area.width, notify->area.height);
+                if (area.intersects(region)) dirty = true;
+            }
+        }
+        if (!dirty) continue;
+
+        const auto detected = std::chrono::steady_clock::now();
+        XDamageSubtract(display, damage, None, None);
+
+        if (!capture()) continue;
+
+        // Edge-triggered: click once per transition into the matching state.
+        // Transitions while paused are tracked but not clicked
+        const bool hit = evaluate();
+        if (hit && !matched && !paused.load(std::memory_order_relaxed)) {
+            if (trigger.rule == ScreenTrigger::TemplateFound) {
+                clickerThread->setClickPosition(foundPosition);
+                clickerThread->performClickAt(foundPosition);
+            } else {
+                clickerThread->performClick();
+            }
+
+            const auto clicked = std::chrono::steady_clock::now();
+            const quint64 latency = std::chrono::duration_cast<std::chrono::nanoseconds>(clicked - detected).count();
+            triggers.fetch_add(1, std::memory_order_relaxed);
+            totalLatencyNs.fetch_add(latency, std::memory_order_relaxed);
+            lastLatencyNs.store(latency, std::memory_order_relaxed);
+            if (latency > maxLatencyNs.load(std::memory_order_relaxed)) {
+                maxLatencyNs.store(latency, std::memory_order_relaxed);
+            }
+
+            ClickMetrics::recordClick(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                clicked.time_since_epoch()).count(), -1);
+
+            emit triggered(latency / 1000.0);
+        }
+        matched = hit;
+    }
+
+    ClickMetrics::publish();
+    releaseCapture();
+}
+#else
+bool ScreenWatcher::setupCapture() { return false; }
+void ScreenWatcher::releaseCapture() {}
+bool ScreenWatcher::capture() { return false; }
+bool ScreenWatcher::evaluate() { return false; }
+quint32 ScreenWatcher::pixelAt(int, int) const { return 0; }
+
+void ScreenWatcher::run()
+{
+    qWarning() << "ScreenWatcher: pixel triggers are only supported on X11";
+}
+#endif
@@ -0,0 +1,75 @@
+#ifndef SCREENWATCHER_H
+#define SCREENWATCHER_H
+
+#include <QThread>
+#include <QVector>
+#include <atomic>
+#include "types.h"
+#include "templatematcher.h"
+
+class ClickerThread;
+struct ShmCapture;
+struct _XDisplay;
+
+// Watches a screen region for pixel-triggered clicking. The region is grabbed
+// with XShmGetImage into one reusable shared-memory segment, and only after
+// XDamage reports a change that overlaps it.
+class ScreenWatcher : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit ScreenWatcher(ClickerThread *clicker, QObject *parent = nullptr);
+    ~ScreenWatcher();
+
+    // pixel,x,y,rrggbb[,tolerance], change,x,y,w,h[,tolerance[,pixels]] or
+    // template,x,y,w,h,file[,threshold]
+    static bool parseTrigger(const QString &spec, ScreenTrigger *trigger);
+
+    void setTrigger(const ScreenTrigger &trigger);
+    void setTemplate(const GrayImage &templ); // For ScreenTrigger::TemplateFound
+    void startWatching();
+    void stop();
+    void setPaused(bool paused); // Keeps watching but does not click
+
+    // Detection-to-click latency, measured from reading the damage event to
+    // the injected click returning
+    quint64 triggerCount() const;
+    double lastLatencyUs() const;
+    double maxLatencyUs() const;
+    double meanLatencyUs() const;
+
+signals:
+    void triggered(double latencyUs);
+
+protected:
+    void run() override;
+
+private:
+    bool setupCapture();
+    void releaseCapture();
+    bool capture();
+    bool evaluate();
+    quint32 pixelAt(int x, int y) const;
+
+    ClickerThread *clickerThread;
+    ScreenTrigger trigger;
+    std::atomic<bool> running;
+    std::atomic<bool> paused;
+
+    _XDisplay *display;
+    ShmCapture *shm;
+    unsigned long damage;
+    int damageEventBase;
+    QVector<quint32> baseline;
+    bool matched;
+    PyramidMatcher matcher;
+    QPoint foundPosition;
+
+    std::atomic<quint64> triggers;
+    std::atomic<quint64> totalLatencyNs;
+    std::atomic<quint64> lastLatencyNs;
+    std::atomic<quint64> maxLatencyNs;
+};
+
+#endif // SCREENWATCHER_H
@@ -0,0 +1,240 @@
+#include "shardedinjector.h"
+#include "clickerthread.h"
+#include "auditlog.h"
+#include "clickmetrics.h"
+#include "clicktrace.h"
+#include <QMutexLocker>
+#include <chrono>
+
+static qint64 nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+ShardedInjector::ShardedInjector()
+    : shards(1)
+    , clickType(ClickType::LeftClick)
+    , synchronous(true)
+    , intervalNs(0)
+    , running(false)
+    , paused(false)
+    , pausedNs(0)
+    , turn(0)
+    , lastShard(-1)
+    , epochNs(0)
+    , clicks(0)
+    , startedNs(0)
+    , stoppedNs(0)
+{
+}
+
+ShardedInjector::~ShardedInjector()
+{
+    stop();
+}
+
+void ShardedInjector::setShardCount(int count)
+{
+    shards = qBound(1, count, 64);
+}
+
+void ShardedInjector::setDisplayName(const QString &name)
+{
+    displayName = name;
+}
+
+void ShardedInjector::setClickType(ClickType type)
+{
+    clickType = type;
+}
+
+void ShardedInjector::setSynchronous(bool sync)
+{
+    synchronous = sync;
+}
+
+void ShardedInjector::setPositionSource(const PositionSource &source)
+{
+    positionSource = source;
+}
+
+bool ShardedInjector::isRunning() const
+{
+    return running.load();
+}
+
+int ShardedInjector::shardCount() const
+{
+    return shards;
+}
+
+quint64 ShardedInjector::clickCount() const
+{
+    return clicks.load(std::memory_order_relaxed);
+}
+
+double ShardedInjector::achievedClicksPerSecond() const
+{
+    if (!startedNs) return 0.0;
+    const qint64 end = running.load() ? nowNs() : stoppedNs.load();
+    return end > startedNs ? clickCount() / ((end - startedNs) / 1e9) : 0.0;
+}
+
+bool ShardedInjector::start(int clicksPerSecond)
+{
+    if (running.load() || !positionSource) return false;
+
+    intervalNs = clicksPerSecond > 0 ? 1000000000LL / clicksPerSecond : 0;
+
+    // One connection per shard; opened up front so the first clicks are not delayed
+    injectors.clear();
+    for (int i = 0; i < shards; ++i) {
+        std::unique_ptr<ClickerThread> injector(new ClickerThread(displayName));
+        injector->setClickType(clickType);
+        injector->sync();
+        injectors.push_back(std::move(injector));
+    }
+
+    turnChanged.reset(new QWaitCondition[shards]);
+    turn.store(0);
+    lastShard = -1;
+    clicks.store(0);
+    startedNs = nowNs();
+    epochNs.store(startedNs);
+    running.store(true);
+
+    for (int i = 0; i < shards; ++i) {
+        threads.emplace_back(&ShardedInjector::shardLoop, this, i);
+    }
+    return true;
+}
+
+void ShardedInjector::stop()
+{
+    {
+        QMutexLocker locker(&pauseMutex);
+        paused.store(false);
+        if (!running.exchange(false)) return;
+        resumed.wakeAll();
+    }
+    {
+        QMutexLocker locker(&turnMutex);
+        for (int i = 0; i < shards; ++i) turnChanged[i].wakeAll();
+    }
+
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    threads.clear();
+    stoppedNs.store(nowNs());
+}
+
+void ShardedInjector::pause()
+{
+    QMutexLocker locker(&pauseMutex);
+    if (paused.exchange(true)) return;
+    pausedNs = nowNs();
+}
+
+void ShardedInjector::resume()
+{
+    QMutexLocker locker(&pauseMutex);
+    if (!paused.load()) return;
+    epochNs.fetch_add(nowNs() - pausedNs);
+    paused.store(false);
+    resumed.wakeAll();
+}
+
+void ShardedInjector::waitWhilePaused()
+{
+    ClickMetrics::publish();
+    QMutexLocker locker(&pauseMutex);
+    while (paused.load() && running.load()) {
+        resumed.wait(&pauseMutex);
+    }
+}
+
+void ShardedInjector::waitForTurn(int shard, quint64 n)
+{
+    if (turn.load(std::memory_order_acquire) == n) return;
+
+    QMutexLocker locker(&turnMutex);
+    while (turn.load(std::memory_order_acquire) != n && running.load(std::memory_order_relaxed)) {
+        turnChanged[shard].wait(&turnMutex);
+    }
+}
+
+void ShardedInjector::passTurn(quint64 next)
+{
+    QMutexLocker locker(&turnMutex);
+    turn.store(next, std::memory_order_release);
+    turnChanged[next % quint64(shards)].wakeOne();
+}
+
+void ShardedInjector::shardLoop(int shard)
+{
+    ClickerThread *injector = injectors[shard].get();
+    ClickTrace::setThreadName(QString("shard-%1").arg(shard));
+    AuditLog::setThreadContext(AuditLog::Shard, quint32(shard));
+
+    for (quint64 n = quint64(shard); running.load(std::memory_order_relaxed); n += quint64(shards)) {
+        if (paused.load(std::memory_order_acquire)) waitWhilePaused();
+
+        if (intervalNs) {
+            const qint64 due = epochNs.load(std::memory_order_relaxed) + qint64(n) * intervalNs;
+            const qint64 wait = due - nowNs();
+            if (wait > 0) std::this_thread::sleep_for(std::chrono::nanoseconds(qMin(wait, qint64(50000000))));
+        }
+
+        // Wait for our turn; the previous click has been sent once turn reaches
+        // n. A pause parks the turn holder below, so the others keep waiting here
+        waitForTurn(shard, n);
+        if (!running.load(std::memory_order_relaxed)) return;
+
+        // The turn holder parks here, so a resume continues with click n
+        if (paused.load(std::memory_order_acquire)) waitWhilePaused();
+        if (!running.load(std::memory_order_relaxed)) return;
+
+        qint64 lateNs = -1;
+        if (intervalNs) {
+            // A stall (short sleep above, target unmapped, slow server) moves the
+            // schedule forward rather than letting the shards burst to catch up
+            const qint64 now = nowNs();
+            const qint64 due = epochNs.load(std::memory_order_relaxed) + qint64(n) * intervalNs;
+            lateNs = qMax(qint64(0), now - due);
+            if (now < due) {
+                std::this_thread::sleep_for(std::chrono::nanoseconds(due - now));
+                ClickTrace::complete("wakeup", due, nowNs());
+            } else if (now - due > intervalNs) {
+                epochNs.store(now - qint64(n) * intervalNs, std::memory_order_relaxed);
+                ClickMetrics::recordMissed(quint64((now - due) / intervalNs));
+            }
+        }
+
+        QPoint pos;
+        const bool click = positionSource(&pos);
+        if (click) {
+            // Moving before the previous click has been processed on its own
+            // connection could pull that click, or its release, over here
+            if (lastShard >= 0 && lastShard != shard && pos != lastPosition) {
+                injectors[lastShard]->sync();
+            }
+            injector->performClickAt(pos);
+            lastShard = shard;
+            lastPosition = pos;
+        }
+        passTurn(n + 1);
+
+        if (!click) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        // The round trip overlaps with the other shards sending their clicks
+        if (synchronous) injector->sync();
+        clicks.fetch_add(1, std::memory_order_relaxed);
+        if (ClickMetrics::isEnabled()) ClickMetrics::recordClick(nowNs(), lateNs);
+    }
+    ClickMetrics::publish();
+}
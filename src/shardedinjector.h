@@ -0,0 +1,91 @@
+#ifndef SHARDEDINJECTOR_H
+#define SHARDEDINJECTOR_H
+
+#include <QMutex>
+#include <QPoint>
+#include <QString>
+#include <QWaitCondition>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "types.h"
+
+class ClickerThread;
+
+// Rapid clicking spread over K independent connections to one display, each
+// driven by its own thread. Click n belongs to shard n % K and is sent only
+// once click n - 1 has been sent; what overlaps is the wait for the server
+// (XSync) on each connection.
+//
+// The server does not order requests from different connections, so a
+// click's warp could land between the previous click's warp and its button
+// events. A click whose position differs from the previous one therefore
+// first waits until the server has processed that click; clicks at a fixed
+// position overlap fully.
+class ShardedInjector
+{
+public:
+    // Called in click order; return false to skip this slot (e.g. target unmapped)
+    using PositionSource = std::function<bool(QPoint *pos)>;
+
+    ShardedInjector();
+    ~ShardedInjector();
+
+    void setShardCount(int shards);
+    void setDisplayName(const QString &name);
+    void setClickType(ClickType type);
+    void setSynchronous(bool sync); // Each shard waits for the server after its click
+    void setPositionSource(const PositionSource &source);
+
+    bool start(int clicksPerSecond); // 0: as fast as the shards can go
+    void stop();
+    bool isRunning() const;
+
+    // Parks the shards without closing their connections; resume() shifts the
+    // schedule by the paused time so click spacing is unchanged. pause()
+    // before start() starts paused.
+    void pause();
+    void resume();
+    int shardCount() const;
+
+    quint64 clickCount() const;
+    double achievedClicksPerSecond() const; // Since start()
+
+private:
+    void shardLoop(int shard);
+    void waitWhilePaused();
+    void waitForTurn(int shard, quint64 n);
+    void passTurn(quint64 next);
+
+    int shards;
+    QString displayName;
+    ClickType clickType;
+    bool synchronous;
+    PositionSource positionSource;
+    qint64 intervalNs;
+
+    std::vector<std::unique_ptr<ClickerThread>> injectors;
+    std::vector<std::thread> threads;
+    std::atomic<bool> running;
+    std::atomic<bool> paused;
+    qint64 pausedNs; // Guarded by pauseMutex
+    QMutex pauseMutex;
+    QWaitCondition resumed;
+
+    // Turn waiters sleep on their own shard's condition; the holder wakes
+    // only the next one
+    QMutex turnMutex;
+    std::unique_ptr<QWaitCondition[]> turnChanged;
+
+    alignas(64) std::atomic<quint64> turn;   // Next click allowed to be sent
+    int lastShard;                           // Sender of the last click, -1 for none; turn holder only
+    QPoint lastPosition;                     // Where it clicked
+    alignas(64) std::atomic<qint64> epochNs; // Due time of click 0; moved forward after stalls
+    alignas(64) std::atomic<quint64> clicks;
+    qint64 startedNs;
+    std::atomic<qint64> stoppedNs;
+};
+
+#endif // SHARDEDINJECTOR_H
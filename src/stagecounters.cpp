@@ -0,0 +1,207 @@
+#include "stagecounters.h"
+#include <QMutex>
+#include <QMutexLocker>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+std::atomic<bool> StageCounters::enabled(false);
+
+static qint64 nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+namespace {
+
+const int StageCount = int(ClickStage::Count);
+
+// Written only by the owning thread; a line each so threads never share one
+struct alignas(64) StageSlot {
+    std::atomic<quint64> count{0};
+    std::atomic<quint64> ticks{0};
+    std::atomic<quint64> maxTicks{0};
+};
+
+struct ThreadStages {
+    StageSlot perStage[StageCount];
+    std::atomic<bool> owned{false};
+};
+
+// Blocks outlive their threads and are handed to the next thread, so the
+// totals of threads that have exited stay in the report
+struct StageRegistry {
+    QMutex mutex;
+    std::vector<std::unique_ptr<ThreadStages>> threads;
+
+    // Tick rate, measured between enabling and the report
+    std::atomic<quint64> startTicks{0};
+    std::atomic<qint64> startNs{0};
+};
+
+StageRegistry &registry()
+{
+    static StageRegistry instance;
+    return instance;
+}
+
+struct StagesHolder {
+    ThreadStages *stages = nullptr;
+
+    ~StagesHolder()
+    {
+        if (stages) stages->owned.store(false, std::memory_order_release);
+    }
+};
+
+thread_local StagesHolder threadStages;
+
+ThreadStages *acquireStages()
+{
+    if (threadStages.stages) return threadStages.stages;
+
+    StageRegistry &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    for (const auto &candidate : reg.threads) {
+        bool expected = false;
+        if (candidate->owned.compare_exchange_strong(expected, true)) {
+            threadStages.stages = candidate.get();
+            return threadStages.stages;
+        }
+    }
+    reg.threads.emplace_back(new ThreadStages);
+    threadStages.stages = reg.threads.back().get();
+    threadStages.stages->owned.store(true);
+    return threadStages.stages;
+}
+
+double nsPerTick()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    const StageRegistry &reg = registry();
+    const quint64 ticks = StageCounters::ticks() - reg.startTicks.load();
+    const qint64 ns = nowNs() - reg.startNs.load();
+    return ticks > 0 && ns > 0 ? double(ns) / double(ticks) : 0.0;
+#else
+    return 1.0;
+#endif
+}
+
+} // namespace
+
+void StageCounters::setEnabled(bool enable)
+{
+    StageRegistry &reg = registry();
+    if (enable && !enabled.load()) {
+        reg.startTicks.store(ticks());
+        reg.startNs.store(nowNs());
+    }
+    enabled.store(enable);
+}
+
+// Counters are zeroed from another thread; an increment racing with it may be lost
+void StageCounters::reset()
+{
+    StageRegistry &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    for (const auto &thread : reg.threads) {
+        for (StageSlot &slot : thread->perStage) {
+            slot.count.store(0, std::memory_order_relaxed);
+            slot.ticks.store(0, std::memory_order_relaxed);
+            slot.maxTicks.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void StageCounters::add(ClickStage stage, quint64 elapsedTicks)
+{
+    // Single writer per slot: plain load and store, no locked instructions
+    StageSlot &slot = acquireStages()->perStage[int(stage)];
+    slot.count.store(slot.count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    slot.ticks.store(slot.ticks.load(std::memory_order_relaxed) + elapsedTicks, std::memory_order_relaxed);
+    if (elapsedTicks > slot.maxTicks.load(std::memory_order_relaxed)) {
+        slot.maxTicks.store(elapsedTicks, std::memory_order_relaxed);
+    }
+}
+
+const char *StageCounters::stageName(ClickStage stage)
+{
+    switch (stage) {
+        case ClickStage::Click:
+            return "click";
+        case ClickStage::Press:
+            return "press";
+        case ClickStage::Release:
+            return "release";
+        case ClickStage::Keys:
+            return "keys";
+        case ClickStage::Motion:
+            return "motion";
+        case ClickStage::Position:
+            return "position";
+        case ClickStage::Lock:
+            return "lock";
+        case ClickStage::Warp:
+            return "warp";
+        case ClickStage::Button:
+            return "button";
+        case ClickStage::Flush:
+            return "flush";
+        case ClickStage::Sync:
+            return "sync";
+        default:
+            return "?";
+    }
+}
+
+QVector<StageCounters::Stats> StageCounters::stats()
+{
+    const double scale = nsPerTick();
+
+    quint64 count[StageCount] = {};
+    quint64 totalTicks[StageCount] = {};
+    quint64 maxTicks[StageCount] = {};
+    {
+        StageRegistry &reg = registry();
+        QMutexLocker locker(&reg.mutex);
+        for (const auto &thread : reg.threads) {
+            for (int i = 0; i < StageCount; ++i) {
+                const StageSlot &slot = thread->perStage[i];
+                count[i] += slot.count.load(std::memory_order_relaxed);
+                totalTicks[i] += slot.ticks.load(std::memory_order_relaxed);
+                maxTicks[i] = qMax(maxTicks[i], slot.maxTicks.load(std::memory_order_relaxed));
+            }
+        }
+    }
+
+    QVector<Stats> result;
+    for (int i = 0; i < StageCount; ++i) {
+        if (!count[i]) continue;
+        Stats entry;
+        entry.stage = ClickStage(i);
+        entry.count = count[i];
+        entry.meanNs = totalTicks[i] * scale / count[i];
+        entry.maxNs = maxTicks[i] * scale;
+        entry.totalMs = totalTicks[i] * scale / 1e6;
+        result.append(entry);
+    }
+    return result;
+}
+
+QString StageCounters::report()
+{
+    const QVector<Stats> entries = stats();
+    if (entries.isEmpty()) return QString("stages: no samples");
+
+    QString text = QString("%1 %2 %3 %4 %5")
+                       .arg(QString("stage"), -10).arg(QString("count"), 12).arg(QString("mean_ns"), 10)
+                       .arg(QString("max_ns"), 12).arg(QString("total_ms"), 10);
+    for (const Stats &entry : entries) {
+        text += QString("\n%1 %2 %3 %4 %5")
+                    .arg(QString(stageName(entry.stage)), -10).arg(entry.count, 12)
+                    .arg(entry.meanNs, 10, 'f', 0).arg(entry.maxNs, 12, 'f', 0)
+                    .arg(entry.totalMs, 10, 'f', 1);
+    }
+    return text;
+}
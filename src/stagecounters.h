@@ -0,0 +1,108 @@
+#ifndef STAGECOUNTERS_H
+#define STAGECOUNTERS_H
+
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+#include <atomic>
+#include "clicktrace.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#elif !defined(Q_OS_WIN) && !defined(Q_OS_MAC)
+#include <time.h>
+#else
+#include <chrono>
+#endif
+
+// Stages of one injection in ClickerThread
+enum class ClickStage {
+    Click,    // Whole performClick()/performClickAt()
+    Press,    // Whole press or release of a timed click
+    Release,
+    Keys,     // Whole key action
+    Motion,   // Whole batch of pointer motion
+    Position, // Pointer query
+    Lock,     // Waiting for the display connection
+    Warp,
+    Button,   // Queuing the XTest button events
+    Flush,    // Writing the requests to the server
+    Sync,     // Round trip to the server
+    Count
+};
+
+// Aggregate time per click stage: count, mean and max. Each thread adds to
+// its own cache-line-aligned slots, so counting is a TSC read and a few
+// uncontended stores; the report sums the threads. Off until enabled.
+class StageCounters
+{
+public:
+    struct Stats {
+        ClickStage stage = ClickStage::Click;
+        quint64 count = 0;
+        double meanNs = 0.0;
+        double maxNs = 0.0;
+        double totalMs = 0.0;
+    };
+
+    static void setEnabled(bool enable);
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+    static void reset();
+
+    static const char *stageName(ClickStage stage);
+    static QVector<Stats> stats();
+    static QString report(); // One line per stage that has run
+
+    // TSC where available, CLOCK_MONOTONIC_RAW otherwise; converted at report time
+    static quint64 ticks()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#elif !defined(Q_OS_WIN) && !defined(Q_OS_MAC)
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+        return quint64(ts.tv_sec) * 1000000000u + quint64(ts.tv_nsec);
+#else
+        return quint64(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+    static void add(ClickStage stage, quint64 elapsedTicks);
+
+private:
+    static std::atomic<bool> enabled;
+};
+
+// Counts and traces one stage for the enclosing scope, or until finish()
+class StageScope
+{
+public:
+    explicit StageScope(ClickStage stage)
+        : stage(stage)
+        , counting(StageCounters::isEnabled())
+        , tracing(ClickTrace::isEnabled())
+        , started(counting ? StageCounters::ticks() : 0)
+    {
+        if (tracing) ClickTrace::begin(StageCounters::stageName(stage));
+    }
+
+    ~StageScope()
+    {
+        finish();
+    }
+
+    void finish()
+    {
+        if (counting) StageCounters::add(stage, StageCounters::ticks() - started);
+        if (tracing) ClickTrace::end(StageCounters::stageName(stage));
+        counting = tracing = false;
+    }
+
+private:
+    ClickStage stage;
+    bool counting;
+    bool tracing;
+    quint64 started;
+};
+
+#endif // STAGECOUNTERS_H
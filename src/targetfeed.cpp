@@ -0,0 +1,178 @@
+#include "targetfeed.h"
+#include <QDebug>
+#include <QFile>
+
+#if !defined(Q_OS_WIN) && !defined(Q_OS_MAC)
+#include "gertfeed.h"
+#include <errno.h>
+#include <signal.h>
+#endif
+
+TargetFeed::TargetFeed()
+    : ring(nullptr)
+{
+}
+
+TargetFeed::~TargetFeed()
+{
+    close();
+}
+
+bool TargetFeed::isOpen() const
+{
+    return ring != nullptr;
+}
+
+QString TargetFeed::name() const
+{
+    return shmName;
+}
+
+#if !defined(Q_OS_WIN) && !defined(Q_OS_MAC)
+bool TargetFeed::create(const QString &name)
+{
+    close();
+
+    const QByteArray encoded = QFile::encodeName(name.isEmpty() ? QString(GERT_FEED_DEFAULT_NAME) : name);
+    ring = gert_feed_map(encoded.constData(), 1);
+    if (!ring && errno == EEXIST) {
+        // Replaced only if the consumer that created it is gone
+        gert_feed_ring *existing = gert_feed_attach(encoded.constData());
+        const pid_t pid = existing ? pid_t(existing->consumer_pid) : 0;
+        gert_feed_detach(existing);
+        if (pid > 0 && (kill(pid, 0) == 0 || errno == EPERM)) {
+            qWarning() << "TargetFeed:" << encoded << "is in use by process" << pid;
+            return false;
+        }
+        shm_unlink(encoded.constData());
+        ring = gert_feed_map(encoded.constData(), 1);
+    }
+    if (!ring) {
+        qWarning() << "TargetFeed: cannot create shared memory" << encoded;
+        return false;
+    }
+
+    shmName = QFile::decodeName(encoded);
+    return true;
+}
+
+void TargetFeed::close()
+{
+    if (!ring) return;
+
+    munmap(ring, sizeof(gert_feed_ring));
+    shm_unlink(QFile::encodeName(shmName).constData());
+    ring = nullptr;
+    shmName.clear();
+}
+
+bool TargetFeed::isEmpty() const
+{
+    return __atomic_load_n(&ring->head, __ATOMIC_SEQ_CST) == ring->tail;
+}
+
+bool TargetFeed::wait(int timeoutMs)
+{
+    if (!ring) return false;
+    if (!isEmpty()) return true;
+
+    // Read the doorbell before announcing sleep: a push after this point
+    // changes it, so FUTEX_WAIT returns at once instead of missing the wake
+    const uint32_t seen = __atomic_load_n(&ring->doorbell, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&ring->sleeping, 1, __ATOMIC_SEQ_CST);
+
+    if (isEmpty()) {
+        timespec timeout;
+        timeout.tv_sec = timeoutMs / 1000;
+        timeout.tv_nsec = (timeoutMs % 1000) * 1000000L;
+        syscall(SYS_futex, &ring->doorbell, FUTEX_WAIT, seen, &timeout, nullptr, 0);
+    }
+
+    __atomic_store_n(&ring->sleeping, 0, __ATOMIC_RELAXED);
+    return !isEmpty();
+}
+
+const gert_feed_record *TargetFeed::peek() const
+{
+    if (!ring || isEmpty()) return nullptr;
+    return &ring->records[ring->tail & (GERT_FEED_CAPACITY - 1)];
+}
+
+void TargetFeed::release()
+{
+    __atomic_fetch_add(&ring->tail, 1, __ATOMIC_RELEASE);
+}
+
+void TargetFeed::discard()
+{
+    if (!ring) return;
+    __atomic_store_n(&ring->tail, __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+}
+
+// Statistics live in the shared header so producers and benchmarks can read them
+void TargetFeed::recordClick(quint64 latencyNs)
+{
+    __atomic_store_n(&ring->clicked, ring->clicked + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&ring->latency_total_ns, ring->latency_total_ns + latencyNs, __ATOMIC_RELAXED);
+    if (latencyNs > ring->latency_max_ns) {
+        __atomic_store_n(&ring->latency_max_ns, latencyNs, __ATOMIC_RELAXED);
+    }
+}
+
+void TargetFeed::recordExpired()
+{
+    __atomic_store_n(&ring->expired, ring->expired + 1, __ATOMIC_RELAXED);
+}
+
+quint64 TargetFeed::clickCount() const
+{
+    return ring ? __atomic_load_n(&ring->clicked, __ATOMIC_RELAXED) : 0;
+}
+
+quint64 TargetFeed::queuedCount() const
+{
+    return ring ? __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - ring->tail : 0;
+}
+
+quint64 TargetFeed::expiredCount() const
+{
+    return ring ? __atomic_load_n(&ring->expired, __ATOMIC_RELAXED) : 0;
+}
+
+quint64 TargetFeed::droppedCount() const
+{
+    return ring ? __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED) : 0;
+}
+
+double TargetFeed::meanLatencyUs() const
+{
+    const quint64 clicks = clickCount();
+    return clicks ? __atomic_load_n(&ring->latency_total_ns, __ATOMIC_RELAXED) / 1000.0 / clicks : 0.0;
+}
+
+double TargetFeed::maxLatencyUs() const
+{
+    return ring ? __atomic_load_n(&ring->latency_max_ns, __ATOMIC_RELAXED) / 1000.0 : 0.0;
+}
+#else
+bool TargetFeed::create(const QString &)
+{
+    qWarning() << "TargetFeed: the shared-memory feed is only supported on Linux";
+    return false;
+}
+
+void TargetFeed::close() {}
+bool TargetFeed::isEmpty() const { return true; }
+bool TargetFeed::wait(int) { return false; }
+const gert_feed_record *TargetFeed::peek() const { return nullptr; }
+void TargetFeed::release() {}
+void TargetFeed::discard() {}
+void TargetFeed::recordClick(quint64) {}
+void TargetFeed::recordExpired() {}
+quint64 TargetFeed::clickCount() const { return 0; }
+quint64 TargetFeed::expiredCount() const { return 0; }
+quint64 TargetFeed::droppedCount() const { return 0; }
+quint64 TargetFeed::queuedCount() const { return 0; }
+double TargetFeed::meanLatencyUs() const { return 0.0; }
+double TargetFeed::maxLatencyUs() const { return 0.0; }
+#endif
@@ -0,0 +1,51 @@
+#ifndef TARGETFEED_H
+#define TARGETFEED_H
+
+#include <QString>
+#include <QtGlobal>
+
+struct gert_feed_ring;
+struct gert_feed_record;
+
+// Consumer side of the shared-memory target feed (see gertfeed.h). Owns the
+// POSIX shm ring that external producers attach to. Records are read in
+// place: peek() returns a pointer into the ring that stays valid until
+// release().
+class TargetFeed
+{
+public:
+    TargetFeed();
+    ~TargetFeed();
+
+    bool create(const QString &name); // Fails if another live consumer owns the name
+    void close();
+    bool isOpen() const;
+    QString name() const;
+
+    // Blocks on the futex doorbell until a record is available or the
+    // timeout passes; returns true if the ring is not empty
+    bool wait(int timeoutMs);
+
+    const gert_feed_record *peek() const;
+    void release();
+    void discard(); // Drops everything queued, e.g. records pushed while stopped; not while peeking
+
+    void recordClick(quint64 latencyNs);
+    void recordExpired();
+
+    // Producer write to injected click
+    quint64 clickCount() const;
+    quint64 expiredCount() const;
+    quint64 droppedCount() const;
+    quint64 queuedCount() const; // Consumer side only: reads its own tail
+    double meanLatencyUs() const;
+    double maxLatencyUs() const;
+
+private:
+    bool isEmpty() const;
+
+    gert_feed_ring *ring;
+    QString shmName;
+};
+
+#endif // TARGETFEED_H
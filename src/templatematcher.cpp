@@ -0,0 +1,559 @@
+#include "templatematcher.h"
+#include "templatematcher_p.h"
+#include <QFile>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+#include <cctype>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+GrayImage GrayImage::create(int width, int height)
+{
+    GrayImage image;
+    image.width = width;
+    image.height = height;
+    image.stride = (width + 15) & ~15;
+    image.pixels.resize(image.stride * height + 16);
+    return image;
+}
+
+GrayImage GrayImage::fromBgra(const quint32 *data, int width, int height, int strideBytes)
+{
+    GrayImage image = create(width, height);
+
+    for (int y = 0; y < height; ++y) {
+        quint8 *out = image.pixels.data() + y * image.stride;
+        const quint32 *row = reinterpret_cast<const quint32 *>(
+            reinterpret_cast<const char *>(data) + y * strideBytes);
+        for (int x = 0; x < width; ++x) {
+            const quint32 p = row[x];
+            // Integer BT.601 luma
+            *out++ = static_cast<quint8>((((p >> 16) & 0xFF) * 77 + ((p >> 8) & 0xFF) * 150 + (p & 0xFF) * 29) >> 8);
+        }
+    }
+    return image;
+}
+
+GrayImage GrayImage::load(const QString &path, QString *error)
+{
+    auto fail = [error](const QString &message) {
+        if (error) *error = message;
+        return GrayImage();
+    };
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return fail("cannot open " + path);
+    const QByteArray data = file.readAll();
+
+    // Header: magic, width, height and maxval, separated by whitespace and
+    // comments, then one whitespace byte before the samples
+    int offset = 0;
+    auto token = [&data, &offset]() {
+        for (;;) {
+            while (offset < data.size() && std::isspace(uchar(data[offset]))) ++offset;
+            if (offset >= data.size() || data[offset] != '#') break;
+            while (offset < data.size() && data[offset] != '\n') ++offset;
+        }
+        const int start = offset;
+        while (offset < data.size() && !std::isspace(uchar(data[offset]))) ++offset;
+        return data.mid(start, offset - start);
+    };
+
+    const QByteArray magic = token();
+    if (magic != "P5" && magic != "P6") return fail(path + " is not a binary PGM or PPM image");
+    const int channels = magic == "P6" ? 3 : 1;
+    bool okWidth = false, okHeight = false, okMax = false;
+    const int width = token().toInt(&okWidth);
+    const int height = token().toInt(&okHeight);
+    const int maxValue = token().toInt(&okMax);
+    if (!okWidth || !okHeight || !okMax || width <= 0 || height <= 0 || width > 8192 || height > 8192 ||
+        maxValue <= 0 || maxValue > 255) {
+        return fail(path + " has an unsupported header");
+    }
+    ++offset;
+    if (data.size() - offset < qint64(width) * height * channels) return fail(path + " is truncated");
+
+    GrayImage image = create(width, height);
+    const uchar *in = reinterpret_cast<const uchar *>(data.constData()) + offset;
+    for (int y = 0; y < height; ++y) {
+        quint8 *out = image.pixels.data() + y * image.stride;
+        for (int x = 0; x < width; ++x, in += channels) {
+            // Integer BT.601 luma, as fromBgra(), over samples scaled to 255
+            const int luma = channels == 1 ? in[0] : (in[0] * 77 + in[1] * 150 + in[2] * 29) >> 8;
+            *out++ = static_cast<quint8>(qMin(255, luma * 255 / maxValue));
+        }
+    }
+    return image;
+}
+
+void searchStripeScalar(StripeJob *job)
+{
+    searchStripeWith<candidateSadScalar>(job);
+}
+
+#if defined(__SSE2__) || defined(_M_X64)
+namespace {
+
+inline quint64 horizontalSum(__m128i acc)
+{
+    return static_cast<quint64>(_mm_cvtsi128_si64(acc)) +
+           static_cast<quint64>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(acc, acc)));
+}
+
+inline quint64 candidateSadSse2(const quint8 *image, int stride, const PreparedTemplate &templ, quint64 bound)
+{
+    __m128i acc = _mm_setzero_si128();
+    const int width = templ.paddedWidth;
+
+    for (int r = 0; r < templ.height; ++r) {
+        const quint8 *a = image + r * stride;
+        const quint8 *b = templ.pixels + r * width;
+        for (int x = 0; x < width; x += 16) {
+            const __m128i va = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + x)),
+                                             _mm_loadu_si128(reinterpret_cast<const __m128i *>(templ.mask + x)));
+            const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + x));
+            acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+        }
+
+        const quint64 sad = horizontalSum(acc);
+        if (sad > bound) return sad;
+    }
+    return horizontalSum(acc);
+}
+
+} // namespace
+
+void searchStripeSse2(StripeJob *job)
+{
+    searchStripeWith<candidateSadSse2>(job);
+}
+#endif
+
+static bool cpuHasAvx2()
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    return __builtin_cpu_supports("avx2");
+#elif defined(_MSC_VER) && defined(_M_X64)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return false;
+#endif
+}
+
+struct Kernel {
+    StripeSearchFn search;
+    const char *name;
+};
+
+static Kernel selectKernel()
+{
+#ifdef GERT_AVX2_KERNEL
+    if (cpuHasAvx2()) return { searchStripeAvx2, "avx2" };
+#else
+    (void)cpuHasAvx2;
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+    return { searchStripeSse2, "sse2" };
+#else
+    return { searchStripeScalar, "scalar" };
+#endif
+}
+
+static const Kernel &kernel()
+{
+    static const Kernel selected = selectKernel();
+    return selected;
+}
+
+// Threads for stripe and tile searches, created once: a search per damage
+// event would otherwise pay for starting and joining its threads every time
+static QThreadPool &searchPool()
+{
+    static QThreadPool pool;
+    static const bool configured = [] {
+        pool.setMaxThreadCount(QThread::idealThreadCount());
+        pool.setExpiryTimeout(-1);
+        return true;
+    }();
+    (void)configured;
+    return pool;
+}
+
+// Runs task(0) .. task(count - 1), the first on the calling thread and the
+// rest on the pool, and returns when all are done. Tasks never wait on the
+// pool themselves, so a busy pool only delays them.
+static void runParallel(int count, const std::function<void(int)> &task)
+{
+    QSemaphore done;
+    for (int i = 1; i < count; ++i) {
+        searchPool().start([&task, &done, i]() {
+            task(i);
+            done.release();
+        });
+    }
+    task(0);
+    done.acquire(count - 1);
+}
+
+TemplateMatcher::TemplateMatcher()
+    : paddedWidth(0)
+    , threshold(16)
+    , threadCount(QThread::idealThreadCount())
+{
+}
+
+void TemplateMatcher::setTemplate(const GrayImage &image)
+{
+    templ = image;
+
+    paddedWidth = (image.width + 15) & ~15;
+    paddedPixels = QVector<quint8>(paddedWidth * image.height, 0);
+    paddedMask = QVector<quint8>(paddedWidth, 0);
+
+    for (int y = 0; y < image.height; ++y) {
+        const quint8 *src = image.row(y);
+        for (int x = 0; x < image.width; ++x) {
+            paddedPixels[y * paddedWidth + x] = src[x];
+        }
+    }
+    for (int x = 0; x < image.width; ++x) {
+        paddedMask[x] = 0xFF;
+    }
+}
+
+const GrayImage &TemplateMatcher::templateImage() const
+{
+    return templ;
+}
+
+void TemplateMatcher::setThreshold(int meanDifference)
+{
+    threshold = qBound(0, meanDifference, 255);
+}
+
+void TemplateMatcher::setThreadCount(int threads)
+{
+    threadCount = qMax(1, threads);
+}
+
+const char *TemplateMatcher::kernelName()
+{
+    return kernel().name;
+}
+
+TemplateMatcher::Match TemplateMatcher::find(const GrayImage &image) const
+{
+    return findInRange(image, 0, 0, image.width - templ.width, image.height - templ.height);
+}
+
+TemplateMatcher::Match TemplateMatcher::findInRange(const GrayImage &image, int x0, int y0, int x1, int y1) const
+{
+    Match match;
+    if (templ.isEmpty() || image.width < templ.width || image.height < templ.height) return match;
+
+    // The vector kernels read up to 15 bytes past each template row
+    if (!image.hasReadSlack()) {
+        GrayImage copy = GrayImage::create(image.width, image.height);
+        for (int y = 0; y < image.height; ++y) {
+            const quint8 *src = image.row(y);
+            quint8 *dst = copy.pixels.data() + y * copy.stride;
+            for (int x = 0; x < image.width; ++x) dst[x] = src[x];
+        }
+        return findInRange(copy, x0, y0, x1, y1);
+    }
+
+    x0 = qMax(0, x0);
+    y0 = qMax(0, y0);
+    x1 = qMin(x1, image.width - templ.width);
+    y1 = qMin(y1, image.height - templ.height);
+    if (x0 > x1 || y0 > y1) return match;
+
+    const quint64 limit = static_cast<quint64>(threshold) * templ.width * templ.height;
+    std::atomic<quint64> sharedBest(limit);
+
+    PreparedTemplate prepared;
+    prepared.pixels = paddedPixels.constData();
+    prepared.mask = paddedMask.constData();
+    prepared.width = templ.width;
+    prepared.paddedWidth = paddedWidth;
+    prepared.height = templ.height;
+
+    // Small ranges (local refinement) are not worth a thread hand-off
+    const int rows = y1 - y0 + 1;
+    const int stripes = qBound(1, qMin(threadCount, rows / 16), rows);
+
+    std::vector<StripeJob> jobs(stripes);
+    for (int i = 0; i < stripes; ++i) {
+        StripeJob &job = jobs[i];
+        job.image = &image;
+        job.templ = &prepared;
+        job.x0 = x0;
+        job.x1 = x1;
+        job.y0 = y0 + rows * i / stripes;
+        job.y1 = y0 + rows * (i + 1) / stripes - 1;
+        job.limit = limit;
+        job.sharedBest = &sharedBest;
+    }
+
+    const StripeSearchFn search = kernel().search;
+    runParallel(stripes, [&jobs, search](int i) { search(&jobs[i]); });
+
+    for (const StripeJob &job : jobs) {
+        if (job.bestX >= 0 && job.bestSad <= limit && (!match.found || job.bestSad < match.sad)) {
+            match.found = true;
+            match.sad = job.bestSad;
+            match.position = QPoint(job.bestX, job.bestY);
+        }
+    }
+
+    if (match.found) {
+        match.center = match.position + QPoint(templ.width / 2, templ.height / 2);
+    }
+    return match;
+}
+
+GrayImage GrayImage::downsample4(const GrayImage &source)
+{
+    GrayImage image = create(source.width / 4, source.height / 4);
+
+    for (int y = 0; y < image.height; ++y) {
+        quint8 *out = image.pixels.data() + y * image.stride;
+        const quint8 *r0 = source.row(y * 4);
+        const quint8 *r1 = source.row(y * 4 + 1);
+        const quint8 *r2 = source.row(y * 4 + 2);
+        const quint8 *r3 = source.row(y * 4 + 3);
+        for (int x = 0; x < image.width; ++x) {
+            const int sx = x * 4;
+            int sum = 8; // Rounds the average
+            for (int i = 0; i < 4; ++i) {
+                sum += r0[sx + i] + r1[sx + i] + r2[sx + i] + r3[sx + i];
+            }
+            out[x] = static_cast<quint8>(sum >> 4);
+        }
+    }
+    return image;
+}
+
+// Candidate positions per tile side; also the block size used for hashing
+static const int kTileSize = 64;
+
+// Coarse positions are 4 pixels apart, so refine one coarse step around the
+// candidate in every direction
+static const int kRefineRadius = 4;
+
+// Fast non-cryptographic 64-bit hash of a pixel block, 8 bytes at a time
+static quint64 hashBlock(const GrayImage &image, int x0, int y0, int width, int height)
+{
+    quint64 hash = 0x9E3779B97F4A7C15ull ^ static_cast<quint64>(width * 131 + height);
+
+    for (int y = y0; y < y0 + height; ++y) {
+        const quint8 *row = image.row(y) + x0;
+        int x = 0;
+        for (; x + 8 <= width; x += 8) {
+            quint64 word;
+            memcpy(&word, row + x, sizeof(word));
+            hash = (hash ^ word) * 0xFF51AFD7ED558CCDull;
+            hash ^= hash >> 29;
+        }
+        for (; x < width; ++x) {
+            hash = (hash ^ row[x]) * 0xC4CEB9FE1A85EC53ull;
+        }
+    }
+    return hash;
+}
+
+PyramidMatcher::PyramidMatcher()
+    : useCoarse(false)
+    , threshold(16)
+    , threadCount(QThread::idealThreadCount())
+    , imageWidth(0)
+    , imageHeight(0)
+    , blocksX(0)
+    , blocksY(0)
+    , searched(0)
+    , reused(0)
+{
+    // Parallelism comes from searching tiles concurrently
+    fine.setThreadCount(1);
+    coarse.setThreadCount(1);
+}
+
+void PyramidMatcher::setTemplate(const GrayImage &templ)
+{
+    fine.setTemplate(templ);
+
+    // Below 16 pixels the 1/4 scale template carries too little detail
+    useCoarse = templ.width >= 16 && templ.height >= 16;
+    if (useCoarse) {
+        coarse.setTemplate(GrayImage::downsample4(templ));
+    }
+    invalidate();
+}
+
+void PyramidMatcher::setThreshold(int meanDifference)
+{
+    threshold = meanDifference;
+    fine.setThreshold(meanDifference);
+    // A match off the 4-pixel grid blurs edges into the coarse averages,
+    // so candidates are let through generously and settled by the refine
+    coarse.setThreshold(qMin(255, meanDifference * 2 + 32));
+    invalidate();
+}
+
+void PyramidMatcher::setThreadCount(int threads)
+{
+    threadCount = qMax(1, threads);
+}
+
+void PyramidMatcher::invalidate()
+{
+    imageWidth = 0;
+    imageHeight = 0;
+    blockHashes.clear();
+    tiles.clear();
+}
+
+quint64 PyramidMatcher::tilesSearched() const
+{
+    return searched;
+}
+
+quint64 PyramidMatcher::tilesReused() const
+{
+    return reused;
+}
+
+void PyramidMatcher::hashBlocks(const GrayImage &image)
+{
+    const bool fresh = blockHashes.size() != blocksX * blocksY;
+    if (fresh) {
+        blockHashes = QVector<quint64>(blocksX * blocksY, 0);
+    }
+    blockChanged = QVector<quint8>(blocksX * blocksY, 1);
+
+    for (int by = 0; by < blocksY; ++by) {
+        const int y0 = by * kTileSize;
+        const int height = qMin(kTileSize, image.height - y0);
+        for (int bx = 0; bx < blocksX; ++bx) {
+            const int x0 = bx * kTileSize;
+            const int index = by * blocksX + bx;
+            const quint64 hash = hashBlock(image, x0, y0, qMin(kTileSize, image.width - x0), height);
+            blockChanged[index] = fresh || hash != blockHashes[index];
+            blockHashes[index] = hash;
+        }
+    }
+}
+
+TemplateMatcher::Match PyramidMatcher::searchTile(const GrayImage &image, const GrayImage &coarseImage,
+                                                  int x0, int y0, int x1, int y1) const
+{
+    if (!useCoarse) {
+        return fine.findInRange(image, x0, y0, x1, y1);
+    }
+
+    // Both stages may look a little past the tile edge so a target sitting
+    // on a tile boundary is still found by one of its neighbours
+    const TemplateMatcher::Match hint = coarse.findInRange(coarseImage, x0 / 4 - 1, y0 / 4 - 1, x1 / 4 + 1, y1 / 4 + 1);
+    if (!hint.found) return TemplateMatcher::Match();
+
+    const int cx = hint.position.x() * 4;
+    const int cy = hint.position.y() * 4;
+    return fine.findInRange(image, cx - kRefineRadius, cy - kRefineRadius, cx + kRefineRadius, cy + kRefineRadius);
+}
+
+TemplateMatcher::Match PyramidMatcher::find(const GrayImage &image)
+{
+    const GrayImage &templ = fine.templateImage();
+    TemplateMatcher::Match best;
+    if (templ.isEmpty() || image.width < templ.width || image.height < templ.height) return best;
+
+    if (image.width != imageWidth || image.height != imageHeight) {
+        invalidate();
+        imageWidth = image.width;
+        imageHeight = image.height;
+        blocksX = (image.width + kTileSize - 1) / kTileSize;
+        blocksY = (image.height + kTileSize - 1) / kTileSize;
+    }
+
+    hashBlocks(image);
+
+    // Tiles cover candidate top-left positions only
+    const int lastX = image.width - templ.width;
+    const int lastY = image.height - templ.height;
+    const int tilesX = lastX / kTileSize + 1;
+    const int tilesY = lastY / kTileSize + 1;
+    if (tiles.size() != tilesX * tilesY) {
+        tiles = QVector<TileResult>(tilesX * tilesY);
+    }
+
+    // A tile depends on its own block, the blocks the template reaches into
+    // and the margin the coarse and refine stages look past its edges
+    const int margin = useCoarse ? 4 + kRefineRadius : 0;
+    const int reachBack = (margin + kTileSize - 1) / kTileSize;
+    const int reachX = (templ.width - 1 + margin + kTileSize - 1) / kTileSize;
+    const int reachY = (templ.height - 1 + margin + kTileSize - 1) / kTileSize;
+
+    std::vector<int> dirty;
+    for (int ty = 0; ty < tilesY; ++ty) {
+        for (int tx = 0; tx < tilesX; ++tx) {
+            const int index = ty * tilesX + tx;
+            bool changed = !tiles[index].valid;
+            for (int by = qMax(0, ty - reachBack); !changed && by <= qMin(blocksY - 1, ty + reachY); ++by) {
+                for (int bx = qMax(0, tx - reachBack); bx <= qMin(blocksX - 1, tx + reachX); ++bx) {
+                    if (blockChanged[by * blocksX + bx]) {
+                        changed = true;
+                        break;
+                    }
+                }
+            }
+            if (changed) {
+                dirty.push_back(index);
+            }
+        }
+    }
+
+    searched += dirty.size();
+    reused += tiles.size() - dirty.size();
+
+    if (!dirty.empty()) {
+        const GrayImage coarseImage = useCoarse ? GrayImage::downsample4(image) : GrayImage();
+
+        // Detach once here: the workers write through the raw pointer, since
+        // the non-const operator[] would run the detach check concurrently
+        TileResult *results = tiles.data();
+        std::atomic<int> next(0);
+        auto worker = [&](int) {
+            for (int i = next.fetch_add(1); i < static_cast<int>(dirty.size()); i = next.fetch_add(1)) {
+                const int index = dirty[i];
+                const int x0 = (index % tilesX) * kTileSize;
+                const int y0 = (index / tilesX) * kTileSize;
+                results[index].match = searchTile(image, coarseImage, x0, y0,
+                                                  qMin(lastX, x0 + kTileSize - 1), qMin(lastY, y0 + kTileSize - 1));
+                results[index].valid = true;
+            }
+        };
+
+        runParallel(qMin(threadCount, static_cast<int>(dirty.size())), worker);
+    }
+
+    for (const TileResult &tile : tiles) {
+        if (tile.match.found && (!best.found || tile.match.sad < best.sad)) {
+            best = tile.match;
+        }
+    }
+    return best;
+}
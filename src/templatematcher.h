@@ -0,0 +1,119 @@
+#ifndef TEMPLATEMATCHER_H
+#define TEMPLATEMATCHER_H
+
+#include <QPoint>
+#include <QString>
+#include <QVector>
+
+// 8-bit luma image; rows are stride bytes apart. Images made by create()
+// keep 16 readable bytes past the last row so SIMD loads need no tail.
+struct GrayImage {
+    int width = 0;
+    int height = 0;
+    int stride = 0;
+    QVector<quint8> pixels;
+
+    bool isEmpty() const { return width <= 0 || height <= 0; }
+    const quint8 *row(int y) const { return pixels.constData() + y * stride; }
+
+    bool hasReadSlack() const { return pixels.size() >= (height - 1) * stride + width + 16; }
+
+    static GrayImage create(int width, int height);
+    static GrayImage downsample4(const GrayImage &source); // 4x4 box average
+    static GrayImage fromBgra(const quint32 *data, int width, int height, int strideBytes);
+
+    // Binary PGM (P5) or PPM (P6) with 8-bit samples, color reduced to luma;
+    // empty if the file cannot be read
+    static GrayImage load(const QString &path, QString *error = nullptr);
+};
+
+// Locates a small template inside a larger image by sum of absolute
+// differences. The kernel uses AVX2 or SSE2 when the CPU has them and a
+// scalar loop otherwise; the search is split into horizontal stripes that
+// run on separate cores.
+class TemplateMatcher
+{
+public:
+    struct Match {
+        bool found = false;
+        QPoint position;  // Top-left of the best match in image coordinates
+        QPoint center;    // Click point for the match
+        quint64 sad = 0;  // Sum of absolute differences of the best match
+    };
+
+    TemplateMatcher();
+
+    void setTemplate(const GrayImage &templ);
+    const GrayImage &templateImage() const;
+
+    // Largest mean per-pixel difference (0-255) still accepted as a match
+    void setThreshold(int meanDifference);
+    void setThreadCount(int threads);
+
+    Match find(const GrayImage &image) const;
+
+    // Searches only top-left positions inside the given rectangle
+    // (inclusive bounds); used to refine coarse candidates
+    Match findInRange(const GrayImage &image, int x0, int y0, int x1, int y1) const;
+
+    static const char *kernelName();
+
+private:
+    GrayImage templ;
+    QVector<quint8> paddedPixels;
+    QVector<quint8> paddedMask;
+    int paddedWidth;
+    int threshold;
+    int threadCount;
+};
+
+// Repeated searches over successive frames. Each frame is cut into tiles of
+// candidate positions; a tile whose pixels (including the area the template
+// overlaps past its edge) hash the same as last frame reuses its previous
+// result. Changed tiles are searched coarse-to-fine: at 1/4 scale first,
+// then refined at full resolution around the best coarse candidate, so a
+// tile reports at most one match.
+class PyramidMatcher
+{
+public:
+    PyramidMatcher();
+
+    void setTemplate(const GrayImage &templ);
+    void setThreshold(int meanDifference);
+    void setThreadCount(int threads);
+    void invalidate();
+
+    TemplateMatcher::Match find(const GrayImage &image);
+
+    quint64 tilesSearched() const;
+    quint64 tilesReused() const;
+
+private:
+    struct TileResult {
+        bool valid = false;
+        TemplateMatcher::Match match;
+    };
+
+    TemplateMatcher::Match searchTile(const GrayImage &image, const GrayImage &coarseImage,
+                                      int x0, int y0, int x1, int y1) const;
+    void hashBlocks(const GrayImage &image);
+
+    TemplateMatcher fine;
+    TemplateMatcher coarse;
+    bool useCoarse;
+    int threshold;
+    int threadCount;
+
+    int imageWidth;
+    int imageHeight;
+    int blocksX;
+    int blocksY;
+    QVector<quint64> blockHashes;
+    QVector<quint8> blockChanged;
+    QVector<TileResult> tiles;
+
+    quint64 searched;
+    quint64 reused;
+};
+
+#endif // TEMPLATEMATCHER_H
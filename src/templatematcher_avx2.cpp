@@ -0,0 +1,51 @@
+// AVX2 kernel for TemplateMatcher; built with AVX2 code generation enabled
+// and only called after a runtime CPU check.
+
+#include "templatematcher_p.h"
+
+#ifdef GERT_AVX2_KERNEL
+#include <immintrin.h>
+
+namespace {
+
+inline quint64 horizontalSum(__m256i acc)
+{
+    const __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    return static_cast<quint64>(_mm_cvtsi128_si64(sum)) + static_cast<quint64>(_mm_extract_epi64(sum, 1));
+}
+
+inline quint64 candidateSadAvx2(const quint8 *image, int stride, const PreparedTemplate &templ, quint64 bound)
+{
+    __m256i acc = _mm256_setzero_si256();
+    const int width = templ.paddedWidth;
+
+    for (int r = 0; r < templ.height; ++r) {
+        const quint8 *a = image + r * stride;
+        const quint8 *b = templ.pixels + r * width;
+        int x = 0;
+        for (; x + 32 <= width; x += 32) {
+            const __m256i va = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + x)),
+                                                _mm256_loadu_si256(reinterpret_cast<const __m256i *>(templ.mask + x)));
+            const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + x));
+            acc = _mm256_add_epi64(acc, _mm256_sad_epu8(va, vb));
+        }
+        if (x < width) {
+            const __m128i va = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + x)),
+                                             _mm_loadu_si128(reinterpret_cast<const __m128i *>(templ.mask + x)));
+            const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + x));
+            acc = _mm256_add_epi64(acc, _mm256_zextsi128_si256(_mm_sad_epu8(va, vb)));
+        }
+
+        const quint64 sad = horizontalSum(acc);
+        if (sad > bound) return sad;
+    }
+    return horizontalSum(acc);
+}
+
+} // namespace
+
+void searchStripeAvx2(StripeJob *job)
+{
+    searchStripeWith<candidateSadAvx2>(job);
+}
+#endif
@@ -0,0 +1,99 @@
+#ifndef TEMPLATEMATCHER_P_H
+#define TEMPLATEMATCHER_P_H
+
+// Internal to the template matcher. Each kernel translation unit includes
+// this with its own instruction-set flags, so everything here has internal
+// linkage and avoids out-of-line library helpers.
+
+#include "templatematcher.h"
+#include <atomic>
+
+// Template rows padded to a multiple of 16 bytes. The mask zeroes the image
+// bytes under the padding so full-width vector loads need no scalar tail.
+struct PreparedTemplate {
+    const quint8 *pixels;
+    const quint8 *mask;
+    int width;
+    int paddedWidth;
+    int height;
+};
+
+struct StripeJob {
+    const GrayImage *image;
+    const PreparedTemplate *templ;
+    int x0, x1;             // Inclusive top-left column range
+    int y0, y1;             // Inclusive top-left row range
+    quint64 limit;          // Positions scoring above this are rejected early
+    std::atomic<quint64> *sharedBest; // Best score across all stripes
+    quint64 bestSad;
+    int bestX, bestY;
+};
+
+typedef void (*StripeSearchFn)(StripeJob *job);
+
+void searchStripeScalar(StripeJob *job);
+#ifdef GERT_AVX2_KERNEL
+void searchStripeAvx2(StripeJob *job);
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+void searchStripeSse2(StripeJob *job);
+#endif
+
+namespace {
+
+typedef quint64 (*CandidateSadFn)(const quint8 *image, int stride, const PreparedTemplate &templ, quint64 bound);
+
+// Successive elimination: each kernel gives up on a candidate as soon as its
+// partial sum exceeds the best complete score seen so far.
+template <CandidateSadFn candidateSad>
+inline void searchStripeWith(StripeJob *job)
+{
+    const GrayImage &image = *job->image;
+    const PreparedTemplate &templ = *job->templ;
+
+    quint64 best = job->limit;
+    const quint64 shared = job->sharedBest->load(std::memory_order_relaxed);
+    if (shared < best) best = shared;
+
+    job->bestSad = ~0ull;
+    job->bestX = -1;
+    job->bestY = -1;
+
+    for (int y = job->y0; y <= job->y1; ++y) {
+        const quint8 *row = image.row(y);
+        for (int x = job->x0; x <= job->x1; ++x) {
+            const quint64 sad = candidateSad(row + x, image.stride, templ, best);
+            if (sad <= best && sad < job->bestSad) {
+                best = sad;
+                job->bestSad = sad;
+                job->bestX = x;
+                job->bestY = y;
+            }
+        }
+
+        // Tighten the bound with what the other stripes have found
+        quint64 current = job->sharedBest->load(std::memory_order_relaxed);
+        while (job->bestSad < current &&
+               !job->sharedBest->compare_exchange_weak(current, job->bestSad, std::memory_order_relaxed)) {
+        }
+        if (current < best) best = current;
+    }
+}
+
+inline quint64 candidateSadScalar(const quint8 *image, int stride, const PreparedTemplate &templ, quint64 bound)
+{
+    quint64 sad = 0;
+    for (int r = 0; r < templ.height; ++r) {
+        const quint8 *a = image + r * stride;
+        const quint8 *b = templ.pixels + r * templ.paddedWidth;
+        for (int x = 0; x < templ.width; ++x) {
+            sad += a[x] > b[x] ? a[x] - b[x] : b[x] - a[x];
+        }
+        if (sad > bound) break;
+    }
+    return sad;
+}
+
+} // namespace
+
+#endif // TEMPLATEMATCHER_P_H
@@ -0,0 +1,164 @@
+#include "timerwheel.h"
+#include <QtAlgorithms>
+#include <cstring>
+
+TimerWheel::TimerWheel(qint64 tick, qint64 startNs)
+    : tickNs(tick)
+    , originNs(startNs)
+    , currentTick(0)
+    , count(0)
+{
+    memset(buckets, 0, sizeof(buckets));
+    memset(occupied, 0, sizeof(occupied));
+}
+
+qint64 TimerWheel::tick() const
+{
+    return tickNs;
+}
+
+bool TimerWheel::isEmpty() const
+{
+    return count == 0;
+}
+
+void TimerWheel::insert(Entry *entry)
+{
+    // Round up so an entry never fires before it is due
+    const qint64 relative = entry->dueNs - originNs;
+    const quint64 tick = relative <= 0 ? 0 : quint64((relative + tickNs - 1) / tickNs);
+    entry->dueTick = qMax(tick, currentTick + 1);
+    place(entry);
+    ++count;
+}
+
+void TimerWheel::remove(Entry *entry)
+{
+    if (entry->level < 0) return;
+    unlink(entry);
+    --count;
+}
+
+void TimerWheel::place(Entry *entry)
+{
+    // Level l holds entries due within 256^(l+1) ticks, slotted by their
+    // l-th byte of the due tick
+    const quint64 delta = entry->dueTick - currentTick;
+    int level = 0;
+    while (level < Levels - 1 && delta >= (quint64(1) << (SlotBits * (level + 1)))) {
+        ++level;
+    }
+    if (level == Levels - 1 && delta >= (quint64(1) << (SlotBits * Levels))) {
+        // Beyond the wheel's range: park in the farthest slot and re-place on cascade
+        entry->dueTick = currentTick + (quint64(1) << (SlotBits * Levels)) - 1;
+    }
+
+    const int slot = int((entry->dueTick >> (SlotBits * level)) & (Slots - 1));
+    entry->level = level;
+    entry->slot = slot;
+    entry->prev = nullptr;
+    entry->next = buckets[level][slot];
+    if (entry->next) entry->next->prev = entry;
+    buckets[level][slot] = entry;
+    occupied[level][slot / 64] |= quint64(1) << (slot % 64);
+}
+
+void TimerWheel::unlink(Entry *entry)
+{
+    if (entry->prev) {
+        entry->prev->next = entry->next;
+    } else {
+        buckets[entry->level][entry->slot] = entry->next;
+    }
+    if (entry->next) entry->next->prev = entry->prev;
+    if (!buckets[entry->level][entry->slot]) {
+        occupied[entry->level][entry->slot / 64] &= ~(quint64(1) << (entry->slot % 64));
+    }
+    entry->level = -1;
+    entry->prev = entry->next = nullptr;
+}
+
+void TimerWheel::cascade(int level)
+{
+    // Entries in this slot are now within the range of the level below
+    const int slot = int((currentTick >> (SlotBits * level)) & (Slots - 1));
+    Entry *entry = buckets[level][slot];
+    buckets[level][slot] = nullptr;
+    occupied[level][slot / 64] &= ~(quint64(1) << (slot % 64));
+
+    while (entry) {
+        Entry *next = entry->next;
+        place(entry);
+        entry = next;
+    }
+}
+
+int TimerWheel::nextOccupied(int level, int from) const
+{
+    for (int word = from / 64; word < Slots / 64; ++word) {
+        quint64 bits = occupied[level][word];
+        if (word == from / 64) bits &= ~quint64(0) << (from % 64);
+        if (bits) return word * 64 + qCountTrailingZeroBits(bits);
+    }
+    return -1;
+}
+
+void TimerWheel::advance(qint64 nowNs, std::vector<Entry *> &expired)
+{
+    if (nowNs < originNs) return;
+    const quint64 target = quint64((nowNs - originNs) / tickNs);
+
+    while (currentTick < target) {
+        // Jump straight to the next occupied level-0 slot or the next
+        // rotation boundary, whichever comes first
+        const quint64 rotationEnd = (currentTick | (Slots - 1)) + 1;
+        const int from = int((currentTick + 1) & (Slots - 1));
+        const int slot = (currentTick + 1 == rotationEnd) ? -1 : nextOccupied(0, from);
+        quint64 next = slot >= 0 ? (currentTick & ~quint64(Slots - 1)) + quint64(slot) : rotationEnd;
+        if (next > target) {
+            currentTick = target;
+            break;
+        }
+        currentTick = next;
+
+        if ((currentTick & (Slots - 1)) == 0) {
+            // Cascade from the highest level that wrapped, so entries land in order
+            int level = 1;
+            while (level < Levels - 1 && ((currentTick >> (SlotBits * level)) & (Slots - 1)) == 0) {
+                ++level;
+            }
+            for (; level >= 1; --level) {
+                cascade(level);
+            }
+        }
+
+        const int index = int(currentTick & (Slots - 1));
+        Entry *entry = buckets[0][index];
+        buckets[0][index] = nullptr;
+        occupied[0][index / 64] &= ~(quint64(1) << (index % 64));
+        const qint64 slotNs = originNs + qint64(currentTick) * tickNs;
+        while (entry) {
+            Entry *following = entry->next;
+            if (entry->dueNs > slotNs) {
+                // Parked beyond the wheel's range; not due yet
+                entry->dueTick = currentTick + quint64((entry->dueNs - slotNs + tickNs - 1) / tickNs);
+                place(entry);
+            } else {
+                entry->level = -1;
+                entry->prev = entry->next = nullptr;
+                expired.push_back(entry);
+                --count;
+            }
+            entry = following;
+        }
+    }
+}
+
+qint64 TimerWheel::nextWakeNs() const
+{
+    const quint64 rotationEnd = (currentTick | (Slots - 1)) + 1;
+    const int from = int((currentTick + 1) & (Slots - 1));
+    const int slot = (currentTick + 1 == rotationEnd) ? -1 : nextOccupied(0, from);
+    const quint64 next = slot >= 0 ? (currentTick & ~quint64(Slots - 1)) + quint64(slot) : rotationEnd;
+    return originNs + qint64(next) * tickNs;
+}
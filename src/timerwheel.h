@@ -0,0 +1,59 @@
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <QtGlobal>
+#include <vector>
+
+// Hierarchical timing wheel: four levels of 256 slots. Insert and remove
+// are O(1); expiry visits only occupied slots (an occupancy bitmap skips
+// the empty ones), so the cost follows the number of timers that fire,
+// not the number armed. Entries never fire before their due time; they
+// fire within one tick after it.
+class TimerWheel
+{
+public:
+    struct Entry {
+        qint64 dueNs = 0;
+        // Owned by the wheel
+        quint64 dueTick = 0;
+        Entry *prev = nullptr;
+        Entry *next = nullptr;
+        int level = -1;
+        int slot = 0;
+    };
+
+    static const int Levels = 4;
+    static const int SlotBits = 8;
+    static const int Slots = 1 << SlotBits;
+
+    TimerWheel(qint64 tickNs, qint64 startNs);
+
+    void insert(Entry *entry);
+    void remove(Entry *entry);
+    bool isEmpty() const;
+
+    // Moves the wheel to nowNs and appends every entry now due
+    void advance(qint64 nowNs, std::vector<Entry *> &expired);
+
+    // Earliest time advance() can return something; a lower bound when the
+    // next timer sits in a higher level and has yet to cascade down
+    qint64 nextWakeNs() const;
+
+    qint64 tick() const;
+
+private:
+    void place(Entry *entry);
+    void unlink(Entry *entry);
+    void cascade(int level);
+    int nextOccupied(int level, int from) const; // First occupied slot >= from, or -1
+
+    qint64 tickNs;
+    qint64 originNs;
+    quint64 currentTick; // Every tick <= currentTick has fired
+    int count;
+
+    Entry *buckets[Levels][Slots];
+    quint64 occupied[Levels][Slots / 64];
+};
+
+#endif // TIMERWHEEL_H
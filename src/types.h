@@ -2,12 +2,58 @@
 #define TYPES_H
 
 #include <QPoint>
+#include <QRect>
+#include <QString>
+#include <QVector>
 
 enum class ClickType {
     LeftClick,
     RightClick,
     MiddleClick,
-    DoubleClick
+    DoubleClick,
+    TripleClick,
+    ScrollUp,    // Wheel notches, X buttons 4 to 7; see ClickerThread::setScrollNotches()
+    ScrollDown,
+    ScrollLeft,
+    ScrollRight
+};
+
+// Button presses making up one click of this type
+inline int pressCount(ClickType type)
+{
+    return type == ClickType::TripleClick ? 3 : type == ClickType::DoubleClick ? 2 : 1;
+}
+
+// Scrolls have no press duration: all their notches go out as one batch
+inline bool isScroll(ClickType type)
+{
+    return type >= ClickType::ScrollUp;
+}
+
+// Press/release timing for one click. All zero sends the events back to back;
+// otherwise schedulers send down and up as separate timeline entries.
+struct ClickTiming {
+    int pressUs = 0; // Button held between down and up
+    int gapUs = 0;   // From one release to the next press of a double or triple click
+
+    bool isImmediate() const { return pressUs <= 0 && gapUs <= 0; }
+};
+
+// Click engine lifecycle. Draining is the window in which stop() waits for
+// in-flight clicks before the engine is back to Idle.
+enum class EngineState {
+    Idle,
+    Running,
+    Paused,    // Threads parked; schedule phase and click count are kept
+    Draining
+};
+
+// How ClickerThread sends pointer events on Linux; see UInputDevice
+enum class InjectionBackend {
+    XTest,          // Through the X server's request queue
+    UInputAbsolute, // Kernel virtual tablet spanning the screen
+    UInputRelative, // Kernel virtual mouse, moving by deltas
+    Discard         // Sends nothing, for simulated and dry runs
 };
 
 enum class MouseMode {
@@ -15,4 +61,93 @@ enum class MouseMode {
     Locked     // Mouse position is locked - clicks at fixed position
 };
 
+// Pointer motion between targets; see MotionPath
+enum class MotionCurve {
+    Linear,
+    Bezier,      // Cubic arc bowing to one side of the straight line
+    MinimumJerk  // Straight line with the bell-shaped speed profile of a hand movement
+};
+
+struct MotionSettings {
+    MotionCurve curve = MotionCurve::Linear;
+    int durationUs = 0;    // 0 jumps straight to the target
+    int sampleRate = 1000; // Points per second along the path
+    double curvature = 0.2; // Bezier only: control point offset as a fraction of the distance
+
+    bool isEnabled() const { return durationUs > 0; }
+};
+
+// Random spacing between clicks around the configured rate, plus slow rate
+// changes; see IntervalGenerator
+struct IntervalProfile {
+    enum Distribution {
+        Fixed,
+        Gaussian,  // Normal around the mean interval, jitter = standard deviation / mean
+        Poisson,   // Exponential intervals: clicks as a Poisson process
+        LogNormal  // Right-skewed, never below zero; jitter = standard deviation / mean
+    };
+
+    Distribution distribution = Fixed;
+    double jitter = 0.1;
+    double warmupSeconds = 0.0;       // Rate ramps linearly up to the target over this long
+    double warmupStartFraction = 0.25;
+    double waveAmplitude = 0.0;       // Sinusoidal rate modulation, as a fraction of the rate
+    double wavePeriodSeconds = 60.0;
+
+    bool isFixed() const { return distribution == Fixed && warmupSeconds <= 0.0 && waveAmplitude <= 0.0; }
+};
+
+// Keyboard action for the click engine, resolved against one display's
+// keyboard mapping by ClickerThread::resolveKeyAction(). The spec is a key
+// ("space", "F5", "a"), a chord ("ctrl+shift+t") or a string ("text:hello").
+struct KeyAction {
+    struct Stroke {
+        QVector<quint32> modifiers; // Keycodes held around the key, in press order
+        quint32 keycode = 0;
+    };
+
+    QString spec;
+    QVector<Stroke> strokes;
+
+    bool isEmpty() const { return strokes.isEmpty(); }
+
+    // Key down and up events sent per action
+    int eventCount() const
+    {
+        int events = 0;
+        for (const Stroke &stroke : strokes) events += 2 * (1 + stroke.modifiers.size());
+        return events;
+    }
+};
+
+// Pixel-triggered clicking: watch a screen region and click when it matches
+struct ScreenTrigger {
+    enum Rule {
+        PixelColor,    // Pixel equals color within tolerance per channel
+        RegionChanged, // Region differs from the baseline captured at start
+        TemplateFound  // Template image located in the region; clicks its center
+    };
+
+    Rule rule = PixelColor;
+    QRect region;               // Root-window coordinates
+    QPoint pixel;               // Relative to region, PixelColor only
+    quint32 color = 0;          // 0xRRGGBB
+    int tolerance = 0;          // Per-channel difference, PixelColor and RegionChanged
+    int minChangedPixels = 1;   // RegionChanged only
+    int matchThreshold = 16;    // Mean per-pixel difference (0-255), TemplateFound only
+    QString templateFile;       // PGM or PPM image to find, TemplateFound only
+};
+
+// Points shared with clicking threads are stored in one atomic word:
+// x in the high, y in the low 32 bits
+inline qint64 packPoint(const QPoint &pos)
+{
+    return (static_cast<qint64>(pos.x()) << 32) | static_cast<quint32>(pos.y());
+}
+
+inline QPoint unpackPoint(qint64 packed)
+{
+    return QPoint(static_cast<int>(packed >> 32), static_cast<int>(static_cast<qint32>(packed)));
+}
+
 #endif // TYPES_H 
\ No newline at end of file
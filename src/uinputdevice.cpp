@@ -0,0 +1,214 @@
+#include "uinputdevice.h"
+#include <QDebug>
+
+#if !defined(Q_OS_WIN) && !defined(Q_OS_MAC)
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/uinput.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <vector>
+
+// Reused across calls, so a click allocates nothing once it has run
+static thread_local std::vector<input_event> batch;
+
+static void append(quint16 type, quint16 code, qint32 value)
+{
+    input_event event = {};
+    event.type = type;
+    event.code = code;
+    event.value = value;
+    batch.push_back(event);
+}
+
+static void report()
+{
+    append(EV_SYN, SYN_REPORT, 0);
+}
+
+static quint16 buttonCode(ClickType type)
+{
+    return type == ClickType::RightClick ? BTN_RIGHT
+         : type == ClickType::MiddleClick ? BTN_MIDDLE
+         : BTN_LEFT;
+}
+#endif
+
+UInputDevice::UInputDevice()
+    : fd(-1)
+    , absolute(false)
+{
+}
+
+UInputDevice::~UInputDevice()
+{
+    close();
+}
+
+bool UInputDevice::isOpen() const
+{
+    return fd >= 0;
+}
+
+bool UInputDevice::isAbsolute() const
+{
+    return absolute;
+}
+
+#if !defined(Q_OS_WIN) && !defined(Q_OS_MAC)
+bool UInputDevice::open(bool absoluteAxes, const QSize &screenSize, QString *error)
+{
+    close();
+
+    auto fail = [this, error](const QString &message) {
+        if (error) *error = message + ": " + QString::fromLocal8Bit(strerror(errno));
+        close();
+        return false;
+    };
+
+    if (absoluteAxes && screenSize.isEmpty()) {
+        if (error) *error = "an absolute device needs the screen size";
+        return false;
+    }
+
+    fd = ::open("/dev/uinput", O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) return fail("cannot open /dev/uinput");
+
+    bool ok = ioctl(fd, UI_SET_EVBIT, EV_KEY) == 0 &&
+              ioctl(fd, UI_SET_KEYBIT, BTN_LEFT) == 0 &&
+              ioctl(fd, UI_SET_KEYBIT, BTN_RIGHT) == 0 &&
+              ioctl(fd, UI_SET_KEYBIT, BTN_MIDDLE) == 0 &&
+              ioctl(fd, UI_SET_EVBIT, EV_REL) == 0 &&
+              ioctl(fd, UI_SET_RELBIT, REL_WHEEL) == 0 &&
+              ioctl(fd, UI_SET_RELBIT, REL_HWHEEL) == 0;
+    if (absoluteAxes) {
+        // Buttons plus absolute axes and no pen tool: an absolute pointer to libinput
+        uinput_abs_setup axis = {};
+        ok = ok && ioctl(fd, UI_SET_EVBIT, EV_ABS) == 0;
+        axis.code = ABS_X;
+        axis.absinfo.maximum = screenSize.width() - 1;
+        ok = ok && ioctl(fd, UI_SET_ABSBIT, ABS_X) == 0 && ioctl(fd, UI_ABS_SETUP, &axis) == 0;
+        axis.code = ABS_Y;
+        axis.absinfo.maximum = screenSize.height() - 1;
+        ok = ok && ioctl(fd, UI_SET_ABSBIT, ABS_Y) == 0 && ioctl(fd, UI_ABS_SETUP, &axis) == 0;
+    } else {
+        ok = ok && ioctl(fd, UI_SET_RELBIT, REL_X) == 0 && ioctl(fd, UI_SET_RELBIT, REL_Y) == 0;
+    }
+    if (!ok) return fail("cannot configure the uinput device");
+
+    // UI_DEV_SETUP needs Linux 4.5
+    uinput_setup setup = {};
+    setup.id.bustype = BUS_VIRTUAL;
+    setup.id.vendor = 0x1209;
+    setup.id.product = absoluteAxes ? 0x6701 : 0x6702;
+    setup.id.version = 1;
+    strncpy(setup.name, absoluteAxes ? "gert virtual tablet" : "gert virtual mouse", UINPUT_MAX_NAME_SIZE - 1);
+    if (ioctl(fd, UI_DEV_SETUP, &setup) != 0 || ioctl(fd, UI_DEV_CREATE) != 0) {
+        return fail("cannot create the uinput device");
+    }
+
+    absolute = absoluteAxes;
+    screen = screenSize;
+    return true;
+}
+
+void UInputDevice::close()
+{
+    if (fd < 0) return;
+
+    ioctl(fd, UI_DEV_DESTROY);
+    ::close(fd);
+    fd = -1;
+}
+
+bool UInputDevice::appendMotion(const QPoint &pos, const QPoint &from)
+{
+    if (absolute) {
+        append(EV_ABS, ABS_X, qBound(0, pos.x(), screen.width() - 1));
+        append(EV_ABS, ABS_Y, qBound(0, pos.y(), screen.height() - 1));
+        return true;
+    }
+
+    const QPoint delta = pos - from;
+    if (delta.x()) append(EV_REL, REL_X, delta.x());
+    if (delta.y()) append(EV_REL, REL_Y, delta.y());
+    return !delta.isNull();
+}
+
+bool UInputDevice::flush()
+{
+    const ssize_t size = ssize_t(batch.size() * sizeof(input_event));
+    ssize_t written;
+    do {
+        written = ::write(fd, batch.data(), size_t(size));
+    } while (written < 0 && errno == EINTR);
+
+    batch.clear();
+    return written == size;
+}
+
+bool UInputDevice::click(const QPoint &pos, const QPoint &pointer, ClickType type, int count)
+{
+    if (fd < 0) return false;
+
+    batch.clear();
+    if (appendMotion(pos, pointer)) report();
+
+    if (isScroll(type)) {
+        // One wheel event carries every notch; positive is up and right
+        const bool horizontal = type == ClickType::ScrollLeft || type == ClickType::ScrollRight;
+        const int sign = type == ClickType::ScrollUp || type == ClickType::ScrollRight ? 1 : -1;
+        append(EV_REL, horizontal ? REL_HWHEEL : REL_WHEEL, sign * count);
+        report();
+    } else {
+        // A frame per transition, or the press and release would cancel out
+        const quint16 code = buttonCode(type);
+        for (int press = 0; press < count; ++press) {
+            append(EV_KEY, code, 1);
+            report();
+            append(EV_KEY, code, 0);
+            report();
+        }
+    }
+    return flush();
+}
+
+bool UInputDevice::button(const QPoint &pos, const QPoint &pointer, ClickType type, bool down)
+{
+    if (fd < 0) return false;
+
+    // The press moves the pointer; the release happens wherever it is
+    batch.clear();
+    if (down && appendMotion(pos, pointer)) report();
+    append(EV_KEY, buttonCode(type), down ? 1 : 0);
+    report();
+    return flush();
+}
+
+bool UInputDevice::move(const QPoint *points, int count, const QPoint &pointer)
+{
+    if (fd < 0) return false;
+
+    batch.clear();
+    QPoint from = pointer;
+    for (int i = 0; i < count; ++i) {
+        if (appendMotion(points[i], from)) report();
+        from = points[i];
+    }
+    return batch.empty() || flush();
+}
+#else
+bool UInputDevice::open(bool, const QSize &, QString *error)
+{
+    if (error) *error = "uinput is only available on Linux";
+    return false;
+}
+
+void UInputDevice::close() {}
+bool UInputDevice::appendMotion(const QPoint &, const QPoint &) { return false; }
+bool UInputDevice::flush() { return false; }
+bool UInputDevice::click(const QPoint &, const QPoint &, ClickType, int) { return false; }
+bool UInputDevice::button(const QPoint &, const QPoint &, ClickType, bool) { return false; }
+bool UInputDevice::move(const QPoint *, int, const QPoint &) { return false; }
+#endif
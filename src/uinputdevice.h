@@ -0,0 +1,49 @@
+#ifndef UINPUTDEVICE_H
+#define UINPUTDEVICE_H
+
+#include <QPoint>
+#include <QSize>
+#include <QString>
+#include "types.h"
+
+// A virtual pointer created through /dev/uinput (Linux). Events go to the
+// kernel input layer, so they reach whatever reads evdev devices (Xorg or
+// a Wayland compositor through libinput), not an X server without input
+// devices such as Xvfb.
+//
+// Each call builds its input_event array in a per-thread buffer and sends
+// it with a single write(); the kernel applies one write atomically, so
+// several clicking threads can share one device without a lock.
+//
+// An absolute device is a tablet whose axes span the screen size given to
+// open(), like a virtual machine's tablet. A relative device is a mouse:
+// it moves by the distance from the current pointer position, which lands
+// exactly only with a flat pointer acceleration profile.
+class UInputDevice
+{
+public:
+    UInputDevice();
+    ~UInputDevice();
+
+    bool open(bool absolute, const QSize &screen, QString *error = nullptr);
+    void close();
+    bool isOpen() const;
+    bool isAbsolute() const;
+
+    // pointer is where the pointer is now; relative devices move from there
+    // to pos, absolute ones ignore it. count is the presses of a click or
+    // the notches of a scroll.
+    bool click(const QPoint &pos, const QPoint &pointer, ClickType type, int count);
+    bool button(const QPoint &pos, const QPoint &pointer, ClickType type, bool down);
+    bool move(const QPoint *points, int count, const QPoint &pointer);
+
+private:
+    bool appendMotion(const QPoint &pos, const QPoint &from);
+    bool flush();
+
+    int fd;
+    bool absolute;
+    QSize screen;
+};
+
+#endif // UINPUTDEVICE_H
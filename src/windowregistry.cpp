@@ -0,0 +1,403 @@
+#include "windowregistry.h"
+#include <QDebug>
+#include <QMutexLocker>
+#include <QSocketNotifier>
+
+#if !defined(Q_OS_WIN) && !defined(Q_OS_MAC)
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+#include <X11/Xutil.h>
+#endif
+
+WindowRegistry::WindowRegistry(QObject *parent)
+    : QObject(parent)
+    , display(nullptr)
+    , root(0)
+    , netWmName(0)
+    , utf8String(0)
+    , notifier(nullptr)
+    , targetWindow(0)
+    , targetSet(false)
+    , targetMappedFlag(false)
+    , targetOriginPacked(0)
+{
+}
+
+WindowRegistry::~WindowRegistry()
+{
+    stop();
+}
+
+#if !defined(Q_OS_WIN) && !defined(Q_OS_MAC)
+// Windows can vanish between an event and the follow-up property fetch;
+// those BadWindow errors are expected and must not abort the process. The
+// handler is process-wide, so it is only installed around our own requests.
+static int ignoreXErrors(Display *, XErrorEvent *)
+{
+    return 0;
+}
+#endif
+
+bool WindowRegistry::start()
+{
+    if (display) return true;
+
+#ifdef Q_OS_WIN
+    return false;
+#elif defined(Q_OS_MAC)
+    return false;
+#else
+    display = XOpenDisplay(nullptr);
+    if (!display) return false;
+
+    root = DefaultRootWindow(display);
+    netWmName = XInternAtom(display, "_NET_WM_NAME", False);
+    utf8String = XInternAtom(display, "UTF8_STRING", False);
+
+    // Select before scanning so nothing created in between is missed
+    XErrorHandler previousHandler = XSetErrorHandler(ignoreXErrors);
+    XSelectInput(display, root, SubstructureNotifyMask);
+    scan();
+    XSync(display, False);
+    XSetErrorHandler(previousHandler);
+
+    notifier = new QSocketNotifier(ConnectionNumber(display), QSocketNotifier::Read, this);
+    connect(notifier, &QSocketNotifier::activated, this, &WindowRegistry::processXEvents);
+
+    // Drain anything that queued up during the scan
+    processXEvents();
+    return true;
+#endif
+}
+
+void WindowRegistry::stop()
+{
+    if (!display) return;
+
+    delete notifier;
+    notifier = nullptr;
+
+#if !defined(Q_OS_WIN) && !defined(Q_OS_MAC)
+    XCloseDisplay(display);
+#endif
+    display = nullptr;
+
+    QMutexLocker locker(&mutex);
+    windows.clear();
+    byClass.clear();
+    byTitle.clear();
+    clientToFrame.clear();
+    targetWindow = 0;
+    targetMappedFlag.store(false);
+}
+
+bool WindowRegistry::isActive() const
+{
+    return display != nullptr;
+}
+
+bool WindowRegistry::lookup(const QString &match, WindowInfo *info) const
+{
+    QMutexLocker locker(&mutex);
+
+    unsigned long window = byClass.value(match, 0);
+    if (!window) window = byTitle.value(match, 0);
+    if (!window) return false;
+
+    if (info) *info = windows.value(window);
+    return true;
+}
+
+void WindowRegistry::setTarget(const QString &match)
+{
+    {
+        QMutexLocker locker(&mutex);
+        targetMatch = match;
+    }
+    targetSet.store(!match.isEmpty());
+
+    if (!match.isEmpty() && !display) {
+        if (!start()) {
+            qWarning() << "WindowRegistry: window tracking unavailable on this platform";
+        }
+    }
+
+    refreshTarget();
+}
+
+QString WindowRegistry::target() const
+{
+    QMutexLocker locker(&mutex);
+    return targetMatch;
+}
+
+bool WindowRegistry::hasTarget() const
+{
+    return targetSet.load(std::memory_order_relaxed);
+}
+
+bool WindowRegistry::isTargetMapped() const
+{
+    return targetMappedFlag.load(std::memory_order_acquire);
+}
+
+QPoint WindowRegistry::targetOrigin() const
+{
+    return unpackPoint(targetOriginPacked.load(std::memory_order_relaxed));
+}
+
+void WindowRegistry::refreshTarget()
+{
+    WindowInfo info;
+    bool found = false;
+    {
+        QMutexLocker locker(&mutex);
+        unsigned long window = 0;
+        if (!targetMatch.isEmpty()) {
+            window = byClass.value(targetMatch, 0);
+            if (!window) window = byTitle.value(targetMatch, 0);
+        }
+        targetWindow = window;
+        if (window) {
+            info = windows.value(window);
+            found = true;
+        }
+    }
+
+    const bool wasMapped = targetMappedFlag.load();
+    const bool nowMapped = found && info.mapped;
+
+    if (found) {
+        targetOriginPacked.store(packPoint(info.geometry.topLeft()), std::memory_order_relaxed);
+    }
+    targetMappedFlag.store(nowMapped, std::memory_order_release);
+
+    if (nowMapped && !wasMapped) {
+        emit targetMapped(info.geometry);
+    } else if (!nowMapped && wasMapped) {
+        emit targetUnmapped();
+    }
+}
+
+#if !defined(Q_OS_WIN) && !defined(Q_OS_MAC)
+void WindowRegistry::scan()
+{
+    Window rootReturn, parentReturn;
+    Window *children = nullptr;
+    unsigned int count = 0;
+
+    if (!XQueryTree(display, root, &rootReturn, &parentReturn, &children, &count)) return;
+
+    for (unsigned int i = 0; i < count; ++i) {
+        trackWindow(children[i]);
+    }
+
+    if (children) XFree(children);
+}
+
+// Reparenting window managers put the WM_CLASS on a child of the frame;
+// look one level down when the top-level itself carries none.
+static Window findClient(Display *display, Window window)
+{
+    XClassHint hint;
+    if (XGetClassHint(display, window, &hint)) {
+        XFree(hint.res_name);
+        XFree(hint.res_class);
+        return window;
+    }
+
+    Window rootReturn, parentReturn;
+    Window *children = nullptr;
+    unsigned int count = 0;
+    Window client = window;
+
+    if (XQueryTree(display, window, &rootReturn, &parentReturn, &children, &count)) {
+        for (unsigned int i = 0; i < count; ++i) {
+            if (XGetClassHint(display, children[i], &hint)) {
+                XFree(hint.res_name);
+                XFree(hint.res_class);
+                client = children[i];
+                break;
+            }
+        }
+        if (children) XFree(children);
+    }
+
+    return client;
+}
+
+void WindowRegistry::trackWindow(unsigned long window)
+{
+    XWindowAttributes attributes;
+    if (!XGetWindowAttributes(display, window, &attributes)) return;
+    if (attributes.override_redirect) return; // Menus, tooltips, popups
+
+    WindowInfo info;
+    info.id = window;
+    info.client = findClient(display, window);
+    info.geometry = QRect(attributes.x, attributes.y, attributes.width, attributes.height);
+    info.mapped = attributes.map_state == IsViewable;
+
+    XSelectInput(display, info.client, PropertyChangeMask);
+    refreshProperties(info);
+
+    QMutexLocker locker(&mutex);
+    if (windows.contains(window)) {
+        const WindowInfo old = windows.value(window);
+        unindexWindow(old);
+        clientToFrame.remove(old.client);
+    }
+    windows.insert(window, info);
+    clientToFrame.insert(info.client, window);
+    indexWindow(info);
+}
+
+void WindowRegistry::untrackWindow(unsigned long window)
+{
+    QMutexLocker locker(&mutex);
+    if (!windows.contains(window)) return;
+
+    const WindowInfo info = windows.take(window);
+    clientToFrame.remove(info.client);
+    unindexWindow(info);
+}
+
+void WindowRegistry::refreshProperties(WindowInfo &info)
+{
+    XClassHint hint;
+    if (XGetClassHint(display, info.client, &hint)) {
+        info.wmClass = QString::fromLocal8Bit(hint.res_class ? hint.res_class : "");
+        XFree(hint.res_name);
+        XFree(hint.res_class);
+    }
+
+    // Prefer the UTF-8 EWMH title, fall back to the legacy WM_NAME
+    Atom actualType;
+    int actualFormat;
+    unsigned long itemCount, bytesAfter;
+    unsigned char *data = nullptr;
+
+    if (XGetWindowProperty(display, info.client, netWmName, 0, 1024, False, utf8String,
+                           &actualType, &actualFormat, &itemCount, &bytesAfter, &data) == Success && data) {
+        info.title = QString::fromUtf8(reinterpret_cast<const char *>(data), static_cast<int>(itemCount));
+        XFree(data);
+        return;
+    }
+
+    char *name = nullptr;
+    if (XFetchName(display, info.client, &name) && name) {
+        info.title = QString::fromLocal8Bit(name);
+        XFree(name);
+    }
+}
+
+void WindowRegistry::indexWindow(const WindowInfo &info)
+{
+    if (!info.wmClass.isEmpty()) byClass.insert(info.wmClass, info.id);
+    if (!info.title.isEmpty()) byTitle.insert(info.title, info.id);
+}
+
+void WindowRegistry::unindexWindow(const WindowInfo &info)
+{
+    if (byClass.value(info.wmClass, 0) == info.id) byClass.remove(info.wmClass);
+    if (byTitle.value(info.title, 0) == info.id) byTitle.remove(info.title);
+}
+
+void WindowRegistry::processXEvents()
+{
+    if (!display) return;
+
+    bool targetDirty = false;
+
+    XErrorHandler previousHandler = XSetErrorHandler(ignoreXErrors);
+    do {
+        while (XPending(display)) {
+            XEvent event;
+            XNextEvent(display, &event);
+
+            switch (event.type) {
+            case CreateNotify:
+                if (event.xcreatewindow.parent == root) {
+                    trackWindow(event.xcreatewindow.window);
+                }
+                break;
+            case DestroyNotify:
+                untrackWindow(event.xdestroywindow.window);
+                targetDirty = true;
+                break;
+            case ReparentNotify:
+                if (event.xreparent.parent == root) {
+                    trackWindow(event.xreparent.window);
+                } else {
+                    untrackWindow(event.xreparent.window);
+                }
+                targetDirty = true;
+                break;
+            case MapNotify:
+                // The WM reparents the client into its frame before mapping it,
+                // so this is the point where the frame's client is known.
+                if (event.xmap.event == root) {
+                    trackWindow(event.xmap.window);
+                    targetDirty = true;
+                }
+                break;
+            case UnmapNotify:
+                if (event.xunmap.event == root) {
+                    QMutexLocker locker(&mutex);
+                    if (windows.contains(event.xunmap.window)) {
+                        WindowInfo info = windows.value(event.xunmap.window);
+                        info.mapped = false;
+                        windows.insert(event.xunmap.window, info);
+                        targetDirty = true;
+                    }
+                }
+                break;
+            case ConfigureNotify:
+                if (event.xconfigure.event == root) {
+                    QMutexLocker locker(&mutex);
+                    if (windows.contains(event.xconfigure.window)) {
+                        WindowInfo info = windows.value(event.xconfigure.window);
+                        info.geometry = QRect(event.xconfigure.x, event.xconfigure.y,
+                                              event.xconfigure.width, event.xconfigure.height);
+                        windows.insert(event.xconfigure.window, info);
+                        targetDirty = true;
+                    }
+                }
+                break;
+            case PropertyNotify: {
+                const unsigned long frame = clientToFrame.value(event.xproperty.window, 0);
+                if (!frame) break;
+
+                WindowInfo info = windows.value(frame);
+                refreshProperties(info);
+
+                QMutexLocker locker(&mutex);
+                unindexWindow(windows.value(frame));
+                windows.insert(frame, info);
+                indexWindow(info);
+                targetDirty = true;
+                break;
+            }
+            default:
+                break;
+            }
+        }
+        // Errors from the fetches above arrive before the handler goes back;
+        // events the sync queued are read here, the socket will not signal them
+        XSync(display, False);
+    } while (XQLength(display));
+    XSetErrorHandler(previousHandler);
+
+    if (targetDirty && hasTarget()) {
+        refreshTarget();
+    }
+}
+#else
+void WindowRegistry::scan() {}
+void WindowRegistry::trackWindow(unsigned long) {}
+void WindowRegistry::untrackWindow(unsigned long) {}
+void WindowRegistry::refreshProperties(WindowInfo &) {}
+void WindowRegistry::indexWindow(const WindowInfo &) {}
+void WindowRegistry::unindexWindow(const WindowInfo &) {}
+void WindowRegistry::processXEvents() {}
+#endif
@@ -0,0 +1,86 @@
+#ifndef WINDOWREGISTRY_H
+#define WINDOWREGISTRY_H
+
+#include <QObject>
+#include <QHash>
+#include <QMutex>
+#include <QPoint>
+#include <QRect>
+#include <QString>
+#include <atomic>
+#include "types.h"
+
+class QSocketNotifier;
+struct _XDisplay;
+
+struct WindowInfo {
+    unsigned long id = 0;     // Top-level (frame) window
+    unsigned long client = 0; // Child carrying WM_CLASS / title
+    QString wmClass;
+    QString title;
+    QRect geometry;
+    bool mapped = false;
+};
+
+// Tracks top-level windows incrementally so click targets resolve without
+// walking the window tree. One XQueryTree scan on start, then everything is
+// driven by SubstructureNotify on the root and PropertyNotify on clients.
+class WindowRegistry : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit WindowRegistry(QObject *parent = nullptr);
+    ~WindowRegistry();
+
+    bool start();
+    void stop();
+    bool isActive() const;
+
+    bool lookup(const QString &match, WindowInfo *info) const;
+
+    // Target used by the click engine; match is a WM_CLASS name or exact title
+    void setTarget(const QString &match);
+    QString target() const;
+    bool hasTarget() const;
+    bool isTargetMapped() const;
+    QPoint targetOrigin() const;
+
+signals:
+    void targetMapped(const QRect &geometry);
+    void targetUnmapped();
+
+private slots:
+    void processXEvents();
+
+private:
+    void scan();
+    void trackWindow(unsigned long window);
+    void untrackWindow(unsigned long window);
+    void refreshProperties(WindowInfo &info);
+    void indexWindow(const WindowInfo &info);
+    void unindexWindow(const WindowInfo &info);
+    void refreshTarget();
+
+    _XDisplay *display;
+    unsigned long root;
+    unsigned long netWmName;  // Atoms of this display, interned on open
+    unsigned long utf8String;
+    QSocketNotifier *notifier;
+
+    // Window maps are only written from the owning thread; the mutex guards
+    // lookups made from other threads.
+    mutable QMutex mutex;
+    QHash<unsigned long, WindowInfo> windows;
+    QHash<QString, unsigned long> byClass;
+    QHash<QString, unsigned long> byTitle;
+    QHash<unsigned long, unsigned long> clientToFrame;
+
+    QString targetMatch;
+    unsigned long targetWindow;
+    std::atomic<bool> targetSet;
+    std::atomic<bool> targetMappedFlag;
+    std::atomic<qint64> targetOriginPacked; // x in the high, y in the low 32 bits
+};
+
+#endif // WINDOWREGISTRY_H
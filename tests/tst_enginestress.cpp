@@ -0,0 +1,133 @@
+// Hammers AutoClicker's control surface from several threads at once:
+// start, stop, pause, resume, burst and rate changes in random order while
+// the rapid loop clicks. Meant to run under ThreadSanitizer
+// (-DGERT_TSAN=ON); without it, it still checks that nothing deadlocks,
+// that the engine settles to Idle with no clicks after stop(), and that a
+// burst sends exactly its clicks.
+//
+// DISPLAY is cleared first, so the clicks go nowhere.
+
+#include "autoclicker.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <atomic>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <thread>
+#include <vector>
+
+static bool waitFor(const std::function<bool()> &condition, int timeoutMs)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!condition()) {
+        if (timer.elapsed() > timeoutMs) return false;
+        // Bursts hand their stop() to this thread
+        QCoreApplication::processEvents();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+// Runs the event loop for this long
+static void spin(int ms)
+{
+    waitFor([]() { return false; }, ms);
+}
+
+int main(int argc, char **argv)
+{
+    qunsetenv("DISPLAY");
+    QCoreApplication app(argc, argv);
+
+    AutoClicker clicker;
+    clicker.setClickPosition(QPoint(5, 5));
+    clicker.setClicksPerSecond(2000);
+
+    const int threadCount = 4;
+    const int secondsToRun = 3;
+    std::atomic<bool> done(false);
+    std::atomic<quint64> operations(0);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t]() {
+            std::mt19937 random(1000u + quint32(t));
+            while (!done.load()) {
+                switch (random() % 8) {
+                case 0:
+                case 1:
+                    clicker.start(random() % 2);
+                    break;
+                case 2:
+                    clicker.stop();
+                    break;
+                case 3:
+                    clicker.pause();
+                    break;
+                case 4:
+                    clicker.resume();
+                    break;
+                case 5:
+                    clicker.burst(1 + int(random() % 200));
+                    break;
+                case 6:
+                    clicker.setClicksPerSecond(1 + int(random() % 10000));
+                    break;
+                default:
+                    clicker.state();
+                    clicker.isPaused();
+                    clicker.getClickCount();
+                    break;
+                }
+                operations.fetch_add(1);
+                std::this_thread::sleep_for(std::chrono::microseconds(random() % 500));
+            }
+        });
+    }
+
+    spin(secondsToRun * 1000);
+    done.store(true);
+    for (std::thread &thread : threads) thread.join();
+
+    int failures = 0;
+    auto check = [&failures](bool ok, const char *what) {
+        if (!ok) {
+            std::fprintf(stderr, "FAIL: %s\n", what);
+            ++failures;
+        }
+    };
+
+    // Settles to Idle, and nothing clicks after stop() has returned
+    clicker.stop();
+    spin(20); // Queued burst stops run and find nothing to stop
+    check(clicker.state() == EngineState::Idle, "engine idle after stop()");
+    const int stoppedAt = clicker.getClickCount();
+    spin(50);
+    check(clicker.getClickCount() == stoppedAt, "no clicks after stop()");
+
+    // A burst sends exactly its clicks and stops by itself
+    clicker.setClicksPerSecond(5000);
+    check(clicker.burst(250), "burst accepted when idle");
+    check(waitFor([&]() { return clicker.state() == EngineState::Idle; }, 5000), "burst stops by itself");
+    check(clicker.getClickCount() == 250, "burst sends exactly its clicks");
+
+    // Pausing holds the count, resuming continues
+    clicker.setClicksPerSecond(1000);
+    clicker.start();
+    check(waitFor([&]() { return clicker.getClickCount() > 10; }, 5000), "clicks while running");
+    check(clicker.pause(), "pause() while running");
+    spin(10); // A click that passed the state check before the pause still lands
+    const int pausedAt = clicker.getClickCount();
+    spin(50);
+    check(clicker.getClickCount() == pausedAt, "no clicks while paused");
+    check(clicker.resume(), "resume() while paused");
+    check(waitFor([&]() { return clicker.getClickCount() > pausedAt; }, 5000), "clicks after resume()");
+    clicker.stop();
+    check(clicker.state() == EngineState::Idle, "idle after the last stop()");
+
+    std::printf("%llu operations from %d threads, %d failures\n",
+                static_cast<unsigned long long>(operations.load()), threadCount, failures);
+    return failures ? 1 : 0;
+}
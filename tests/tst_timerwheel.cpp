@@ -0,0 +1,141 @@
+// Randomised check of TimerWheel against a reference set of armed timers:
+// inserts (near, far, past and beyond the wheel's range), removals and
+// advances by small and large steps. No entry may fire before the tick
+// boundary at or after its due time, be lost, or fire more than one tick
+// late, and nextWakeNs() must never be later than the next expiry.
+
+#include "timerwheel.h"
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+struct Timer {
+    TimerWheel::Entry entry;
+    qint64 effectiveDueNs = 0; // Due time, or the wheel's time if armed in the past
+    bool armed = false;
+    bool fired = false;
+};
+
+int failures = 0;
+
+void fail(const char *what, qint64 nowNs, qint64 dueNs)
+{
+    if (++failures <= 10) {
+        std::fprintf(stderr, "FAIL: %s (now %lld ns, due %lld ns)\n", what, nowNs, dueNs);
+    }
+}
+
+} // namespace
+
+int main()
+{
+    const qint64 tickNs = 100000;
+    const qint64 startNs = 1000000000;
+    const int rounds = 200000;
+
+    std::mt19937_64 random(0x6765727477686c31ull);
+    TimerWheel wheel(tickNs, startNs);
+    std::vector<std::unique_ptr<Timer>> timers;
+    std::vector<TimerWheel::Entry *> expired;
+    qint64 nowNs = startNs;
+    qint64 wheelNs = startNs; // Time of the last advance
+    quint64 fired = 0;
+    quint64 removed = 0;
+    int armed = 0;
+
+    auto randomBelow = [&random](qint64 bound) { return qint64(random() % quint64(bound)); };
+    // Last tick boundary the wheel has reached at nowNs
+    auto boundaryNs = [=](qint64 nowNs) { return startNs + (nowNs - startNs) / tickNs * tickNs; };
+
+    for (int round = 0; round < rounds; ++round) {
+        const int action = int(random() % 100);
+
+        if (action < 45) {
+            // Mostly within a few rotations, some far out, some already due
+            std::unique_ptr<Timer> timer(new Timer);
+            const int range = int(random() % 100);
+            qint64 offset;
+            if (range < 60) offset = randomBelow(256 * tickNs);
+            else if (range < 85) offset = randomBelow(65536 * tickNs);
+            else if (range < 93) offset = randomBelow(qint64(1) << 40);
+            else if (range < 97) offset = (qint64(1) << 32) * tickNs + randomBelow(qint64(1) << 30);
+            else offset = -randomBelow(10 * tickNs);
+            timer->entry.dueNs = nowNs + offset;
+            timer->effectiveDueNs = qMax(timer->entry.dueNs, wheelNs);
+            timer->armed = true;
+            wheel.insert(&timer->entry);
+            timers.push_back(std::move(timer));
+            ++armed;
+        } else if (action < 60 && armed) {
+            // Remove a random armed timer
+            for (int tries = 0; tries < 8; ++tries) {
+                Timer *timer = timers[size_t(random() % timers.size())].get();
+                if (!timer->armed) continue;
+                wheel.remove(&timer->entry);
+                timer->armed = false;
+                --armed;
+                ++removed;
+                break;
+            }
+        } else {
+            // Mostly short steps, sometimes whole rotations or more
+            const int step = int(random() % 100);
+            const qint64 nextNs = nowNs + (step < 80 ? randomBelow(4 * tickNs)
+                                          : step < 97 ? randomBelow(300 * tickNs)
+                                          : randomBelow(70000 * tickNs));
+            const qint64 wakeNs = wheel.nextWakeNs();
+
+            expired.clear();
+            wheel.advance(nextNs, expired);
+            nowNs = wheelNs = nextNs;
+
+            if (!expired.empty() && nowNs < wakeNs) fail("expiry before nextWakeNs()", nowNs, wakeNs);
+
+            for (TimerWheel::Entry *entry : expired) {
+                Timer *timer = reinterpret_cast<Timer *>(entry);
+                if (!timer->armed) fail("removed or fired timer fired", nowNs, entry->dueNs);
+                if (entry->dueNs > boundaryNs(nowNs)) fail("fired early", nowNs, entry->dueNs);
+                timer->armed = false;
+                timer->fired = true;
+                --armed;
+                ++fired;
+            }
+        }
+
+        // Anything a whole tick overdue must have fired by now
+        if (round % 1000 == 0 || round == rounds - 1) {
+            for (const auto &timer : timers) {
+                if (timer->armed && timer->effectiveDueNs + tickNs <= wheelNs) {
+                    fail("overdue by more than a tick", wheelNs, timer->entry.dueNs);
+                }
+            }
+        }
+    }
+
+    // Drain: everything still armed fires, and nothing else
+    qint64 lastDueNs = nowNs;
+    for (const auto &timer : timers) {
+        if (timer->armed) lastDueNs = qMax(lastDueNs, timer->effectiveDueNs);
+    }
+    while (!wheel.isEmpty() && nowNs <= lastDueNs + tickNs) {
+        nowNs = qMax(nowNs + tickNs, qMin(wheel.nextWakeNs(), lastDueNs + tickNs));
+        expired.clear();
+        wheel.advance(nowNs, expired);
+        for (TimerWheel::Entry *entry : expired) {
+            Timer *timer = reinterpret_cast<Timer *>(entry);
+            if (!timer->armed) fail("removed or fired timer fired", nowNs, entry->dueNs);
+            if (entry->dueNs > boundaryNs(nowNs)) fail("fired early", nowNs, entry->dueNs);
+            timer->armed = false;
+            --armed;
+            ++fired;
+        }
+    }
+    if (armed != 0 || !wheel.isEmpty()) fail("timers lost", nowNs, lastDueNs);
+
+    std::printf("%zu timers: %llu fired, %llu removed, %d failures\n",
+                timers.size(), fired, removed, failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,100 @@
+/*
+ * Latency benchmark for the shared-memory target feed.
+ *
+ * Start the auto-clicker with the feed enabled and running, then:
+ *
+ *     gert-feed-bench [-n count] [-r rate] [-x x] [-y y] [-d deadline-ms] [name]
+ *
+ * Pushes count targets at rate Hz and reports producer-write to
+ * injected-click latency as measured by the consumer.
+ */
+
+#include "gertfeed.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static void sleep_until(uint64_t when_ns)
+{
+    struct timespec ts;
+    ts.tv_sec = (time_t)(when_ns / 1000000000u);
+    ts.tv_nsec = (long)(when_ns % 1000000000u);
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+}
+
+int main(int argc, char **argv)
+{
+    const char *name = GERT_FEED_DEFAULT_NAME;
+    long count = 2000;
+    long rate = 500;
+    long x = 100;
+    long y = 100;
+    long deadline_ms = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (argv[i][0] == '-' && i + 1 < argc) {
+            const long value = strtol(argv[i + 1], NULL, 10);
+            switch (argv[i][1]) {
+            case 'n': count = value; break;
+            case 'r': rate = value; break;
+            case 'x': x = value; break;
+            case 'y': y = value; break;
+            case 'd': deadline_ms = value; break;
+            default:
+                fprintf(stderr, "unknown option %s\n", argv[i]);
+                return 2;
+            }
+            ++i;
+        } else {
+            name = argv[i];
+        }
+    }
+    if (count <= 0 || rate <= 0) {
+        fprintf(stderr, "count and rate must be positive\n");
+        return 2;
+    }
+
+    gert_feed_ring *ring = gert_feed_attach(name);
+    if (!ring) {
+        fprintf(stderr, "cannot attach to %s; is the auto-clicker running with the feed enabled?\n", name);
+        return 1;
+    }
+
+    /* Baseline the consumer's counters; the max is reset for this run */
+    const uint64_t clicked0 = __atomic_load_n(&ring->clicked, __ATOMIC_RELAXED);
+    const uint64_t expired0 = __atomic_load_n(&ring->expired, __ATOMIC_RELAXED);
+    const uint64_t dropped0 = __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+    const uint64_t total0 = __atomic_load_n(&ring->latency_total_ns, __ATOMIC_RELAXED);
+    __atomic_store_n(&ring->latency_max_ns, 0, __ATOMIC_RELAXED);
+
+    const uint64_t period = 1000000000u / (uint64_t)rate;
+    const uint64_t start = gert_feed_now_ns();
+    for (long i = 0; i < count; ++i) {
+        const uint64_t due = start + (uint64_t)i * period;
+        sleep_until(due);
+        gert_feed_push(ring, (int32_t)x, (int32_t)y, GERT_FEED_BUTTON_DEFAULT,
+                       deadline_ms > 0 ? due + (uint64_t)deadline_ms * 1000000u : 0);
+    }
+
+    /* Let the consumer drain, up to one second */
+    const uint64_t give_up = gert_feed_now_ns() + 1000000000u;
+    while (__atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) != ring->head && gert_feed_now_ns() < give_up) {
+        sleep_until(gert_feed_now_ns() + 1000000u);
+    }
+
+    const uint64_t clicked = __atomic_load_n(&ring->clicked, __ATOMIC_RELAXED) - clicked0;
+    const uint64_t expired = __atomic_load_n(&ring->expired, __ATOMIC_RELAXED) - expired0;
+    const uint64_t dropped = __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED) - dropped0;
+    const uint64_t total = __atomic_load_n(&ring->latency_total_ns, __ATOMIC_RELAXED) - total0;
+    const uint64_t max = __atomic_load_n(&ring->latency_max_ns, __ATOMIC_RELAXED);
+
+    printf("pushed %ld at %ld Hz: clicked %llu, expired %llu, dropped %llu\n",
+           count, rate, (unsigned long long)clicked, (unsigned long long)expired,
+           (unsigned long long)dropped);
+    if (clicked) {
+        printf("write-to-click latency: mean %.1f us, max %.1f us\n",
+               total / 1000.0 / clicked, max / 1000.0);
+    }
+
+    gert_feed_detach(ring);
+    return clicked ? 0 : 1;
+}
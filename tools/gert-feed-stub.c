@@ -0,0 +1,98 @@
+/*
+ * Stand-in consumer for the shared-memory target feed.
+ *
+ *     gert-feed-stub [-t seconds] [name]
+ *
+ * Creates the ring and consumes it the way the auto-clicker does (futex
+ * wait, deadline check, consumer counters) but injects nothing, so
+ * gert-feed-bench can measure the feed's own write-to-consume latency
+ * without an X server. Runs until interrupted or for -t seconds.
+ */
+
+#include "gertfeed.h"
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static volatile sig_atomic_t running = 1;
+
+static void stop(int signal)
+{
+    (void)signal;
+    running = 0;
+}
+
+static int is_empty(gert_feed_ring *ring)
+{
+    return __atomic_load_n(&ring->head, __ATOMIC_SEQ_CST) == ring->tail;
+}
+
+/* Same protocol as TargetFeed::wait() */
+static void wait_for_push(gert_feed_ring *ring, long timeout_ms)
+{
+    const uint32_t seen = __atomic_load_n(&ring->doorbell, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&ring->sleeping, 1, __ATOMIC_SEQ_CST);
+    if (is_empty(ring)) {
+        struct timespec timeout;
+        timeout.tv_sec = timeout_ms / 1000;
+        timeout.tv_nsec = (timeout_ms % 1000) * 1000000L;
+        syscall(SYS_futex, &ring->doorbell, FUTEX_WAIT, seen, &timeout, NULL, 0);
+    }
+    __atomic_store_n(&ring->sleeping, 0, __ATOMIC_RELAXED);
+}
+
+int main(int argc, char **argv)
+{
+    const char *name = GERT_FEED_DEFAULT_NAME;
+    long seconds = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (argv[i][0] == '-' && argv[i][1] == 't' && i + 1 < argc) {
+            seconds = strtol(argv[++i], NULL, 10);
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        } else {
+            name = argv[i];
+        }
+    }
+
+    gert_feed_ring *ring = gert_feed_map(name, 1);
+    if (!ring) {
+        /* EEXIST: another consumer has it, or one exited without unlinking */
+        fprintf(stderr, "cannot create %s: %s\n", name, strerror(errno));
+        return 1;
+    }
+
+    signal(SIGINT, stop);
+    signal(SIGTERM, stop);
+
+    const uint64_t end = seconds > 0 ? gert_feed_now_ns() + (uint64_t)seconds * 1000000000u : 0;
+    while (running && (!end || gert_feed_now_ns() < end)) {
+        if (is_empty(ring)) {
+            wait_for_push(ring, 100);
+            continue;
+        }
+
+        const gert_feed_record *record = &ring->records[ring->tail & (GERT_FEED_CAPACITY - 1)];
+        const uint64_t now = gert_feed_now_ns();
+        if (record->deadline_ns && now > record->deadline_ns) {
+            __atomic_store_n(&ring->expired, ring->expired + 1, __ATOMIC_RELAXED);
+        } else {
+            const uint64_t latency = now - record->produced_ns;
+            __atomic_store_n(&ring->clicked, ring->clicked + 1, __ATOMIC_RELAXED);
+            __atomic_store_n(&ring->latency_total_ns, ring->latency_total_ns + latency, __ATOMIC_RELAXED);
+            if (latency > ring->latency_max_ns) {
+                __atomic_store_n(&ring->latency_max_ns, latency, __ATOMIC_RELAXED);
+            }
+        }
+        __atomic_store_n(&ring->tail, ring->tail + 1, __ATOMIC_RELEASE);
+    }
+
+    printf("consumed %llu, expired %llu\n",
+           (unsigned long long)ring->clicked, (unsigned long long)ring->expired);
+    munmap(ring, sizeof(gert_feed_ring));
+    shm_unlink(name);
+    return 0;
+}